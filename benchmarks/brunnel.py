@@ -2,10 +2,14 @@ import random
 
 import nest
 
-nest.Install("stdpmodule")
+try:
+    nest.Install("stdpmodule")
+except nest.NESTError:
+    pass # already installed by an importer (e.g. tests/test_performance.py)
 nest.set_verbosity("M_WARNING")
 
-def bench(config, order):
+def build(config, order):
+    """Build the network of the given config and order, return its neurons and simulation time."""
 
     simtime = 1000
     dt = 1.0
@@ -166,11 +170,16 @@ def bench(config, order):
     else:
         raise Exception('unknown config')
 
-    nest.Simulate(simtime)
-
     #print nest.GetStatus(espikes, "n_events")[0]
     #print nest.GetStatus(ispikes, "n_events")[0]
 
+    return nodes_ex + nodes_in, simtime
+
+def bench(config, order):
+
+    neurons, simtime = build(config, order)
+    nest.Simulate(simtime)
+
 if __name__ == '__main__':
     import timeit
 
@@ -0,0 +1,94 @@
+"""
+Creation time and memory fragmentation of STDP nodes at scale.
+
+    python creation.py --nodes 1000000 3000000 10000000 --threads 4
+
+Every size runs in a fresh interpreter (`--worker`), so that the resident memory it reports is its
+own. Creation (`nest.Create`) and initialization (buffers and decay tables drawn by the first
+`nest.Simulate`) are timed separately. Memory is reported as the resident set growth next to the
+bytes accounted by GetSTDPMemory: the per-thread arenas spike buffers and decay tables are drawn
+from (reserved and used bytes, unused share) and the remainder, i.e. kernel containers, the
+history deques of archiving nodes and allocator fragmentation.
+"""
+
+import argparse
+import json
+import subprocess
+import sys
+import time
+
+def resident():
+    """Resident set size of this process in bytes."""
+    with open("/proc/self/status") as status:
+        for line in status:
+            if line.startswith("VmRSS:"):
+                return int(line.split()[1]) * 1024
+    return 0
+
+def worker(args):
+    """Create and initialize the nodes of one size, print the measures as json."""
+
+    import nest
+    nest.set_verbosity("M_WARNING")
+    nest.Install("stdpmodule")
+    nest.SetKernelStatus({ "local_num_threads": args.threads, "resolution": args.resolution })
+
+    rss = resident()
+    start = time.time()
+    nest.Create(args.model, args.worker)
+    create = time.time() - start
+    rss_create = resident()
+
+    start = time.time()
+    nest.Simulate(args.resolution)
+    init = time.time() - start
+    rss_init = resident()
+
+    memory = nest.sli_func("GetSTDPMemory")
+    print(json.dumps({
+        "nodes": args.worker,
+        "create": create,
+        "init": init,
+        "rss_create": rss_create - rss,
+        "rss": rss_init - rss,
+        "accounted": memory["bytes"],
+        "arena": memory["arena"]["bytes"],
+        "arena_used": memory["arena"]["bytes_used"],
+        "n_blocks": memory["arena"]["n_blocks"],
+    }))
+
+def report(results):
+    """Print one line per size."""
+
+    mb = 1024.0 * 1024.0
+    print("%-10s %10s %10s %12s %12s %12s %12s %8s %10s %12s" % (
+        "nodes", "create (s)", "init (s)", "us / node", "RSS (MB)", "B / node", "arena (MB)", "unused",
+        "blocks", "other (MB)"))
+    for r in results:
+        unused = 1.0 - float(r["arena_used"]) / r["arena"] if r["arena"] else 0.0
+        print("%-10d %10.2f %10.2f %12.2f %12.1f %12.1f %12.1f %7.1f%% %10d %12.1f" % (
+            r["nodes"], r["create"], r["init"], 1e6 * (r["create"] + r["init"]) / r["nodes"], r["rss"] / mb,
+            float(r["rss"]) / r["nodes"], r["arena"] / mb, 100.0 * unused, r["n_blocks"],
+            (r["rss"] - r["accounted"]) / mb))
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description = __doc__.strip().split("\n")[0])
+    parser.add_argument("--model", default = "stdp_triplet_node", choices = ["stdp_triplet_node", "stdp_longterm_node"])
+    parser.add_argument("--nodes", type = int, nargs = "+", default = [1000000, 3000000, 10000000])
+    parser.add_argument("--threads", type = int, default = 1)
+    parser.add_argument("--resolution", type = float, default = 0.1)
+    parser.add_argument("--worker", type = int, help = argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.worker:
+        worker(args)
+        sys.exit(0)
+
+    results = []
+    for n in args.nodes:
+        command = [sys.executable, __file__, "--worker", str(n), "--model", args.model,
+                   "--threads", str(args.threads), "--resolution", str(args.resolution)]
+        output = subprocess.check_output(command).decode().strip().split("\n")
+        results.append(json.loads(output[-1]))
+
+    report(results)
@@ -1,12 +1,15 @@
 import nest
 import numpy as np
 
-nest.Install("stdpmodule")
+try:
+    nest.Install("stdpmodule")
+except nest.NESTError:
+    pass # already installed by an importer (e.g. tests/test_performance.py)
 nest.set_verbosity("M_WARNING")
 
-def bench(config, resolution):
+def build(config, resolution, elements = 1000, threads = 10):
+    """Build the network of the given config, return its neurons and simulation time."""
 
-    elements = 1000
     duration = 1000 # ms
     weight = 1.0
     delay = 2.0
@@ -19,7 +22,7 @@ def bench(config, resolution):
         nest.Connect(gen, neurons, syn_spec = { "delay": delay })
 
     nest.ResetKernel()
-    nest.SetKernelStatus({"resolution": resolution, "print_time": True, "local_num_threads": 10 })
+    nest.SetKernelStatus({"resolution": resolution, "print_time": True, "local_num_threads": threads })
 
     sources = nest.Create("parrot_neuron", elements)
     target = nest.Create("iaf_psc_delta")
@@ -97,10 +100,15 @@ def bench(config, resolution):
     else:
         raise Exception('unknown config')
 
-    nest.Simulate(duration + 2 * delay)
-
     #print nest.GetStatus(detector, "n_events")[0]
 
+    return sources + target, duration + 2 * delay
+
+def bench(config, resolution):
+
+    neurons, simtime = build(config, resolution)
+    nest.Simulate(simtime)
+
 if __name__ == '__main__':
     import timeit
 
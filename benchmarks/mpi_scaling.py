@@ -0,0 +1,225 @@
+"""
+Weak and strong MPI scaling of static connections vs standard approach vs STDPNode approach on a single host.
+
+    python mpi_scaling.py brunnel --ranks 1 2 4 --size 250
+    python mpi_scaling.py feedforward --ranks 1 2 4 --size 1000 --weak
+
+Every measure launches `mpirun -np N python mpi_scaling.py --worker ...`, each rank writes its
+simulate time, local spike count and exchange volume to <output>/<network>-<config>-<size>-<N>.<rank>.json
+and the tables are printed once all measures are done. Ranks run single-threaded.
+
+Exchange volume: every node with proxies sends its spikes through the exchange, the synapse
+nodes of the STDPNode approach as well as the neurons. Exchanged spikes are taken from the
+kernel (`local_spike_counter`) when available, else counted by a second detector on the local
+nodes other than the neurons.
+
+Communication share: NEST 2.10 does not time its spike exchange, it is taken from the kernel
+(`time_communicate`) when available, else estimated with mpi4py by replaying the exchange
+(one Allgather of the largest per-rank volume every min_delay) on the same ranks.
+"""
+
+import argparse
+import glob
+import json
+import os
+import random
+import subprocess
+import sys
+import time
+
+configs = { 1: "static", 2: "standard", 3: "STDPNode" }
+
+# NEST 2.10 exchanges spikes as unsigned int GIDs through MPI_Allgather
+spike_bytes = 4
+
+def worker(args):
+    """Build, simulate and measure one network on this rank."""
+
+    random.seed(args.seed) # same network on every rank
+
+    if args.network == "brunnel":
+        import brunnel as network
+        neurons, simtime = network.build(args.config, args.size)
+    else:
+        import feedforward as network
+        neurons, simtime = network.build(args.config, 1.0, elements = args.size, threads = 1)
+
+    nest = network.nest
+    detector = nest.Create("spike_detector", params = { "to_memory": False })
+    nest.Connect(neurons, detector)
+
+    counted = "local_spike_counter" in nest.GetKernelStatus()
+    others = None
+    if not counted:
+        nodes = exchanged_nodes(nest, neurons)
+        if nodes:
+            others = nest.Create("spike_detector", params = { "to_memory": False })
+            nest.Connect(nodes, others)
+
+    rank = nest.Rank()
+    n_ranks = nest.NumProcesses()
+
+    nest.sli_run("SyncProcesses")
+    start = time.time()
+    nest.Simulate(simtime)
+    elapsed = time.time() - start
+
+    kernel = nest.GetKernelStatus()
+    min_delay = kernel["min_delay"]
+    spikes = nest.GetStatus(detector, "n_events")[0]
+    if counted:
+        exchanged = kernel["local_spike_counter"]
+    else:
+        exchanged = spikes + (nest.GetStatus(others, "n_events")[0] if others else 0)
+
+    result = {
+        "rank": rank,
+        "ranks": n_ranks,
+        "simulate": elapsed,
+        "spikes": spikes,
+        "exchanged": exchanged,
+        "sent": exchanged * spike_bytes,
+        "rounds": int(round(simtime / min_delay)),
+        "communicate": kernel.get("time_communicate"),
+        "connections": kernel["num_connections"],
+    }
+
+    if result["communicate"] is None:
+        result["communicate"] = replay_exchange(result, n_ranks)
+
+    path = os.path.join(args.output, "%s.%d.json" % (tag(args, n_ranks), rank))
+    with open(path, "w") as f:
+        json.dump(result, f)
+
+def exchanged_nodes(nest, neurons):
+    """Local nodes other than the neurons whose spikes are exchanged, e.g. synapse nodes."""
+
+    leaves = nest.GetLeaves((0,), local_only = True)[0]
+    skip = set(neurons)
+    kinds = nest.GetStatus(leaves, "element_type")
+    return [gid for gid, kind in zip(leaves, kinds) if kind == "neuron" and gid not in skip]
+
+def replay_exchange(result, n_ranks):
+    """Time the spike exchange of a simulation with mpi4py, None when unavailable."""
+
+    try:
+        import mpi4py
+        mpi4py.rc.initialize = False # already initialized by NEST
+        mpi4py.rc.finalize = False
+        from mpi4py import MPI
+        import numpy as np
+    except ImportError:
+        return None
+
+    comm = MPI.COMM_WORLD
+    per_round = comm.allreduce(result["sent"], op = MPI.MAX) // result["rounds"] + spike_bytes
+    send = np.zeros(per_round, dtype = np.uint8)
+    receive = np.empty(per_round * n_ranks, dtype = np.uint8)
+
+    comm.Barrier()
+    start = MPI.Wtime()
+    for _ in range(result["rounds"]):
+        comm.Allgather(send, receive)
+    return MPI.Wtime() - start
+
+def tag(args, ranks):
+    """Name of a measure."""
+    return "%s-%d-%d-%d" % (args.network, args.config, args.size, ranks)
+
+def measure(args, config, size, ranks):
+    """Run one measure under mpirun and gather its per-rank results."""
+
+    measure_args = argparse.Namespace(**vars(args))
+    measure_args.config = config
+    measure_args.size = size
+
+    for path in glob.glob(os.path.join(args.output, "%s.*.json" % tag(measure_args, ranks))):
+        os.remove(path)
+
+    command = [args.mpirun, "-np", str(ranks), sys.executable, os.path.abspath(__file__), "--worker",
+               args.network, "--config", str(config), "--size", str(size), "--seed", str(args.seed),
+               "--output", args.output]
+    subprocess.check_call(command, cwd = os.path.dirname(os.path.abspath(__file__)))
+
+    results = []
+    for path in glob.glob(os.path.join(args.output, "%s.*.json" % tag(measure_args, ranks))):
+        with open(path) as f:
+            results.append(json.load(f))
+    return sorted(results, key = lambda r: r["rank"])
+
+def summary(results):
+    """Reduce per-rank results to the slowest rank and the exchange totals."""
+
+    slowest = max(r["simulate"] for r in results)
+    communicate = [r["communicate"] for r in results if r["communicate"] is not None]
+    sent = sum(r["sent"] for r in results)
+    return {
+        "ranks": len(results),
+        "simulate": slowest,
+        "spread": slowest - min(r["simulate"] for r in results),
+        "spikes": sum(r["spikes"] for r in results),
+        "exchanged": sum(r["exchanged"] for r in results),
+        "volume": sent * len(results), # every rank receives all spikes
+        "share": max(communicate) / slowest if communicate and slowest > 0 else None,
+    }
+
+def table(title, args, rows):
+    """Print one scaling table."""
+
+    print("")
+    print(title)
+    print("%-10s %6s %8s %10s %10s %10s %12s %12s %12s %8s" % (
+        "approach", "ranks", "size", "simulate", "spread", "efficiency", "spikes", "exchanged", "volume (B)",
+        "comm"))
+
+    for config, ranks, size, result, reference in rows:
+        if args.weak:
+            efficiency = reference["simulate"] / result["simulate"]
+        else:
+            efficiency = reference["ranks"] * reference["simulate"] / (ranks * result["simulate"])
+        share = "-" if result["share"] is None else "%.1f%%" % (100.0 * result["share"])
+        print("%-10s %6d %8d %10.3f %10.3f %10.2f %12d %12d %12d %8s" % (
+            configs[config], ranks, size, result["simulate"], result["spread"], efficiency,
+            result["spikes"], result["exchanged"], result["volume"], share))
+
+def main():
+    parser = argparse.ArgumentParser(description = __doc__.strip().split("\n")[0])
+    parser.add_argument("network", choices = ["brunnel", "feedforward"])
+    parser.add_argument("--ranks", type = int, nargs = "+", default = [1, 2, 4])
+    parser.add_argument("--configs", type = int, nargs = "+", default = [1, 2, 3])
+    parser.add_argument("--size", type = int, default = 250,
+                        help = "order of brunnel or pre-synaptic neurons of feedforward (per rank when weak)")
+    parser.add_argument("--weak", action = "store_true", help = "scale the size with the ranks")
+    parser.add_argument("--seed", type = int, default = 42)
+    parser.add_argument("--mpirun", default = "mpirun")
+    parser.add_argument("--output", default = "mpi_scaling")
+    parser.add_argument("--worker", action = "store_true", help = argparse.SUPPRESS)
+    parser.add_argument("--config", type = int, help = argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    args.output = os.path.abspath(args.output)
+    if not os.path.isdir(args.output):
+        os.makedirs(args.output)
+
+    if args.worker:
+        worker(args)
+        return
+
+    rows = []
+    for config in args.configs:
+        reference = None
+        for ranks in sorted(args.ranks):
+            size = args.size * ranks if args.weak else args.size
+            result = summary(measure(args, config, size, ranks))
+            reference = reference or result
+            rows.append((config, ranks, size, result, reference))
+
+    title = "%s scaling of %s network (size %d%s)" % (
+        "weak" if args.weak else "strong", args.network, args.size, " per rank" if args.weak else "")
+    table(title, args, rows)
+
+    with open(os.path.join(args.output, "%s-%s.json" % (args.network, "weak" if args.weak else "strong")), "w") as f:
+        json.dump([{ "approach": configs[c], "ranks": n, "size": s, "result": r } for c, n, s, r, _ in rows], f, indent = 2)
+
+if __name__ == '__main__':
+    main()
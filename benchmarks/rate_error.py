@@ -0,0 +1,109 @@
+"""
+Error of the rate-based plasticity mode against the exact rule on the feedforward network.
+
+    python rate_error.py --model stdp_triplet_node --rates 5 10 20 40 --duration 20000
+
+Poisson sources (parrot neurons) drive one iaf_psc_delta target through exact STDP nodes. Each source
+also feeds a shadow node in rate-based mode, connected to the target with a null weight, so that both
+nodes see the same pre- and post-synaptic spikes. Weight changes of both are compared at every sample,
+per source rate, and the approximation is deemed acceptable when the error relative to the exact
+weight change stays below the tolerance.
+"""
+
+import argparse
+
+import nest
+import numpy as np
+
+try:
+    nest.Install("stdpmodule")
+except nest.NESTError:
+    pass # already installed
+nest.set_verbosity("M_WARNING")
+
+triplet_params = {
+    "tau_plus": 16.8,
+    "tau_plus_triplet": 101.0,
+    "tau_minus": 33.7,
+    "tau_minus_triplet": 125.0,
+    "Aplus": 5e-10,
+    "Aminus": 7e-3,
+    "Aplus_triplet": 6.2e-3,
+    "Aminus_triplet": 2.3e-4,
+    "Wmin": 0.0,
+    "Wmax": 100.0,
+    "weight": 1.0,
+}
+
+longterm_params = {
+    "weight": 1.0,
+}
+
+def run(model, rates, sources_per_rate, duration, sample, interval, tau, resolution):
+    """Simulate exact and rate-based nodes side by side, return sample times and weight changes."""
+
+    nest.ResetKernel()
+    nest.SetKernelStatus({ "resolution": resolution, "print_time": False })
+
+    params = triplet_params if model == "stdp_triplet_node" else longterm_params
+    rate_params = dict(params, rate_based = True, rate_interval = interval, rate_tau = tau)
+
+    source_rates = np.repeat(rates, sources_per_rate)
+    generators = nest.Create("poisson_generator", len(source_rates), [{ "rate": r } for r in source_rates])
+    sources = nest.Create("parrot_neuron", len(source_rates))
+    target = nest.Create("iaf_psc_delta")
+    exact = nest.Create(model, len(sources), params = params)
+    approximate = nest.Create(model, len(sources), params = rate_params)
+
+    delay = 2.0
+    nest.Connect(generators, sources, 'one_to_one')
+    for nodes, weight in [(exact, 1.0), (approximate, 0.0)]:
+        nest.Connect(sources, nodes, 'one_to_one', { "delay": resolution })
+        nest.Connect(nodes, target, 'all_to_all', { "weight": weight, "delay": delay - resolution })
+        nest.Connect(target, nodes, 'all_to_all', { "delay": delay - resolution, "receptor_type": 1 })
+
+    initial = np.array(nest.GetStatus(exact, "weight"))
+    times, exact_changes, approximate_changes = [], [], []
+    for t in np.arange(sample, duration + sample, sample):
+        nest.Simulate(sample)
+        times.append(t)
+        exact_changes.append(np.array(nest.GetStatus(exact, "weight")) - initial)
+        approximate_changes.append(np.array(nest.GetStatus(approximate, "weight")) - initial)
+
+    return source_rates, np.array(times), np.array(exact_changes), np.array(approximate_changes)
+
+def report(source_rates, times, exact, approximate, tolerance):
+    """Print the relative error per source rate at every sample, return whether it is acceptable."""
+
+    print("%-10s %10s %14s %14s %10s" % ("time (ms)", "rate (Hz)", "exact dw", "rate-based dw", "error"))
+    acceptable = True
+    for rate in np.unique(source_rates):
+        selected = source_rates == rate
+        for t, e, a in zip(times, exact[:, selected], approximate[:, selected]):
+            # error relative to the exact change, mean over sources of the rate
+            scale = max(np.sqrt(np.mean(e ** 2)), 1e-12)
+            error = np.sqrt(np.mean((a - e) ** 2)) / scale
+            print("%-10.0f %10.1f %14.6g %14.6g %10.3f" % (t, rate, np.mean(e), np.mean(a), error))
+        acceptable = acceptable and error <= tolerance
+
+    print("")
+    print("rate-based approximation %s (final errors %s tolerance %.2f)" % (
+        "acceptable" if acceptable else "NOT acceptable", "within" if acceptable else "above", tolerance))
+    return acceptable
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description = __doc__.strip().split("\n")[0])
+    parser.add_argument("--model", default = "stdp_triplet_node", choices = ["stdp_triplet_node", "stdp_longterm_node"])
+    parser.add_argument("--rates", type = float, nargs = "+", default = [5.0, 10.0, 20.0, 40.0])
+    parser.add_argument("--sources", type = int, default = 50, help = "sources per rate")
+    parser.add_argument("--duration", type = float, default = 20000.0)
+    parser.add_argument("--sample", type = float, default = 2000.0)
+    parser.add_argument("--interval", type = float, default = 100.0, help = "rate_interval of the rate-based mode")
+    parser.add_argument("--tau", type = float, default = 1000.0, help = "rate_tau of the rate-based mode")
+    parser.add_argument("--resolution", type = float, default = 0.1)
+    parser.add_argument("--tolerance", type = float, default = 0.2)
+    args = parser.parse_args()
+
+    results = run(args.model, args.rates, args.sources, args.duration, args.sample, args.interval, args.tau,
+                  args.resolution)
+    report(*results, tolerance = args.tolerance)
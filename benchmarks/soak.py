@@ -0,0 +1,197 @@
+"""
+Long-duration soak of every STDP model: throughput drift and memory growth.
+
+    python soak.py --hours 4 --chunk 60 --models stdp_triplet_node stdp_triplet_all_in_one_synapse
+
+Each model runs in a fresh interpreter (`--worker`) on the same stationary network: Poisson parrot
+neurons project through the model onto noise-driven iaf_psc_delta neurons. Biological time is
+simulated in chunks of `--chunk` seconds, after each of which the events per second (pre-synaptic
+spikes times fan-out over wall time), the resident set size, the post-synaptic history entries
+(GetSTDPMemory) and the mean weight (and weight_ref of stdp_longterm_node) are reported.
+
+Once done, a model is flagged when its events per second over the last quarter fall below the first
+quarter (after the warm-up chunk) by more than `--tolerance`, or when its resident set size or
+history keep growing over the second half by more than `--tolerance`. The exit status is the number
+of flagged models.
+"""
+
+import argparse
+import json
+import subprocess
+import sys
+import time
+
+connection_models = ["stdp_triplet_all_in_one_synapse", "stdp_pair_synapse"]
+node_models = ["stdp_triplet_node", "stdp_longterm_node", "stdp_pair_node"]
+
+def resident():
+    """Resident set size of this process in bytes."""
+    with open("/proc/self/status") as status:
+        for line in status:
+            if line.startswith("VmRSS:"):
+                return int(line.split()[1]) * 1024
+    return 0
+
+def build(args):
+    """Build the soak network of a model, return pre-synaptic neurons, their detector and the synapses."""
+
+    import nest
+    import random
+
+    random.seed(1234)
+    nest.ResetKernel()
+    nest.SetKernelStatus({ "resolution": args.resolution, "local_num_threads": args.threads, "print_time": False })
+
+    pre = nest.Create("parrot_neuron", args.pre)
+    post = nest.Create("iaf_psc_delta", args.post)
+    drive = nest.Create("poisson_generator", params = { "rate": args.rate })
+    noise = nest.Create("poisson_generator", params = { "rate": args.noise })
+    detector = nest.Create("spike_detector", params = { "to_memory": False })
+
+    nest.Connect(drive, pre)
+    nest.Connect(noise, post, syn_spec = { "weight": 0.5, "delay": args.delay })
+    nest.Connect(pre, detector)
+
+    # stdp_longterm_node has no bounds, its weight is consolidated
+    weight = 0.05
+    rule = { "weight": weight }
+    if args.worker_model != "stdp_longterm_node":
+        rule.update({ "Wmin": 0.0, "Wmax": 4 * weight })
+    if args.worker_model in connection_models:
+        syn_spec = dict(rule, model = args.worker_model, delay = args.delay)
+        nest.Connect(pre, post, { "rule": "fixed_indegree", "indegree": args.indegree }, syn_spec)
+        return pre, detector, nest.GetConnections(pre, synapse_model = args.worker_model)
+
+    synapses = ()
+    for neuron in post:
+        nodes = nest.Create(args.worker_model, args.indegree, params = rule)
+        nest.Connect(random.sample(pre, args.indegree), nodes, "one_to_one", { "delay": args.resolution })
+        nest.Connect(nodes, (neuron,), "all_to_all", { "delay": args.delay - args.resolution })
+        nest.Connect((neuron,), nodes, "all_to_all", { "delay": args.delay - args.resolution, "receptor_type": 1 })
+        synapses += nodes
+    return pre, detector, synapses
+
+def mean(values):
+    return sum(values) / len(values) if values else 0.0
+
+def worker(args):
+    """Simulate one model chunk by chunk, print the measures of each chunk as json."""
+
+    import nest
+    nest.set_verbosity("M_WARNING")
+    nest.Install("stdpmodule")
+
+    pre, detector, synapses = build(args)
+    fan_out = float(args.post * args.indegree) / args.pre
+
+    n_chunks = int(round(args.hours * 3600.0 / args.chunk))
+    n_events = 0
+    for chunk in range(n_chunks):
+        start = time.time()
+        nest.Simulate(args.chunk * 1000.0)
+        elapsed = time.time() - start
+
+        spikes = nest.GetStatus(detector, "n_events")[0]
+        memory = nest.sli_func("GetSTDPMemory")
+        measures = {
+            "chunk": chunk,
+            "time": (chunk + 1) * args.chunk,
+            "wall": elapsed,
+            "events_per_second": (spikes - n_events) * fan_out / elapsed,
+            "rss": resident(),
+            "history": memory["history"]["n_entries"],
+            "weight": mean(nest.GetStatus(synapses, "weight")),
+        }
+        if args.worker_model == "stdp_longterm_node":
+            measures["weight_ref"] = mean(nest.GetStatus(synapses, "weight_ref"))
+        n_events = spikes
+
+        print(json.dumps(measures))
+        sys.stdout.flush()
+
+def flags(chunks, tolerance):
+    """Reasons to flag the chunks of a model, if any."""
+
+    reasons = []
+    # the first chunk pays for initialization and warm-up
+    measured = chunks[1:] if len(chunks) > 4 else chunks
+    quarter = max(len(measured) // 4, 1)
+    half = len(measured) // 2
+
+    early = mean([c["events_per_second"] for c in measured[:quarter]])
+    late = mean([c["events_per_second"] for c in measured[-quarter:]])
+    if late < (1.0 - tolerance) * early:
+        reasons.append("events/s fell from %.0f to %.0f" % (early, late))
+
+    # growth beyond the tolerance and beyond noise (1 MiB, 1000 entries)
+    for key, label, noise in [("rss", "RSS", 1 << 20), ("history", "history", 1000)]:
+        middle, end = measured[half][key], measured[-1][key]
+        if end > (1.0 + tolerance) * middle and end > middle + noise:
+            reasons.append("%s grew from %d to %d over the second half" % (label, middle, end))
+
+    return reasons
+
+def report(model, chunks, tolerance):
+    """Print one line per chunk and the flags of a model, return whether it is flagged."""
+
+    mb = 1024.0 * 1024.0
+    print("\n%s" % model)
+    print("%10s %10s %14s %10s %12s %12s %12s" % (
+        "time (s)", "wall (s)", "events / s", "RSS (MB)", "history", "weight", "weight_ref"))
+    for c in chunks:
+        print("%10.0f %10.2f %14.0f %10.1f %12d %12.6f %12s" % (
+            c["time"], c["wall"], c["events_per_second"], c["rss"] / mb, c["history"], c["weight"],
+            "%.6f" % c["weight_ref"] if "weight_ref" in c else "-"))
+
+    reasons = flags(chunks, tolerance) if chunks else ["no chunk completed"]
+    for reason in reasons:
+        print("FLAGGED: %s" % reason)
+    return len(reasons) > 0
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description = __doc__.strip().split("\n")[0])
+    parser.add_argument("--models", nargs = "+", default = connection_models + node_models,
+                        choices = connection_models + node_models)
+    parser.add_argument("--hours", type = float, default = 2.0, help = "biological time (h)")
+    parser.add_argument("--chunk", type = float, default = 60.0, help = "biological time per chunk (s)")
+    parser.add_argument("--pre", type = int, default = 1000)
+    parser.add_argument("--post", type = int, default = 100)
+    parser.add_argument("--indegree", type = int, default = 100)
+    parser.add_argument("--rate", type = float, default = 5.0, help = "pre-synaptic rate (Hz)")
+    parser.add_argument("--noise", type = float, default = 15000.0, help = "noise rate of post-synaptic neurons (Hz)")
+    parser.add_argument("--delay", type = float, default = 1.5)
+    parser.add_argument("--resolution", type = float, default = 0.1)
+    parser.add_argument("--threads", type = int, default = 1)
+    parser.add_argument("--tolerance", type = float, default = 0.1)
+    parser.add_argument("--json", help = "write the chunks of all models to this file")
+    parser.add_argument("--worker", dest = "worker_model", help = argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.worker_model:
+        worker(args)
+        sys.exit(0)
+
+    results = {}
+    flagged = 0
+    for model in args.models:
+        command = [sys.executable, __file__, "--worker", model]
+        for option in ["hours", "chunk", "pre", "post", "indegree", "rate", "noise", "delay", "resolution", "threads"]:
+            command += ["--" + option, str(getattr(args, option))]
+
+        chunks = []
+        process = subprocess.Popen(command, stdout = subprocess.PIPE)
+        for line in iter(process.stdout.readline, b""):
+            line = line.decode().strip()
+            if line.startswith("{"):
+                chunks.append(json.loads(line))
+                sys.stderr.write("%s: %.0f s\r" % (model, chunks[-1]["time"]))
+        process.wait()
+
+        results[model] = chunks
+        flagged += report(model, chunks, args.tolerance)
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(results, f, indent = 2, sort_keys = True)
+
+    sys.exit(flagged)
@@ -0,0 +1,112 @@
+/*
+ * Time the kernels of the triplet rule (stdp_triplet_rule.h) without NEST,
+ * as run by stdp_triplet_node (decay factors from a table) and by
+ * stdp_triplet_all_in_one_synapse (decay over intervals).
+ *
+ *     g++ -O2 -I.. triplet_rule.cpp -o triplet_rule && ./triplet_rule 10000000
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#include "stdp_triplet_rule.h"
+
+using namespace stdpmodule;
+
+namespace {
+
+const double resolution = 0.1;
+const double tau_plus = 16.8;
+const double tau_plus_triplet = 101.0;
+const double tau_minus = 33.7;
+const double tau_minus_triplet = 125.0;
+const double Aplus = 5e-10;
+const double Aminus = 7e-3;
+const double Aplus_triplet = 6.2e-3;
+const double Aminus_triplet = 2.3e-4;
+
+struct Synapse {
+  double weight_;
+  double Kplus_;
+  double Kplus_triplet_;
+  double Kminus_;
+  double Kminus_triplet_;
+
+  Synapse()
+      : weight_(5.0), Kplus_(0.0), Kplus_triplet_(0.0), Kminus_(0.0),
+        Kminus_triplet_(0.0) {}
+
+  triplet_rule::Traces traces() {
+    return triplet_rule::Traces(Kplus_, Kplus_triplet_, Kminus_,
+                                Kminus_triplet_);
+  }
+};
+
+double seconds(std::clock_t start) {
+  return double(std::clock() - start) / CLOCKS_PER_SEC;
+}
+}
+
+int main(int argc, char **argv) {
+  const long n = argc > 1 ? std::atol(argv[1]) : 10000000;
+  const long max_interval = 100;
+  const double ceiling = triplet_rule::ceiling(false);
+
+  // spike intervals (steps) and kinds, drawn once for both runs
+  std::vector<long> intervals(n);
+  std::vector<bool> pre(n);
+  std::srand(1);
+  for (long i = 0; i < n; ++i) {
+    intervals[i] = 1 + std::rand() % max_interval;
+    pre[i] = std::rand() % 2 == 0;
+  }
+
+  std::vector<double> decays(4 * (max_interval + 1));
+  for (long k = 0; k <= max_interval; ++k) {
+    decays[4 * k] = std::exp(-k * resolution / tau_plus);
+    decays[4 * k + 1] = std::exp(-k * resolution / tau_plus_triplet);
+    decays[4 * k + 2] = std::exp(-k * resolution / tau_minus);
+    decays[4 * k + 3] = std::exp(-k * resolution / tau_minus_triplet);
+  }
+
+  Synapse table;
+  std::clock_t start = std::clock();
+  for (long i = 0; i < n; ++i) {
+    const double *d = &decays[4 * intervals[i]];
+    triplet_rule::decay(table.traces(), d[0], d[1], d[2], d[3]);
+    const double change =
+        pre[i] ? triplet_rule::on_pre(table.traces(), Aminus, Aminus_triplet,
+                                      ceiling)
+               : triplet_rule::on_post(table.traces(), Aplus, Aplus_triplet,
+                                       ceiling);
+    table.weight_ = triplet_rule::clamp(table.weight_ + change, 0.0, 100.0);
+  }
+  const double table_time = seconds(start);
+
+  Synapse interval;
+  start = std::clock();
+  for (long i = 0; i < n; ++i) {
+    triplet_rule::decay_over(interval.traces(), intervals[i] * resolution,
+                             tau_plus, tau_plus_triplet, tau_minus,
+                             tau_minus_triplet);
+    const double change =
+        pre[i] ? triplet_rule::on_pre(interval.traces(), Aminus,
+                                      Aminus_triplet, ceiling)
+               : triplet_rule::on_post(interval.traces(), Aplus,
+                                       Aplus_triplet, ceiling);
+    interval.weight_ =
+        triplet_rule::clamp(interval.weight_ + change, 0.0, 100.0);
+  }
+  const double interval_time = seconds(start);
+
+  std::printf("%-10s %12s %12s %14s\n", "decay", "spikes", "time (s)",
+              "ns / spike");
+  std::printf("%-10s %12ld %12.3f %14.2f\n", "table", n, table_time,
+              1e9 * table_time / n);
+  std::printf("%-10s %12ld %12.3f %14.2f\n", "interval", n, interval_time,
+              1e9 * interval_time / n);
+  std::printf("weights %.12f %.12f\n", table.weight_, interval.weight_);
+  return 0;
+}
@@ -0,0 +1,1258 @@
+#!/usr/bin/env python
+"""
+Generate specialized STDP node and connection models from a rule description.
+
+    python codegen/stdp_codegen.py codegen/rules/stdp_pair.json
+    python codegen/stdp_codegen.py --check codegen/rules/*.json
+
+For a rule named <name>, writes <name>_names.h, <name>_node.{h,cpp} and <name>_connection.h at the
+root of the module, and registers the models <name>_node and <name>_synapse and their sources in
+stdpmodule.cpp and Makefile.am between the "generated" markers. --check only reports files that
+are not up to date.
+
+A rule is a JSON object:
+
+    name         model prefix, e.g. "stdp_pair"
+    class        C++ class prefix, e.g. "STDPPair" (STDPPairNeuron, STDPPairConnection)
+    description  first paragraph of the documentation
+    references   list of reference lines
+    parameters   { name: [default, doc] }, settable through the status
+    constants    { name: [value, doc] }, folded into the code
+    weight       initial weight (default 1.0)
+    traces       { name: { "tau": time constant (ms), parameter, constant or number,
+                           "on": "pre" or "post", the spikes incrementing the trace,
+                           "increment": expression (default 1.0),
+                           "saturate": value the trace is clamped to after its increment,
+                           "doc": description } }
+    on_pre       statements run at pre-synaptic spikes
+    on_post      statements run at post-synaptic spikes
+    bounds       [min, max] of the weight, parameters, constants or numbers
+
+Statements are "weight += e", "weight -= e" or "<trace> = e" with C++ expressions of the
+parameters, constants, traces, weight and exp, pow, sqrt, min, max. At a spike, traces decay
+to the spike time, statements run, the weight is clamped to the bounds and traces of the spike
+are incremented, as in stdp_triplet_node and stdp_triplet_all_in_one_synapse.
+
+Generated models register under their kernel name for weight statistics, plasticity schedules
+and pruning counts, and prune as stdp_triplet_node and stdp_triplet_all_in_one_synapse do
+(prune_threshold, prune_time, active).
+
+The generated code has constants folded (constant factors of products are multiplied, zero terms
+and statements dropped, time constants inverted), trace decays of nodes tabulated, and only the
+branches the rule needs: a rule without post-synaptic traces nor statements does not read the
+post-synaptic history in its connection.
+"""
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import re
+import string
+import sys
+import textwrap
+
+root = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+functions = { "exp": "std::exp", "pow": "std::pow", "sqrt": "std::sqrt", "min": "std::min", "max": "std::max" }
+
+token_re = re.compile(r"\s*(?:(\d+\.?\d*(?:[eE][-+]?\d+)?|\.\d+(?:[eE][-+]?\d+)?)|([A-Za-z_]\w*)|(\S))")
+statement_re = re.compile(r"^\s*(\w+)\s*([-+]?=)\s*(.+?)\s*;?\s*$")
+
+def literal(value):
+    """C++ literal of a double."""
+    return repr(float(value))
+
+def tokenize(expression):
+    """Split an expression in (kind, text) tokens, kind being number, name or operator."""
+    tokens = []
+    position = 0
+    expression = expression.strip()
+    while position < len(expression):
+        match = token_re.match(expression, position)
+        number, name, operator = match.groups()
+        if number is not None:
+            tokens.append(("number", number))
+        elif name is not None:
+            tokens.append(("name", name))
+        else:
+            tokens.append(("operator", operator))
+        position = match.end()
+    return tokens
+
+def split(tokens, separators):
+    """Split tokens at the given operators outside parentheses, as (operator, tokens) parts.
+
+    Leading signs of "+" and "-" splits go to the sign of their part.
+    """
+    parts = [("+", [])]
+    depth = 0
+    for kind, text in tokens:
+        if text == "(":
+            depth += 1
+        elif text == ")":
+            depth -= 1
+        if depth == 0 and kind == "operator" and text in separators:
+            current = parts[-1][1]
+            if current and (current[-1][0] != "operator" or current[-1][1] == ")"):
+                parts.append((text, []))
+                continue
+            if not current and text in "+-":
+                parts[-1] = ("-" if (parts[-1][0] == "-") != (text == "-") else "+", [])
+                continue
+        parts[-1][1].append((kind, text))
+    return parts
+
+class Rule(object):
+    """Rule description and its rendering in node or connection scope."""
+
+    def __init__(self, description, path):
+        self.path = path
+        self.name = description["name"]
+        self.cls = description["class"]
+        self.description = description.get("description", "")
+        self.references = description.get("references", [])
+        self.parameters = description.get("parameters", {})
+        self.constants = description.get("constants", {})
+        self.weight = float(description.get("weight", 1.0))
+        self.traces = description.get("traces", {})
+        self.on_pre = description.get("on_pre", [])
+        self.on_post = description.get("on_post", [])
+        self.bounds = description.get("bounds")
+
+        self.parameter_names = sorted(self.parameters)
+        self.trace_names = sorted(self.traces, key = lambda t: (self.traces[t]["on"] != "pre", t))
+
+        names = set(self.parameters) | set(self.constants) | set(self.traces) | set(["weight"])
+        if len(names) != len(self.parameters) + len(self.constants) + len(self.traces) + 1:
+            raise ValueError("%s: parameters, constants, traces and weight must have distinct names" % path)
+        for trace in self.trace_names:
+            if self.traces[trace].get("on") not in ("pre", "post"):
+                raise ValueError("%s: trace %s must be incremented on pre or post spikes" % (path, trace))
+            if self.value(str(self.traces[trace]["tau"])) is None and self.traces[trace]["tau"] not in self.parameters:
+                raise ValueError("%s: time constant of %s must be a parameter, constant or number" % (path, trace))
+
+    def pre_traces(self):
+        return [t for t in self.trace_names if self.traces[t]["on"] == "pre"]
+
+    def post_traces(self):
+        return [t for t in self.trace_names if self.traces[t]["on"] == "post"]
+
+    def uses_post(self):
+        """Whether the rule depends on post-synaptic spikes at all."""
+        return bool(self.post_traces() or self.statements(self.on_post, "connection"))
+
+    def value(self, text):
+        """Value of a number or constant, None otherwise."""
+        if text in self.constants:
+            return float(self.constants[text][0])
+        try:
+            return float(text)
+        except ValueError:
+            return None
+
+    def render_token(self, token, scope):
+        """C++ of a token in node or connection scope."""
+        kind, text = token
+        if kind != "name":
+            return text
+        if text in self.constants:
+            return literal(self.constants[text][0])
+        if text in functions:
+            return functions[text]
+        if text in self.parameters:
+            return ("P_.%s_" if scope == "node" else "%s_") % text
+        if text in self.traces or text == "weight":
+            return ("S_.%s_" if scope == "node" else "%s_") % text
+        raise ValueError("%s: unknown name %s" % (self.path, text))
+
+    def render(self, tokens, scope):
+        text = ""
+        previous = None
+        for kind, token in tokens:
+            unary = previous is None or previous[0] == "operator" and previous[1] != ")"
+            if kind == "operator" and token not in "()," and not (unary and token in "+-"):
+                text += " %s " % token
+            elif token == ",":
+                text += ", "
+            else:
+                text += self.render_token((kind, token), scope)
+            previous = (kind, token)
+        return text
+
+    def constant(self, tokens):
+        """Value of tokens made of numbers, constants and arithmetic only, None otherwise."""
+        text = ""
+        for kind, token in tokens:
+            if kind == "name":
+                value = self.value(token)
+                if value is None:
+                    return None
+                text += repr(value)
+            elif kind == "number" or token in "+-*/()":
+                text += token
+            else:
+                return None
+        try:
+            return float(eval(text, { "__builtins__": {} }))
+        except (SyntaxError, ZeroDivisionError):
+            return None
+
+    def fold(self, expression, scope):
+        """C++ of an expression with constant factors folded, None when it is zero."""
+        terms = []
+        for sign, term in split(tokenize(expression), "+-"):
+            coefficient = -1.0 if sign == "-" else 1.0
+            factors = []
+            products = split(term, "*")
+            if any(op == "/" for op, _ in split(term, "/")[1:]):
+                products = [("*", term)] # quotients are folded as a whole only
+            for _, factor in products:
+                value = self.constant(factor)
+                if value is None:
+                    rendered = self.render(factor, scope)
+                    factors.append("(%s)" % rendered if len(split(factor, "+-")) > 1 else rendered)
+                else:
+                    coefficient *= value
+            if coefficient != 0.0:
+                terms.append((coefficient, factors))
+
+        if not terms:
+            return None
+
+        text = ""
+        for coefficient, factors in terms:
+            magnitude = abs(coefficient)
+            parts = ([literal(magnitude)] if magnitude != 1.0 or not factors else []) + factors
+            if text:
+                text += " - " if coefficient < 0 else " + "
+            elif coefficient < 0:
+                text += "-"
+            text += " * ".join(parts)
+        return text
+
+    def statements(self, statements, scope):
+        """C++ statements of a spike, zero updates dropped."""
+        lines = []
+        for statement in statements:
+            match = statement_re.match(statement)
+            if match is None:
+                raise ValueError("%s: invalid statement %s" % (self.path, statement))
+            target, operator, expression = match.groups()
+            if target != "weight" and target not in self.traces:
+                raise ValueError("%s: statements update the weight or traces, not %s" % (self.path, target))
+            if target != "weight" and operator != "=":
+                raise ValueError("%s: traces are assigned with =" % self.path)
+
+            folded = self.fold(expression, scope)
+            if folded is None and operator != "=":
+                continue
+            lines.append("%s %s %s;" % (self.render_token(("name", target), scope), operator,
+                                        "0.0" if folded is None else folded))
+        return lines
+
+    def bound(self, index, scope):
+        value = self.value(str(self.bounds[index]))
+        return literal(value) if value is not None else self.render_token(("name", self.bounds[index]), scope)
+
+    def statistics_bounds(self, scope):
+        """C++ of the bounds counted by the statistics, infinite without bounds."""
+        if not self.bounds:
+            return "-std::numeric_limits<double_t>::infinity(), std::numeric_limits<double_t>::infinity()"
+        return "%s, %s" % (self.bound(0, scope), self.bound(1, scope))
+
+    def spike(self, on, scope, indent, change):
+        """C++ of the update at a spike: statements, bounds and trace increments.
+
+        A weight update is followed by the change statement, which keeps it while plastic and
+        undoes it otherwise, from the weight before the spike.
+        """
+        lines = self.statements(self.on_pre if on == "pre" else self.on_post, scope)
+        weight = self.render_token(("name", "weight"), scope)
+        if any(l.startswith(weight) for l in lines):
+            if self.bounds:
+                lines.append("%s = std::min(std::max(%s, %s), %s);" % (
+                    weight, weight, self.bound(0, scope), self.bound(1, scope)))
+            lines = ["const double_t weight = %s;" % weight] + lines + [change]
+        for trace in (self.pre_traces() if on == "pre" else self.post_traces()):
+            increment = self.fold(str(self.traces[trace].get("increment", 1.0)), scope)
+            variable = self.render_token(("name", trace), scope)
+            if increment is not None:
+                lines.append("%s += %s;" % (variable, increment))
+            if "saturate" in self.traces[trace]:
+                lines.append("%s = std::min(%s, %s);" % (variable, variable, literal(self.traces[trace]["saturate"])))
+        return "\n".join(" " * indent + l for l in lines)
+
+    def rate(self, trace, delta, scope):
+        """C++ of delta over the time constant of a trace, inverse time constants folded."""
+        tau = str(self.traces[trace]["tau"])
+        value = self.value(tau)
+        if value is None:
+            return "%s / %s" % (delta, self.render_token(("name", tau), scope))
+        return "%s * %s" % (delta, literal(1.0 / value))
+
+    def decay(self, trace, delta, indent):
+        """C++ decaying a trace of the connection over delta."""
+        return " " * indent + "%s_ *= std::exp(-%s);" % (trace, self.rate(trace, delta, "connection"))
+
+def doc_lines(items):
+    """Documentation lines of name, type and description."""
+    return "\n".join(" %-18s %s" % (name, text) for name, text in items)
+
+def substitute(template, **values):
+    return string.Template(template).substitute(values)
+
+header = """//
+//  $file
+//  NEST
+//
+//  Generated by codegen/stdp_codegen.py from $source, do not edit.
+//
+
+"""
+
+names_template = header + """#ifndef ${guard}
+#define ${guard}
+
+#include "name.h"
+
+namespace ${name}_names {
+$names
+}
+
+#endif /* ${guard} */
+"""
+
+node_header_template = header + """/* BeginDocumentation
+ Name: ${name}_node - Neuron that acts like a ${name}_synapse.
+
+ Description:
+ $description
+
+ Parameters:
+$parameters
+ prune_threshold    double: weight at or below which the synapse is depressed
+ (pruning is disabled by default)
+ prune_time         double: time the synapse must stay depressed before it is
+ pruned (ms)
+
+ States:
+$states
+ active             bool: false once pruned, the node then ignores its input,
+ stops updating and releases its buffers (set it back to true to revive it)
+
+ Notes:
+ Traces decay on spikes only, from a table of exact decays, recorded traces
+ are updated on spikes. Weight updates follow stdp_plasticity and feed
+ stdp_statistics, pruning is checked at slice boundaries, as for
+ stdp_triplet_node. Constants of the rule are not parameters: $constants
+
+ Receives: SpikeEvent, DataLoggingRequest
+
+ Sends: SpikeEvent
+
+ References:
+$references
+
+ SeeAlso: ${name}_synapse, stdp_triplet_node
+ */
+
+#ifndef ${guard}
+#define ${guard}
+
+#include <vector>
+
+#include "nest.h"
+#include "event.h"
+#include "archiving_node.h"
+#include "universal_data_logger.h"
+
+#include "plastic_node.h"
+#include "spike_ring_buffer.h"
+#include "stdp_statistics.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+class Network;
+
+class ${cls}Neuron : public Archiving_Node, public PlasticNode {
+
+public:
+  ${cls}Neuron();
+  ${cls}Neuron(const ${cls}Neuron &);
+
+  using Node::handle;
+  using Node::handles_test_event;
+
+  port send_test_event(Node &, rport, synindex, bool);
+  port handles_test_event(SpikeEvent &, rport);
+  port handles_test_event(DataLoggingRequest &, rport);
+
+  void get_status(DictionaryDatum &) const;
+  void set_status(const DictionaryDatum &);
+
+  void handle(SpikeEvent &);
+  void handle(DataLoggingRequest &);
+
+  unsigned int plastic_state_version() const { return 2; }
+  size_t plastic_state_size() const { return $n_values; }
+  void write_plastic_state(double *) const;
+  void read_plastic_state(const double *);
+  double *plastic_value(const Name &);
+  size_t memory_size() const;
+
+  /**
+   * Register the model under its kernel name, for statistics, plasticity
+   * schedules and pruning counts.
+   */
+  static void register_stdp_model(const std::string &name) {
+    stdp_model_ = STDPStatistics::register_model(name);
+  }
+
+private:
+  void init_state_(const Node &proto) {}
+  void init_buffers_();
+  void calibrate();
+
+  void update(Time const &, const long_t, const long_t);
+
+  /**
+   * Decay the traces up to the given step.
+   */
+  void decay_to_(long_t step);
+
+  /**
+   * Keep the weight change of a spike at the given step, from the given
+   * weight, while plastic and undo it otherwise.
+   */
+  void change_(long_t step, double_t weight, bool plastic);
+
+  /**
+   * Track since when the weight is at or below the pruning threshold.
+   */
+  void depressed_(long_t step);
+  void prune_();
+
+  friend class RecordablesMap<${cls}Neuron>;
+  friend class UniversalDataLogger<${cls}Neuron>;
+
+  struct Parameters_ {
+$parameter_members    double_t prune_threshold_;
+    double_t prune_time_;
+
+    Parameters_();
+    void get(DictionaryDatum &) const;
+    void set(const DictionaryDatum &);
+  };
+
+  struct State_ {
+    double_t weight_;
+$trace_members
+    long_t t_traces_;
+    // step since which the weight is at or below the pruning threshold
+    long_t t_depressed_;
+    bool active_;
+
+    State_();
+    void get(DictionaryDatum &) const;
+    void set(const DictionaryDatum &);
+
+    /**
+     * Decay the traces up to the given step, once they lag behind.
+     */
+    void decay(long_t step, const Parameters_ &);
+  };
+
+  struct Buffers_ {
+    SpikeRingBuffer n_pre_spikes_;
+    SpikeRingBuffer n_post_spikes_;
+    UniversalDataLogger<${cls}Neuron> logger_;
+
+    Buffers_(${cls}Neuron &);
+    Buffers_(const Buffers_ &, ${cls}Neuron &);
+  };
+
+  struct Variables_ {
+    // decays of the traces over 0 to table_steps steps
+    long_t table_steps_;
+    ArenaArray decays_;
+
+    long_t prune_steps_;
+    long_t statistics_epoch_;
+  };
+
+  // Access functions for UniversalDataLogger
+  double_t get_weight_() const { return S_.weight_; }
+$trace_accessors
+  Parameters_ P_;
+  State_ S_;
+  Variables_ V_;
+  Buffers_ B_;
+
+  static RecordablesMap<${cls}Neuron> recordablesMap_;
+  static STDPStatistics::Model stdp_model_;
+};
+
+inline port ${cls}Neuron::send_test_event(Node &target, rport receptor_type, synindex, bool) {
+  SpikeEvent e;
+  e.set_sender(*this);
+  return target.handles_test_event(e, receptor_type);
+}
+
+inline port ${cls}Neuron::handles_test_event(SpikeEvent &, rport receptor_type) {
+  // Allow connections to port 0 (pre-synaptic) and port 1 (post-synaptic)
+  if (receptor_type != 0 and receptor_type != 1) {
+    throw UnknownReceptorType(receptor_type, get_name());
+  }
+  return receptor_type;
+}
+
+inline port ${cls}Neuron::handles_test_event(DataLoggingRequest &dlr, rport receptor_type) {
+  if (receptor_type != 0) {
+    throw UnknownReceptorType(receptor_type, get_name());
+  }
+  return B_.logger_.connect_logging_device(dlr, recordablesMap_);
+}
+
+inline void ${cls}Neuron::get_status(DictionaryDatum &d) const {
+  // traces are decayed on spikes only
+  State_ s = S_;
+  s.decay(network()->get_time().get_steps() - 1, P_);
+
+  P_.get(d);
+  s.get(d);
+  Archiving_Node::get_status(d);
+  (*d)[names::recordables] = recordablesMap_.get_list();
+}
+
+inline void ${cls}Neuron::set_status(const DictionaryDatum &d) {
+  // pruned nodes did not decay, revived ones catch up here
+  S_.decay(network()->get_time().get_steps() - 1, P_);
+  P_.set(d);
+  S_.set(d);
+  Archiving_Node::set_status(d);
+}
+}
+
+#endif // ${guard}
+"""
+
+node_source_template = header + """#include "${name}_node.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "${name}_names.h"
+#include "stdpnames.h"
+#include "stdp_plasticity.h"
+#include "network.h"
+#include "dictutils.h"
+#include "universal_data_logger_impl.h"
+
+using namespace nest;
+
+/* ----------------------------------------------------------- devices */
+
+nest::RecordablesMap<stdpmodule::${cls}Neuron>
+    stdpmodule::${cls}Neuron::recordablesMap_;
+stdpmodule::STDPStatistics::Model stdpmodule::${cls}Neuron::stdp_model_ = 0;
+
+namespace nest {
+template <> void RecordablesMap<stdpmodule::${cls}Neuron>::create() {
+  insert_(names::weight, &stdpmodule::${cls}Neuron::get_weight_);
+$recordables}
+}
+
+/* ----------------------------------------------------------- parameters */
+
+stdpmodule::${cls}Neuron::Parameters_::Parameters_()$parameter_init {}
+
+void stdpmodule::${cls}Neuron::Parameters_::get(DictionaryDatum &d) const {
+$parameter_get  def<double_t>(d, stdpnames::prune_threshold, prune_threshold_);
+  def<double_t>(d, stdpnames::prune_time, prune_time_);
+}
+
+void stdpmodule::${cls}Neuron::Parameters_::set(const DictionaryDatum &d) {
+$parameter_set  updateValue<double_t>(d, stdpnames::prune_threshold, prune_threshold_);
+  updateValue<double_t>(d, stdpnames::prune_time, prune_time_);
+$parameter_check
+  if (!(prune_time_ >= 0)) {
+    throw BadProperty("Parameter prune_time must be positive.");
+  }
+}
+
+/* ----------------------------------------------------------- states */
+
+stdpmodule::${cls}Neuron::State_::State_()
+    : weight_($weight)$trace_init, t_traces_(-1), t_depressed_(-1), active_(true) {}
+
+void stdpmodule::${cls}Neuron::State_::get(DictionaryDatum &d) const {
+  def<double_t>(d, names::weight, weight_);
+$trace_get  def<bool>(d, stdpnames::active, active_);
+}
+
+void stdpmodule::${cls}Neuron::State_::set(const DictionaryDatum &d) {
+  updateValue<double_t>(d, names::weight, weight_);
+$trace_set  updateValue<bool>(d, stdpnames::active, active_);
+$trace_check}
+
+void stdpmodule::${cls}Neuron::State_::decay(long_t step, const Parameters_ &$decay_p) {
+  if (step <= t_traces_) {
+    return;
+  }
+
+  const double_t elapsed = Time(Time::step(step - t_traces_)).get_ms();
+$state_decay  t_traces_ = step;
+}
+
+double *stdpmodule::${cls}Neuron::plastic_value(const Name &name) {
+  S_.decay(network()->get_time().get_steps() - 1, P_);
+
+  if (name == names::weight) {
+    return &S_.weight_;
+  }
+$plastic_values  return 0;
+}
+
+void stdpmodule::${cls}Neuron::write_plastic_state(double *values) const {
+  const long_t now = network()->get_time().get_steps();
+  State_ s = S_;
+  s.decay(now - 1, P_);
+
+  values[0] = s.weight_;
+$trace_write  values[$active_value] = s.active_;
+  // steps at or below the pruning threshold, -1 when above
+  values[$depressed_value] = s.t_depressed_ < 0 ? -1.0 : now - s.t_depressed_;
+}
+
+void stdpmodule::${cls}Neuron::read_plastic_state(const double *values) {
+  const long_t now = network()->get_time().get_steps();
+
+  S_.weight_ = values[0];
+$trace_read  // buffers of revived nodes are drawn again on calibration
+  S_.active_ = values[$active_value] != 0.0;
+  S_.t_depressed_ = values[$depressed_value] < 0.0 ? -1 : now - static_cast<long_t>(values[$depressed_value]);
+
+  // traces were written at their time, which becomes the restore time
+  S_.t_traces_ = now - 1;
+}
+
+size_t stdpmodule::${cls}Neuron::memory_size() const {
+  return sizeof(${cls}Neuron) + B_.n_pre_spikes_.memory_size() +
+         B_.n_post_spikes_.memory_size() +
+         V_.decays_.memory_size();
+}
+
+/* ----------------------------------------------------------- buffers */
+
+stdpmodule::${cls}Neuron::Buffers_::Buffers_(${cls}Neuron &n) : logger_(n) {}
+
+stdpmodule::${cls}Neuron::Buffers_::Buffers_(const Buffers_ &, ${cls}Neuron &n)
+    : logger_(n) {}
+
+/* ----------------------------------------------------------- constructors */
+
+stdpmodule::${cls}Neuron::${cls}Neuron()
+    : Archiving_Node(), P_(), S_(), B_(*this) {
+  recordablesMap_.create();
+  V_.statistics_epoch_ = -1;
+}
+
+stdpmodule::${cls}Neuron::${cls}Neuron(const ${cls}Neuron &n)
+    : Archiving_Node(n), P_(n.P_), S_(n.S_), B_(n.B_, *this) {
+  V_.statistics_epoch_ = -1;
+}
+
+/* ----------------------------------------------------------- initialization */
+
+void stdpmodule::${cls}Neuron::init_buffers_() {
+  B_.n_pre_spikes_.clear(get_thread());
+  B_.n_post_spikes_.clear(get_thread());
+  B_.logger_.reset();
+  Archiving_Node::clear_history();
+}
+
+void stdpmodule::${cls}Neuron::calibrate() {
+  B_.logger_.init();
+
+  const double_t negative_delta = -Time::get_resolution().get_ms();
+
+  // spikes of a slice are at most min delay apart
+  V_.table_steps_ = Scheduler::get_min_delay();
+  V_.decays_.assign(get_thread(), $n_traces * (V_.table_steps_ + 1));
+  for (long_t n = 0; n <= V_.table_steps_; ++n) {
+$table  }
+
+  V_.prune_steps_ = Time(Time::ms(P_.prune_time_)).get_steps();
+
+  // pruned nodes keep no buffers, revived ones get them back
+  if (!S_.active_) {
+    B_.n_pre_spikes_.release();
+    B_.n_post_spikes_.release();
+    return;
+  }
+  if (B_.n_pre_spikes_.size() == 0) {
+    B_.n_pre_spikes_.clear(get_thread());
+    B_.n_post_spikes_.clear(get_thread());
+  }
+
+  depressed_(network()->get_time().get_steps());
+
+  STDPStatistics::enter(stdp_model_, get_thread(), V_.statistics_epoch_,
+                        S_.weight_, $statistics_bounds);
+}
+
+/* ----------------------------------------------------------- updates */
+
+void stdpmodule::${cls}Neuron::update(Time const &origin, const long_t from, const long_t to) {
+  assert(to >= 0 && (delay)from < Scheduler::get_min_delay());
+  assert(from < to);
+
+  if (!S_.active_) {
+    return;
+  }
+
+  // steps are gated in segments of constant plasticity
+  bool plastic = true;
+  long_t until = origin.get_steps() + from;
+
+  for (long_t lag = from; lag < to; ++lag) {
+
+    const long_t step = origin.get_steps() + lag;
+    if (step == until) {
+      plastic = STDPPlasticity::plastic_steps(stdp_model_, step, origin.get_steps() + to, until);
+    }
+
+    const double_t current_pre_spikes_n = B_.n_pre_spikes_.get_value(lag);
+$read_post
+    if ($any_spike) {
+      decay_to_(step);
+    }
+
+    if (current_pre_spikes_n > 0) {
+$on_pre
+      SpikeEvent se;
+      se.set_multiplicity(current_pre_spikes_n);
+      se.set_weight(S_.weight_);
+      network()->send(*this, se, lag);
+    }
+$on_post
+    B_.logger_.record_data(step);
+  }
+
+  // pruning happens at slice boundaries only
+  if (S_.t_depressed_ >= 0 and origin.get_steps() + to - S_.t_depressed_ >= V_.prune_steps_) {
+    prune_();
+  }
+}
+
+void stdpmodule::${cls}Neuron::decay_to_(long_t step) {
+  const long_t n = step - S_.t_traces_;
+
+  if (n <= 0) {
+    return;
+  }
+
+  if (n > V_.table_steps_) {
+    S_.decay(step, P_);
+    return;
+  }
+
+$table_decay  S_.t_traces_ = step;
+}
+
+void stdpmodule::${cls}Neuron::change_(long_t step, double_t weight, bool plastic) {
+  if (!plastic) {
+    S_.weight_ = weight;
+    return;
+  }
+
+  STDPStatistics::record(stdp_model_, get_thread(), V_.statistics_epoch_, weight, S_.weight_,
+                         $statistics_bounds);
+  depressed_(step);
+}
+
+void stdpmodule::${cls}Neuron::depressed_(long_t step) {
+  if (S_.weight_ > P_.prune_threshold_) {
+    S_.t_depressed_ = -1;
+  } else if (S_.t_depressed_ < 0) {
+    S_.t_depressed_ = step;
+  }
+}
+
+void stdpmodule::${cls}Neuron::prune_() {
+  S_.active_ = false;
+  S_.t_depressed_ = -1;
+
+  STDPStatistics::prune(stdp_model_, get_thread(), V_.statistics_epoch_, S_.weight_,
+                        $statistics_bounds);
+
+  B_.n_pre_spikes_.release();
+  B_.n_post_spikes_.release();
+  Archiving_Node::clear_history();
+}
+
+void stdpmodule::${cls}Neuron::handle(SpikeEvent &e) {
+  assert(e.get_delay() > 0);
+
+  if (!S_.active_) {
+    return;
+  }
+
+  switch (e.get_rport()) {
+  case 0: // PRE
+    B_.n_pre_spikes_.add_value(
+        e.get_rel_delivery_steps(network()->get_slice_origin()),
+        e.get_multiplicity());
+    break;
+
+  case 1: // POST
+    B_.n_post_spikes_.add_value(
+        e.get_rel_delivery_steps(network()->get_slice_origin()),
+        e.get_multiplicity());
+    break;
+
+  default:
+    break;
+  }
+}
+
+void stdpmodule::${cls}Neuron::handle(DataLoggingRequest &e) {
+  B_.logger_.handle(e);
+}
+"""
+
+connection_template = header + """/* BeginDocumentation
+ Name: ${name}_synapse - Synapse type with spike-timing dependent plasticity.
+
+ Description:
+ $description
+
+ Parameters:
+ weight             double: current synaptic weight
+$parameters
+ prune_threshold    double: weight at or below which the synapse is depressed
+ (pruning is disabled by default)
+ prune_time         double: time the synapse must stay depressed before it is
+ pruned (ms)
+
+ States:
+$states
+ active             bool: false once pruned, the connection then neither
+ updates nor transmits (set it back to true to revive it)
+ t_depressed        double: time since which the weight is at or below the
+ pruning threshold, -1 when above (ms)
+
+ Notes:
+ Weight updates follow stdp_plasticity and feed stdp_statistics, pruning is
+ checked on pre-synaptic spikes, as for stdp_triplet_all_in_one_synapse. A
+ pruned connection does not read the post-synaptic history, it marks what it
+ skipped as read on its first spike once revived.
+ Constants of the rule are not parameters: $constants
+
+ Transmits: SpikeEvent
+
+ References:
+$references
+
+ SeeAlso: ${name}_node, stdp_triplet_all_in_one_synapse
+ */
+
+#ifndef ${guard}
+#define ${guard}
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "connection.h"
+#include "stdpnames.h"
+#include "stdp_statistics.h"
+#include "stdp_plasticity.h"
+#include "${name}_names.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+template <typename targetidentifierT>
+class ${cls}Connection : public Connection<targetidentifierT> {
+
+public:
+  typedef CommonSynapseProperties CommonPropertiesType;
+  typedef Connection<targetidentifierT> ConnectionBase;
+
+  ${cls}Connection();
+
+  using ConnectionBase::get_delay_steps;
+  using ConnectionBase::get_delay;
+  using ConnectionBase::get_rport;
+  using ConnectionBase::get_target;
+
+  void get_status(DictionaryDatum &d) const;
+  void set_status(const DictionaryDatum &d, ConnectorModel &cm);
+
+  void send(Event &e, thread t, double_t t_lastspike,
+            const CommonSynapseProperties &cp);
+
+  class ConnTestDummyNode : public ConnTestDummyNodeBase {
+  public:
+    using ConnTestDummyNodeBase::handles_test_event;
+    port handles_test_event(SpikeEvent &, rport) { return invalid_port_; }
+  };
+
+  void check_connection(Node &s, Node &t, rport receptor_type,
+                        double_t t_lastspike, const CommonPropertiesType &) {
+    ConnTestDummyNode dummy_target;
+    ConnectionBase::check_connection_(dummy_target, s, t, receptor_type);
+$register  }
+
+  void set_weight(double_t w) { weight_ = w; }
+
+  /**
+   * Register the model under its kernel name, for statistics, plasticity
+   * schedules and pruning counts.
+   */
+  static void register_stdp_model(const std::string &name) {
+    stdp_model_ = STDPStatistics::register_model(name);
+  }
+
+private:
+  /**
+   * Keep the weight change of a spike at t_change (ms), from the given
+   * weight, while plastic and undo it otherwise.
+   */
+  void change_(thread t, double_t t_change, double_t weight) {
+    if (!STDPPlasticity::plastic(stdp_model_, t_change)) {
+      weight_ = weight;
+      return;
+    }
+
+    STDPStatistics::record(stdp_model_, t, statistics_epoch_, weight, weight_,
+                           $statistics_bounds);
+    depressed_(t_change);
+  }
+
+  /**
+   * Track since when the weight is at or below the pruning threshold.
+   */
+  void depressed_(double_t t) {
+    if (weight_ > prune_threshold_) {
+      t_depressed_ = -1.0;
+    } else if (t_depressed_ < 0.0) {
+      t_depressed_ = t;
+    }
+  }
+
+  double_t weight_;
+$parameter_members$trace_members
+  double_t prune_threshold_;
+  double_t prune_time_;
+  double_t t_depressed_;
+  bool active_;
+$unread_member  long_t statistics_epoch_;
+
+  static STDPStatistics::Model stdp_model_;
+};
+}
+
+template <typename targetidentifierT>
+stdpmodule::STDPStatistics::Model
+    stdpmodule::${cls}Connection<targetidentifierT>::stdp_model_ = 0;
+
+template <typename targetidentifierT>
+stdpmodule::${cls}Connection<targetidentifierT>::${cls}Connection()
+    : ConnectionBase(), weight_($weight)$initializers,
+      prune_threshold_(-std::numeric_limits<double_t>::infinity()),
+      prune_time_(0.0), t_depressed_(-1.0), active_(true),$unread_init
+      statistics_epoch_(-1) {}
+
+template <typename targetidentifierT>
+inline void stdpmodule::${cls}Connection<targetidentifierT>::send(
+    Event &e, thread t, double_t t_lastspike, const CommonSynapseProperties &) {
+
+  double_t t_spike = e.get_stamp().get_ms();
+  Node *target = get_target(t);
+$history
+  double_t delta = t_spike - t_last;
+  assert(delta >= 0);
+$decay_pre
+$on_pre
+  if (t_depressed_ >= 0.0 and t_spike - t_depressed_ >= prune_time_) {
+    active_ = false;
+    t_depressed_ = -1.0;
+    STDPStatistics::prune(stdp_model_, t, statistics_epoch_, weight_,
+                          $statistics_bounds);
+    return;
+  }
+
+  e.set_receiver(*target);
+  e.set_weight(weight_);
+  e.set_delay(get_delay_steps());
+  e.set_rport(get_rport());
+  e();
+}
+
+template <typename targetidentifierT>
+void stdpmodule::${cls}Connection<targetidentifierT>::get_status(
+    DictionaryDatum &d) const {
+  ConnectionBase::get_status(d);
+  def<double_t>(d, names::weight, weight_);
+$get  def<double_t>(d, stdpnames::prune_threshold, prune_threshold_);
+  def<double_t>(d, stdpnames::prune_time, prune_time_);
+  def<bool>(d, stdpnames::active, active_);
+  def<double_t>(d, stdpnames::t_depressed, t_depressed_);
+
+  def<long_t>(d, names::size_of, sizeof(*this));
+}
+
+template <typename targetidentifierT>
+void stdpmodule::${cls}Connection<targetidentifierT>::set_status(
+    const DictionaryDatum &d, ConnectorModel &cm) {
+  ConnectionBase::set_status(d, cm);
+  updateValue<double_t>(d, names::weight, weight_);
+$set  updateValue<double_t>(d, stdpnames::prune_threshold, prune_threshold_);
+  updateValue<double_t>(d, stdpnames::prune_time, prune_time_);
+  updateValue<bool>(d, stdpnames::active, active_);
+  updateValue<double_t>(d, stdpnames::t_depressed, t_depressed_);
+$check
+  if (!(prune_time_ >= 0)) {
+    throw BadProperty("Parameter prune_time must be positive.");
+  }
+}
+
+#endif /* ${guard} */
+"""
+
+history_template = """
+  // pruned connections leave the history unread from their last spike
+  if (!active_) {
+    if (t_unread_ < 0.0) {
+      t_unread_ = t_lastspike;
+    }
+    return;
+  }
+
+  double_t dendritic_delay = get_delay();
+  std::deque<histentry>::iterator start;
+  std::deque<histentry>::iterator finish;
+
+  // a revived connection marks the history it skipped as read
+  if (t_unread_ >= 0.0) {
+    target->get_history(t_unread_ - dendritic_delay,
+                        t_lastspike - dendritic_delay, &start, &finish);
+    t_unread_ = -1.0;
+  }
+
+  // go through the post-synaptic spikes since the last pre-synaptic spike
+  // (without the added dendritic delay)
+  target->get_history(t_lastspike - dendritic_delay, t_spike - dendritic_delay,
+                      &start, &finish);
+
+  double_t t_last = t_lastspike;
+  for (; start != finish; ++start) {
+    const double_t t_post = start->t_ + dendritic_delay;
+    double_t delta = t_post - t_last;
+    assert(delta >= 0);
+    t_last = t_post;
+
+$decay_post
+$on_post
+  }
+"""
+
+def members(names, indent = 4):
+    return "".join(" " * indent + "double_t %s_;\n" % n for n in names)
+
+def generate(rule, source):
+    """Generated files of a rule, by file name."""
+
+    files = {}
+    name, cls = rule.name, rule.cls
+    parameters = rule.parameter_names
+    traces = rule.trace_names
+    all_names = sorted(set(parameters) | set(traces))
+    constants = ", ".join("%s = %s" % (c, literal(rule.constants[c][0])) for c in sorted(rule.constants)) or "none."
+    if rule.constants:
+        constants += "."
+
+    parameter_doc = doc_lines([(p, "double: %s" % rule.parameters[p][1]) for p in parameters])
+    state_doc = doc_lines([("weight", "double: synaptic weight")] +
+                          [(t, "double: %s (tau %s, on %s-synaptic spikes)" % (
+                              rule.traces[t].get("doc", "trace"), rule.traces[t]["tau"], rule.traces[t]["on"]))
+                           for t in traces])
+    references = "\n".join(" " + r for r in rule.references) or " none"
+    description = textwrap.fill(rule.description, 77, subsequent_indent = " ")
+    common = dict(name = name, cls = cls, source = source, description = description,
+                  parameters = parameter_doc, states = state_doc, constants = constants,
+                  references = references, weight = literal(rule.weight))
+
+    names_file = "%s_names.h" % name
+    files[names_file] = substitute(names_template, file = names_file, source = source, name = name,
+                                   guard = "%s_NAMES_H" % name.upper(),
+                                   names = "\n".join("const Name %s(\"%s\");" % (n, n) for n in all_names))
+
+    # node
+    n_traces = len(traces)
+    node_header = "%s_node.h" % name
+    files[node_header] = substitute(
+        node_header_template, file = node_header, guard = "%s_NODE_H" % name.upper(),
+        parameter_members = members(parameters), trace_members = members(traces),
+        trace_accessors = "".join("  double_t get_%s_() const { return S_.%s_; }\n" % (t, t) for t in traces),
+        n_values = 3 + len(traces),
+        **common)
+
+    read_post = "    const double_t current_post_spikes_n = B_.n_post_spikes_.get_value(lag);\n" \
+        if rule.uses_post() else "    B_.n_post_spikes_.get_value(lag); // no post-synaptic dependence\n"
+    on_post = ""
+    if rule.uses_post():
+        on_post = "\n    if (current_post_spikes_n > 0) {\n%s\n    }\n" % rule.spike(
+            "post", "node", 6, "change_(step, weight, plastic);")
+
+    # constant time constants are folded, the parameters are then unused
+    state_decay = "".join("  %s_ *= std::exp(-%s);\n" % (t, rule.rate(t, "elapsed", "node").replace("P_.", "p."))
+                          for t in traces)
+
+    node_source = "%s_node.cpp" % name
+    files[node_source] = substitute(
+        node_source_template, file = node_source, n_traces = n_traces,
+        recordables = "".join("  insert_(%s_names::%s, &stdpmodule::%sNeuron::get_%s_);\n" % (name, t, cls, t)
+                              for t in traces),
+        parameter_init = "\n    : " + ", ".join(["%s_(%s)" % (p, literal(rule.parameters[p][0])) for p in parameters] +
+                                             ["prune_threshold_(-std::numeric_limits<double_t>::infinity())",
+                                              "prune_time_(0.0)"]),
+        parameter_get = "".join("  def<double_t>(d, %s_names::%s, %s_);\n" % (name, p, p) for p in parameters),
+        parameter_set = "".join("  updateValue<double_t>(d, %s_names::%s, %s_);\n" % (name, p, p) for p in parameters),
+        parameter_check = ("".join("\n  if (!(%s_ > 0)) {\n    throw BadProperty(\"Parameter %s must be strictly positive.\");\n  }\n" % (p, p)
+                                   for p in parameters if any(str(rule.traces[t]["tau"]) == p for t in traces))) +
+                          ("\n  if (!(%s >= %s)) {\n    throw BadProperty(\"Parameter %s must be larger than %s.\");\n  }\n" % (
+                              rule.bound(1, "connection"), rule.bound(0, "connection"), rule.bounds[1], rule.bounds[0])
+                           if rule.bounds else ""),
+        trace_init = "".join(", %s_(0.0)" % t for t in traces),
+        trace_get = "".join("  def<double_t>(d, %s_names::%s, %s_);\n" % (name, t, t) for t in traces),
+        trace_set = "".join("  updateValue<double_t>(d, %s_names::%s, %s_);\n" % (name, t, t) for t in traces),
+        trace_check = "".join("\n  if (!(%s_ >= 0)) {\n    throw BadProperty(\"State %s must be positive.\");\n  }\n" % (t, t)
+                              for t in traces),
+        state_decay = state_decay,
+        decay_p = "p" if "p." in state_decay else "/* p */",
+        trace_write = "".join("  values[%d] = s.%s_;\n" % (k + 1, t) for k, t in enumerate(traces)),
+        trace_read = "".join("  S_.%s_ = values[%d];\n" % (t, k + 1) for k, t in enumerate(traces)),
+        active_value = 1 + len(traces), depressed_value = 2 + len(traces),
+        statistics_bounds = rule.statistics_bounds("node"),
+        plastic_values = "".join("  if (name == %s_names::%s) {\n    return &S_.%s_;\n  }\n" % (name, t, t) for t in traces),
+        table = "".join("    V_.decays_[%d * n + %d] = std::exp(%s);\n" % (n_traces, k, rule.rate(t, "n * negative_delta", "node"))
+                        for k, t in enumerate(traces)),
+        table_decay = "".join("  S_.%s_ *= V_.decays_[%d * n + %d];\n" % (t, n_traces, k) for k, t in enumerate(traces)),
+        read_post = read_post,
+        any_spike = "current_pre_spikes_n > 0 or current_post_spikes_n > 0" if rule.uses_post() else "current_pre_spikes_n > 0",
+        on_pre = rule.spike("pre", "node", 6, "change_(step, weight, plastic);") + "\n",
+        on_post = on_post,
+        **common)
+
+    # connection
+    history = ""
+    register = ""
+    unread_member = ""
+    unread_init = ""
+    if rule.uses_post():
+        history = substitute(history_template,
+                             decay_post = "\n".join(rule.decay(t, "delta", 4) for t in traces),
+                             on_post = rule.spike("post", "connection", 4, "change_(t, t_post, weight);"))
+        register = "    t.register_stdp_connection(t_lastspike - get_delay());\n"
+        unread_member = "  // time since which the post-synaptic history is unread, -1 when read\n" \
+                        "  double_t t_unread_;\n"
+        unread_init = " t_unread_(-1.0),"
+    else:
+        history = "\n  // the rule does not depend on post-synaptic spikes\n  if (!active_) {\n    return;\n  }\n" \
+                  "  double_t t_last = t_lastspike;\n"
+
+    connection = "%s_connection.h" % name
+    files[connection] = substitute(
+        connection_template, file = connection, guard = "%s_CONNECTION_H" % name.upper(),
+        register = register,
+        parameter_members = members(parameters, 2), trace_members = members(traces, 2),
+        statistics_bounds = rule.statistics_bounds("connection"),
+        initializers = "".join(",\n      %s_(%s)" % (p, literal(rule.parameters[p][0])) for p in parameters) +
+                       "".join(",\n      %s_(0.0)" % t for t in traces),
+        history = history, unread_member = unread_member, unread_init = unread_init,
+        decay_pre = "\n".join(rule.decay(t, "delta", 2) for t in traces),
+        on_pre = rule.spike("pre", "connection", 2, "change_(t, t_spike, weight);") + "\n",
+        get = "".join("  def<double_t>(d, %s_names::%s, %s_);\n" % (name, n, n) for n in all_names),
+        set = "".join("  updateValue<double_t>(d, %s_names::%s, %s_);\n" % (name, n, n) for n in all_names),
+        check = ("\n  if (!(%s >= %s)) {\n    throw BadProperty(\"Parameter %s must be larger than %s.\");\n  }\n" % (
+                    rule.bound(1, "connection"), rule.bound(0, "connection"), rule.bounds[1], rule.bounds[0])
+                 if rule.bounds else ""),
+        **common)
+
+    return files
+
+def replace_between(text, begin, end, lines):
+    """Replace the lines between two marker lines, keeping the markers."""
+    start = text.index(begin)
+    start = text.index("\n", start) + 1
+    stop = text.index(end, start)
+    stop = text.rindex("\n", 0, stop) + 1
+    return text[:start] + "".join(lines) + text[stop:]
+
+def registrations(rules):
+    """Generated sections of stdpmodule.cpp and Makefile.am for all rules."""
+
+    path = os.path.join(root, "stdpmodule.cpp")
+    with open(path) as f:
+        module = f.read()
+    module = replace_between(module, "// generated includes begin", "// generated includes end",
+                             ['#include "%s_node.h"\n#include "%s_connection.h"\n' % (r.name, r.name) for r in rules])
+    module = replace_between(module, "  // generated models begin", "  // generated models end", [
+        "  nest::register_model<%sNeuron>(\n"
+        "      nest::NestModule::get_network(), \"%s_node\");\n"
+        "  %sNeuron::register_stdp_model(\"%s_node\");\n"
+        "  nest::register_connection_model<\n"
+        "      %sConnection<nest::TargetIdentifierPtrRport> >(\n"
+        "      nest::NestModule::get_network(), \"%s_synapse\");\n"
+        "  %sConnection<nest::TargetIdentifierPtrRport>::register_stdp_model(\n"
+        "      \"%s_synapse\");\n" % (r.cls, r.name, r.cls, r.name, r.cls, r.name, r.cls, r.name)
+        for r in rules])
+
+    path = os.path.join(root, "Makefile.am")
+    with open(path) as f:
+        makefile = f.read()
+    makefile = replace_between(makefile, "# generated sources begin", "# generated sources end", [
+        "generated_files+= %s_names.h %s_node.h %s_node.cpp %s_connection.h\n" % ((r.name,) * 4) for r in rules])
+
+    return { "stdpmodule.cpp": module, "Makefile.am": makefile }
+
+def main():
+    parser = argparse.ArgumentParser(description = __doc__.strip().split("\n")[0])
+    parser.add_argument("rules", nargs = "+", help = "rule descriptions (JSON), all generated rules")
+    parser.add_argument("--check", action = "store_true", help = "only report files that are not up to date")
+    args = parser.parse_args()
+
+    files = {}
+    rules = []
+    for path in sorted(args.rules):
+        with open(path) as f:
+            rule = Rule(json.load(f), path)
+        rules.append(rule)
+        files.update(generate(rule, os.path.relpath(os.path.abspath(path), root)))
+    files.update(registrations(rules))
+
+    stale = []
+    for name, content in sorted(files.items()):
+        path = os.path.join(root, name)
+        current = open(path).read() if os.path.exists(path) else None
+        if current == content:
+            continue
+        stale.append(name)
+        if not args.check:
+            with open(path, "w") as f:
+                f.write(content)
+
+    for name in stale:
+        print("%s %s" % ("stale" if args.check else "wrote", name))
+    return 1 if args.check and stale else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
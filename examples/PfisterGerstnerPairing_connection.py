@@ -9,17 +9,21 @@ Reproduce result of the pairing experiment from Pfister-Gerstner (2006) with the
 nest.Install("stdpmodule")
 nest.set_verbosity("M_WARNING")
 
+# precise spike times give the 0.1 ms results at a coarser resolution
+resolution = 1.0 # ms
+precise = True
+neuron_model = "parrot_neuron_ps" if precise else "parrot_neuron"
+
 def generateSpikes(neuron, times):
     """Trigger spike to given neuron at specified times."""
     delay = 1.0
-    gen = nest.Create("spike_generator", 1, { "spike_times": [t - delay for t in times] })
+    gen = nest.Create("spike_generator", 1, { "spike_times": [t - delay for t in times], "precise_times": precise })
     nest.Connect(gen, neuron, syn_spec = { "delay": delay })
 
 def create(model, number):
     """Allow multiple model instance to be unpack as they are created."""
     return map(lambda x: (x,), nest.Create(model, number))
 
-neuron_model = "parrot_neuron"
 synapse_model = "stdp_triplet_all_in_one_synapse"
 syn_spec = {
     "model": synapse_model,
@@ -49,11 +53,13 @@ weights_minus = []
 def evaluate(rho, dt):
     """Evaluate connection change of weight and returns it."""
     nest.ResetKernel()
-    nest.SetKernelStatus({"local_num_threads" : 1, "resolution" : 0.1, "print_time": False})
+    nest.SetKernelStatus({"local_num_threads" : 1, "resolution" : resolution, "print_time": False})
 
     step = 1000.0 / rho
     simulation_duration = np.ceil(n * step)
-    times_pre = np.arange(start_spikes, simulation_duration, step).round(1)
+    times_pre = np.arange(start_spikes, simulation_duration, step)
+    if not precise:
+        times_pre = (times_pre / resolution).round() * resolution
     times_post = [t + dt for t in times_pre]
 
     # Entities
@@ -78,7 +78,7 @@ def evaluate(rho, dt, syn_spec):
 
     # Simulation
     current_weight = nest.GetStatus(triplet_synapse, keys = "weight")[0]
-    nest.Simulate(start_spikes + simulation_duration)
+    nest.STDPSimulate(start_spikes + simulation_duration)
 
     # Results
     end_weight = nest.GetStatus(triplet_synapse, keys = "weight")[0]
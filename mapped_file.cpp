@@ -0,0 +1,66 @@
+//
+//  mapped_file.cpp
+//  NEST
+//
+//
+
+#include "mapped_file.h"
+
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sliexceptions.h"
+
+stdpmodule::MappedFile::MappedFile(const std::string &filename)
+    : filename_(filename), data_(0), size_(0) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw IOError();
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    throw IOError();
+  }
+
+  size_ = info.st_size;
+  if (size_ == 0) {
+    close(fd);
+    return;
+  }
+
+  void *mapped = mmap(0, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    throw IOError();
+  }
+  data_ = static_cast<const char *>(mapped);
+}
+
+stdpmodule::MappedFile::~MappedFile() {
+  if (data_ != 0) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+}
+
+void stdpmodule::MappedFile::advise_sequential() const {
+  if (data_ != 0) {
+    madvise(const_cast<char *>(data_), size_, MADV_SEQUENTIAL);
+  }
+}
+
+void stdpmodule::MappedFile::release(size_t from, size_t to) const {
+  // madvise works on whole pages, keep the partial ones
+  const size_t page = sysconf(_SC_PAGESIZE);
+  const size_t first = (from + page - 1) / page * page;
+  const size_t last = std::min(to, size_) / page * page;
+
+  if (data_ != 0 and first < last) {
+    madvise(const_cast<char *>(data_) + first, last - first, MADV_DONTNEED);
+  }
+}
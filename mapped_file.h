@@ -0,0 +1,51 @@
+//
+//  mapped_file.h
+//  NEST
+//
+//
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace stdpmodule {
+
+/**
+ * Read-only memory mapping of a whole file, unmapped on destruction.
+ */
+class MappedFile {
+public:
+  /**
+   * @throws IOError if the file cannot be opened or mapped.
+   */
+  explicit MappedFile(const std::string &filename);
+  ~MappedFile();
+
+  const char *data() const { return data_; }
+  size_t size() const { return size_; }
+  const std::string &filename() const { return filename_; }
+
+  /**
+   * Hint the kernel that the file will be read front to back.
+   */
+  void advise_sequential() const;
+
+  /**
+   * Drop the pages of the given byte range from memory. They are read from
+   * disk again if accessed later.
+   */
+  void release(size_t from, size_t to) const;
+
+private:
+  MappedFile(const MappedFile &);
+  MappedFile &operator=(const MappedFile &);
+
+  std::string filename_;
+  const char *data_;
+  size_t size_;
+};
+}
+
+#endif /* MAPPED_FILE_H */
@@ -0,0 +1,101 @@
+//
+//  npy_array.cpp
+//  NEST
+//
+//
+
+#include "npy_array.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "exceptions.h"
+
+using namespace nest;
+
+namespace {
+
+const char magic[6] = {'\x93', 'N', 'U', 'M', 'P', 'Y'};
+
+/**
+ * Extract the value of a key from the python dictionary literal of the header.
+ */
+std::string header_value(const std::string &header, const std::string &key) {
+  const size_t start = header.find("'" + key + "'");
+  if (start == std::string::npos) {
+    throw BadProperty("Missing " + key + " in npy header.");
+  }
+
+  const size_t colon = header.find(':', start);
+  size_t end = header.find_first_of(header[colon + 2] == '(' ? ")" : ",}",
+                                    colon + 1);
+  if (header[colon + 2] == '(') {
+    ++end;
+  }
+  return header.substr(colon + 1, end - colon - 1);
+}
+}
+
+stdpmodule::NpyArray::NpyArray(const std::string &filename)
+    : file_(filename), data_(0), single_(false), rows_(0), columns_(1) {
+  const char *data = file_.data();
+
+  if (file_.size() < 10 or std::memcmp(data, magic, sizeof(magic)) != 0) {
+    throw BadProperty(filename + " is not a npy file.");
+  }
+
+  // version 1 stores the header length on 2 bytes, later versions on 4
+  const unsigned char major = data[6];
+  size_t header_length;
+  size_t header_start;
+  if (major == 1) {
+    header_length = static_cast<unsigned char>(data[8]) |
+                    static_cast<unsigned char>(data[9]) << 8;
+    header_start = 10;
+  } else {
+    header_length = static_cast<unsigned char>(data[8]) |
+                    static_cast<unsigned char>(data[9]) << 8 |
+                    static_cast<unsigned char>(data[10]) << 16 |
+                    static_cast<unsigned char>(data[11]) << 24;
+    header_start = 12;
+  }
+
+  if (header_start + header_length > file_.size()) {
+    throw BadProperty(filename + " has a truncated npy header.");
+  }
+
+  const std::string header(data + header_start, header_length);
+
+  const std::string descr = header_value(header, "descr");
+  if (descr.find("<f8") != std::string::npos) {
+    single_ = false;
+  } else if (descr.find("<f4") != std::string::npos) {
+    single_ = true;
+  } else {
+    throw BadProperty(filename + " must contain little-endian floats.");
+  }
+
+  if (header_value(header, "fortran_order").find("False") ==
+      std::string::npos) {
+    throw BadProperty(filename + " must be stored in C order.");
+  }
+
+  // shape is either (rows,) or (rows, columns)
+  const std::string shape = header_value(header, "shape");
+  const char *cursor = shape.c_str() + shape.find('(') + 1;
+  char *next;
+  rows_ = std::strtoul(cursor, &next, 10);
+  cursor = std::strchr(next, ',');
+  if (cursor != 0) {
+    const size_t columns = std::strtoul(cursor + 1, &next, 10);
+    if (next != cursor + 1) {
+      columns_ = columns;
+    }
+  }
+
+  data_ = data + header_start + header_length;
+  const size_t item = single_ ? sizeof(float) : sizeof(double);
+  if (data_ + rows_ * columns_ * item > data + file_.size()) {
+    throw BadProperty(filename + " is truncated.");
+  }
+}
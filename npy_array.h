@@ -0,0 +1,51 @@
+//
+//  npy_array.h
+//  NEST
+//
+//
+
+#ifndef NPY_ARRAY_H
+#define NPY_ARRAY_H
+
+#include <string>
+
+#include "mapped_file.h"
+
+namespace stdpmodule {
+
+/**
+ * Memory-mapped two-dimensional array stored in the NumPy .npy format.
+ * @note Only little-endian float32 and float64 arrays in C order are
+ *       supported, one-dimensional arrays are read as a single column.
+ */
+class NpyArray {
+public:
+  /**
+   * @throws IOError if the file cannot be mapped, BadProperty if its format
+   *         is not supported.
+   */
+  explicit NpyArray(const std::string &filename);
+
+  size_t rows() const { return rows_; }
+  size_t columns() const { return columns_; }
+
+  double get(size_t row, size_t column) const;
+
+private:
+  MappedFile file_;
+  const char *data_;
+  bool single_;
+  size_t rows_;
+  size_t columns_;
+};
+
+inline double NpyArray::get(size_t row, size_t column) const {
+  const size_t i = row * columns_ + column;
+  if (single_) {
+    return reinterpret_cast<const float *>(data_)[i];
+  }
+  return reinterpret_cast<const double *>(data_)[i];
+}
+}
+
+#endif /* NPY_ARRAY_H */
@@ -0,0 +1,61 @@
+//
+//  plastic_node.h
+//  NEST
+//
+//
+
+#ifndef PLASTIC_NODE_H
+#define PLASTIC_NODE_H
+
+#include <cstddef>
+
+#include "name.h"
+
+namespace stdpmodule {
+
+/**
+ * Interface of the STDP nodes of this module giving raw access to their
+ * plastic state (weight, traces and pruning state), bypassing dictionaries.
+ * @note States are written field by field, caught up to the current time and
+ * with their times relative to it, so that they can be restored into another
+ * kernel. Models bump their plastic_state_version when the fields change.
+ */
+class PlasticNode {
+public:
+  virtual ~PlasticNode() {}
+
+  /**
+   * Version of the fields of the plastic state.
+   */
+  virtual unsigned int plastic_state_version() const = 0;
+
+  /**
+   * Number of values of the plastic state.
+   */
+  virtual size_t plastic_state_size() const = 0;
+
+  /**
+   * Write the plastic state at the current time to the given values.
+   */
+  virtual void write_plastic_state(double *) const = 0;
+
+  /**
+   * Restore the plastic state from the given values, at the current time.
+   */
+  virtual void read_plastic_state(const double *) = 0;
+
+  /**
+   * Address of a state variable given by its status dictionary name, null if
+   * the node has no such state. Values written through it are not validated.
+   */
+  virtual double *plastic_value(const Name &) = 0;
+
+  /**
+   * Bytes used by the node, including the storage of its spike buffers and
+   * tables (see stdp_memory).
+   */
+  virtual size_t memory_size() const = 0;
+};
+}
+
+#endif /* PLASTIC_NODE_H */
@@ -6,7 +6,76 @@
 Functions for spike-timing dependent plasticity.
 """
 
+import mmap
+import os
+import tempfile
+import time
+
 import nest
+import numpy as np
+
+snapshot_header = np.dtype([("magic", "S8"), ("version", "<u4"), ("rank", "<u4"), ("n_threads", "<u4"),
+                            ("padding", "<u4"), ("capacity", "<u8"), ("reserved", "<u8", 4)])
+snapshot_section = np.dtype([("sequence", "<u8"), ("time", "<f8"), ("n", "<u8"), ("active", "<u8"),
+                             ("n_dropped", "<u8"), ("reserved", "<u8", 3)])
+snapshot_key = np.dtype([("source", "<u8"), ("target", "<u8")])
+
+def ReadSTDPSnapshot(filename, timeout = 10.0):
+    """Read a consistent snapshot of the weights published by stdp_weight_snapshot.
+
+    Reads the shared memory file `<prefix>.<rank>.weights` of a rank while the
+    simulation goes on, e.g. from a dashboard process, without the kernel.
+    Sections of all threads are copied until they agree on the snapshot time.
+    Returns a dict of `time` and arrays `source`, `target` (0 for STDP nodes,
+    `source` is then the node) and `weight`, one entry per synapse.
+    """
+    with open(filename, "rb") as f:
+        data = mmap.mmap(f.fileno(), 0, access = mmap.ACCESS_READ)
+
+    try:
+        deadline = time.time() + timeout
+        header = np.frombuffer(data, snapshot_header, 1).copy()[0]
+        while header["magic"] != b"STDPSNAP":
+            if time.time() > deadline:
+                raise IOError("%s is not a weight snapshot" % filename)
+            time.sleep(0.01)
+            header = np.frombuffer(data, snapshot_header, 1).copy()[0]
+
+        capacity = int(header["capacity"])
+        size = snapshot_section.itemsize + capacity * (snapshot_key.itemsize + 16)
+
+        def read_section(offset):
+            """Copy the active buffer of a section, retrying while it flips."""
+            while True:
+                section = np.frombuffer(data, snapshot_section, 1, offset).copy()[0]
+                if section["sequence"] % 2 == 0:
+                    n = int(section["n"])
+                    keys = np.frombuffer(data, snapshot_key, n, offset + snapshot_section.itemsize).copy()
+                    buffer = offset + snapshot_section.itemsize + capacity * snapshot_key.itemsize
+                    buffer += int(section["active"]) * capacity * 8
+                    weights = np.frombuffer(data, "<f8", n, buffer).copy()
+                    if np.frombuffer(data, "<u8", 1, offset)[0] == section["sequence"]:
+                        return (section["time"], keys, weights)
+                if time.time() > deadline:
+                    raise IOError("%s is not being published" % filename)
+
+        while True:
+            sections = [read_section(snapshot_header.itemsize + t * size) for t in range(header["n_threads"])]
+            times = set(section[0] for section in sections)
+            if len(times) == 1:
+                break
+            if time.time() > deadline:
+                raise IOError("threads of %s do not agree on a snapshot" % filename)
+
+        keys = np.concatenate([section[1] for section in sections])
+        return {
+            "time": float(sections[0][0]),
+            "source": keys["source"],
+            "target": keys["target"],
+            "weight": np.concatenate([section[2] for section in sections]),
+        }
+    finally:
+        data.close()
 
 def HelloSTDP():
     """Enable all spiking-time dependent plasticity features."""
@@ -16,14 +85,81 @@ def HelloSTDP():
     # save old functions
     nest_connect = nest.Connect
 
-    def _connect(pre, post, conn_spec = None, syn_spec = None, model = None, pre_syn_spec = None, syn_post_spec = None):
-        """Wrap nest connect and allow to create fake neuron-synapse."""
+    def _vps(gids):
+        """Return the virtual processes of nodes under NEST's round-robin placement."""
+        n_vps = nest.GetKernelStatus("total_num_virtual_procs")
+        return [gid % n_vps for gid in gids]
+
+    def _balance(vps, loads, n_vps, tolerance):
+        """Move nodes off their virtual process when it gets too loaded.
+
+        Nodes are assigned by decreasing load, each one stays on its virtual
+        process unless that exceeds the mean load by `tolerance`, in which
+        case it goes to the least loaded virtual process.
+        """
+        limit = (1.0 + tolerance) * sum(loads) / n_vps
+        totals = [0.0] * n_vps
+        placed = list(vps)
+        for i in sorted(range(len(vps)), key = lambda i: -loads[i]):
+            vp = vps[i]
+            if totals[vp] + loads[i] > limit:
+                vp = totals.index(min(totals))
+            totals[vp] += loads[i]
+            placed[i] = vp
+        return placed
+
+    def _create_on(model, vps, params):
+        """Create one node of model on each given virtual process.
+
+        Consecutive GIDs cycle through the virtual processes, blocks of
+        total_num_virtual_procs nodes are thus created until the most demanded
+        virtual process is served. Spare nodes are deactivated (see `active`)
+        and release their buffers at the first simulation, but keep their node
+        object and GID: `max(demand) * n_vps - len(vps)` of them, i.e. up to
+        n_vps - 1 spares per node when all nodes go to one virtual process
+        (e.g. many pre-synaptic neurons onto one post-synaptic neuron).
+        """
+        n_vps = nest.GetKernelStatus("total_num_virtual_procs")
+        demand = [0] * n_vps
+        for vp in vps:
+            demand[vp] += 1
+
+        created = nest.Create(model, max(demand) * n_vps, params = params)
+        free = [[] for vp in range(n_vps)]
+        for gid, vp in zip(reversed(created), reversed(_vps(created))):
+            free[vp].append(gid)
+
+        nodes = [free[vp].pop() for vp in vps]
+        spares = [gid for gids in free for gid in gids]
+        if spares:
+            nest.SetStatus(spares, { "active": False })
+        return nodes
+
+    def _connect(pre, post, conn_spec = None, syn_spec = None, model = None, pre_syn_spec = None, syn_post_spec = None,
+                 placement = None, rates = None, tolerance = 0.1, per_pair = False):
+        """Wrap nest connect and allow to create fake neuron-synapse.
+
+        With a node model and 'all_to_all', one synapse node per post-synaptic
+        neuron receives all pre-synaptic neurons, `per_pair` creates one node
+        per pre/post pair instead so that each pair learns its own weight
+        ('one_to_one' always creates one node per pair). Synapse nodes keep NEST's round-robin placement
+        (`placement` None) or are placed on the virtual process of their
+        post-synaptic neuron (`placement` "post") so that traffic between them
+        stays on one thread and rank, optionally balanced by the expected rate
+        of each pre-synaptic neuron (`placement` "rate", `rates` either a
+        scalar or one rate per pre-synaptic neuron). Placed nodes come with
+        inactive spare nodes, see `_create_on`, the more so as fan-in is
+        skewed across virtual processes.
+        """
 
         if model is not None and model.endswith("_node"):
 
             if conn_spec != None and conn_spec != 'all_to_all' and conn_spec != 'one_to_one':
                 raise nest.NESTError('Unsupported conn_spec for stdp dsl: %s' % conn_spec)
 
+            if placement not in (None, "post", "rate"):
+                raise nest.NESTError('Unsupported placement for stdp dsl: %s' % placement)
+
             pre_syn_spec = {} if pre_syn_spec is None else pre_syn_spec.copy()
             syn_post_spec = {} if syn_post_spec is None else syn_post_spec.copy()
             syn_spec = {} if syn_spec is None else syn_spec.copy()
@@ -39,23 +175,357 @@ def HelloSTDP():
                 "receptor_type": 1 # differentiate post-synaptic feedback
             }
 
-            connectionCount = len(post) if conn_spec == 'one_to_one' else len(post)**2
-            synapse = nest.Create("stdp_triplet_node", connectionCount, params = syn_spec)
+            # pre-synaptic neurons of each synapse node, by post-synaptic neuron
+            if conn_spec == 'one_to_one':
+                if len(pre) != len(post):
+                    raise nest.NESTError('one_to_one requires equal numbers of pre and post neurons')
+                sources = [[i] for i in range(len(pre))]
+                targets = range(len(post))
+            elif per_pair:
+                sources = [[i] for j in range(len(post)) for i in range(len(pre))]
+                targets = [j for j in range(len(post)) for i in range(len(pre))]
+            else:
+                sources = [range(len(pre))] * len(post)
+                targets = range(len(post))
+            posts = [post[j] for j in targets]
+
+            if placement is None:
+                synapse = nest.Create(model, len(posts), params = syn_spec)
+            else:
+                vps = _vps(posts)
+                if placement == "rate":
+                    rates = np.resize(np.asarray(1.0 if rates is None else rates, dtype = np.float64), len(pre))
+                    n_vps = nest.GetKernelStatus("total_num_virtual_procs")
+                    vps = _balance(vps, [sum(rates[i] for i in s) for s in sources], n_vps, tolerance)
+                synapse = tuple(_create_on(model, vps, syn_spec))
 
-            nest_connect(pre, synapse, conn_spec, pre_syn_spec)
-            nest_connect(synapse, post, 'one_to_one', syn_post_spec)
-            nest_connect(post, synapse, 'one_to_one', post_syn_spec)
+            if all(len(s) == 1 for s in sources):
+                nest_connect([pre[s[0]] for s in sources], synapse, 'one_to_one', pre_syn_spec)
+            else:
+                nest_connect(pre, synapse, 'all_to_all', pre_syn_spec)
+            nest_connect(synapse, posts, 'one_to_one', syn_post_spec)
+            nest_connect(posts, synapse, 'one_to_one', post_syn_spec)
             return synapse
 
         else:
 
             return nest_connect(pre, post, conn_spec, syn_spec, model)
 
+    spike_dtype = np.dtype([("time", "<f8"), ("gid", "<u8")])
+    replayer_model = "stdp_spikes_replayer"
+    generator_model = "stdp_spikes_generator"
+    replay = {}
+
+    def _replay_spikes(filename, params = None):
+        """Replay spikes of the given file (see stdp_spike_replayer) and return the device."""
+        params = {} if params is None else params.copy()
+        params.update({ "filename": filename })
+        return nest.Create("stdp_spike_replayer", 1, params)
+
+    def _replay_state():
+        """Return the devices and pending spikes of nest.Spikes in this kernel.
+
+        Devices are created from private copies of their models, ResetKernel
+        removes the copies along with the devices, the state is then dropped.
+        """
+        if replayer_model not in nest.Models("nodes"):
+            nest.CopyModel("stdp_spike_replayer", replayer_model)
+            nest.CopyModel("spike_generator", generator_model)
+            replay.clear()
+        if not replay:
+            replay.update({ "records": [], "replayer": None, "queued": np.empty(0, dtype = spike_dtype),
+                            "generators": {} })
+        return replay
+
+    def _delay_horizon():
+        """Return an upper bound of the min delay of the next simulation (ms).
+
+        The kernel updates its min delay when a simulation starts, it is not
+        above the largest delay of any synapse model.
+        """
+        status = nest.GetKernelStatus()
+        delays = [status["min_delay"], status["max_delay"]]
+        delays += [nest.GetDefaults(model, "max_delay") for model in nest.Models("synapses")]
+        return max(delay for delay in delays if np.isfinite(delay))
+
     def _spikes(neurons, times):
-        """Trigger spike to given neurons at specified times."""
-        delay = nest.GetKernelStatus('resolution')
-        gen = nest.Create("spike_generator", 1, { "spike_times": [t-delay for t in times] })
-        nest.Connect(gen, neurons, syn_spec = { "delay": delay })
+        """Trigger spike to given neurons at specified times.
+
+        Spikes are gathered until the next nest.STDPSimulate. Those due within
+        its first min delay are sent by spike_generator, later ones are
+        replayed from a memory-mapped file by a stdp_spike_replayer.
+        """
+        times = np.asarray(times, dtype = np.float64)
+        status = nest.GetKernelStatus()
+        tics = status["tics_per_ms"]
+        if np.any(np.rint(times * tics) <= np.rint((status["time"] + status["resolution"]) * tics)):
+            raise nest.NESTError('Spike times must be later than the next step: %s' % times)
+
+        state = _replay_state()
+        for neuron in neurons:
+            records = np.empty(len(times), dtype = spike_dtype)
+            records["time"] = times
+            records["gid"] = neuron
+            state["records"].append(records)
+
+    def _flush_spikes():
+        """Send pending spikes of nest.Spikes and return the new spike file, if any.
+
+        Spikes not replayed yet are merged with the new ones, the replayer of
+        the kernel then reads them from a new file and generators of the
+        target neurons are given the early ones.
+        """
+        state = _replay_state()
+        if not state["records"]:
+            return None
+
+        records = np.concatenate(state["records"])
+        state["records"] = []
+        if state["replayer"] is not None:
+            position = nest.GetStatus(state["replayer"], "position")[0]
+            records = np.concatenate([state["queued"][position:], records])
+        records = records[np.argsort(records["time"], kind = "mergesort")]
+
+        # the replayer reads one min delay ahead, earlier spikes go through generators
+        status = nest.GetKernelStatus()
+        tics = status["tics_per_ms"]
+        now = np.rint(status["time"] * tics)
+        horizon = np.rint((status["time"] + _delay_horizon()) * tics)
+        early = np.searchsorted(np.rint(records["time"] * tics), horizon, side = "right")
+        delay = status["resolution"]
+        generators = state["generators"]
+        for gid in np.unique(records["gid"][:early]):
+            times = records["time"][:early][records["gid"][:early] == gid]
+            if gid not in generators:
+                gen = nest.Create(generator_model)
+                nest_connect(gen, (int(gid),), syn_spec = { "delay": delay })
+                generators[gid] = (gen, np.empty(0))
+
+            # spikes already emitted are dropped from the generator
+            gen, pending = generators[gid]
+            pending = pending[np.rint((pending - delay) * tics) > now]
+            pending = np.sort(np.concatenate([pending, times]))
+            nest.SetStatus(gen, { "spike_times": (np.rint((pending - delay) * tics) / tics).tolist() })
+            generators[gid] = (gen, pending)
+
+        records = records[early:]
+        if state["replayer"] is None:
+            if len(records) == 0:
+                return None
+            state["replayer"] = nest.Create(replayer_model)
+
+        # an empty name first, the new file may reuse the name of a removed one
+        filename = None
+        nest.SetStatus(state["replayer"], { "filename": "" })
+        if len(records) > 0:
+            fd, filename = tempfile.mkstemp(suffix = ".spikes")
+            with os.fdopen(fd, "wb") as f:
+                records.tofile(f)
+            nest.SetStatus(state["replayer"], { "filename": filename })
+        state["queued"] = records
+        return filename
+
+    def _stdp_simulate(t):
+        """Simulate the network for t milliseconds, with the spikes of nest.Spikes.
+
+        The spike file is removed once the simulation has mapped it, spikes
+        still queued thus raise an error after nest.ResetNetwork.
+        """
+        filename = _flush_spikes()
+        try:
+            nest.Simulate(t)
+        finally:
+            if filename is not None:
+                os.remove(filename)
+
+    def _set_stdp_statistics(params):
+        """Configure, enable or disable the weight statistics of STDP models."""
+        nest.sli_func("SetSTDPStatistics", params)
+
+    def _get_stdp_statistics():
+        """Return the weight statistics of every STDP model merged over threads."""
+        return nest.sli_func("GetSTDPStatistics")
+
+    def _reset_stdp_statistics():
+        """Drop the weight statistics accumulated so far."""
+        nest.sli_func("ResetSTDPStatistics")
+
+    def _set_stdp_plasticity(params):
+        """Toggle plasticity of STDP models or set their learning windows.
+
+        Model schedules may be given as a list of (start, stop) windows.
+        """
+        params = params.copy()
+        for key, schedule in params.items():
+            if key != "plastic":
+                params[key] = [float(t) for t in np.ravel(schedule)]
+        nest.sli_func("SetSTDPPlasticity", params)
+
+    def _get_stdp_plasticity():
+        """Return the plasticity toggle and the schedule of every STDP model."""
+        return nest.sli_func("GetSTDPPlasticity")
+
+    def _get_stdp_memory():
+        """Return the bytes used by every STDP model and the spike histories on this rank."""
+        return nest.sli_func("GetSTDPMemory")
+
+    def _plan_stdp_memory(neurons, indegree, approach = "node", model = "stdp_triplet_node", threads = 1, ranks = 1,
+                          rate = 10.0, min_delay = 1.0, max_delay = 2.0, resolution = 0.1, subsampling = 1,
+                          neuron_bytes = 1000, placement = None):
+        """Predict the memory of a network of `neurons` with `indegree` STDP synapses each, before building it.
+
+        `approach` is "node" (synapse nodes of `model` connected per pair through the DSL) or "connection"
+        (stdp_triplet_all_in_one_synapse). Instance sizes come from the module (GetSTDPMemory),
+        the kernel containers and the neurons (`neuron_bytes` each) are estimated. Post-synaptic
+        histories hold the spikes of `rate` Hz neurons until the slowest of their `indegree`
+        pre-synaptic neurons fires again. Nodes placed on their post-synaptic virtual process
+        (`placement` as in nest.Connect) add inactive spare nodes, without buffers, for the virtual
+        processes serving fewer post-synaptic neurons. Returns bytes per rank, in total and at the
+        peak of the build, with their breakdown.
+        """
+        if approach not in ("node", "connection"):
+            raise nest.NESTError('Unsupported approach for memory planning: %s' % approach)
+
+        sizes = nest.sli_func("GetSTDPMemory")["sizes"]
+        deque_bytes = 64 + 512 # map and first block allocated by every std::deque
+        connector_bytes = 48 # per source with connections on a thread
+        python_int_bytes = 32 # per GID held in DSL lists while building
+
+        vps = threads * ranks
+        synapses = float(neurons) * indegree / ranks
+        local_neurons = float(neurons) / ranks
+        reached = 1.0 - (1.0 - 1.0 / vps) ** indegree # threads a neuron has targets on
+        breakdown = { "neurons": local_neurons * (neuron_bytes + deque_bytes) }
+
+        if approach == "connection":
+            entries = np.log(indegree) + np.euler_gamma + rate * max_delay / 1000.0
+            breakdown["synapses"] = synapses * sizes["stdp_triplet_all_in_one_synapse"]
+            breakdown["history"] = local_neurons * entries * sizes["histentry"]
+            breakdown["connectors"] = neurons * threads * reached * connector_bytes
+            build = 0.0
+        else:
+            slots = int(np.ceil((min_delay + max_delay) / resolution))
+            node = sizes[model] + deque_bytes + 2 * slots * sizes["spike_slot"] + 4 * (subsampling + 1) * 8
+            breakdown["synapses"] = synapses * node
+            breakdown["connections"] = 3 * synapses * sizes["static_synapse"]
+            breakdown["connectors"] = (synapses + 2 * neurons * threads * reached) * connector_bytes
+            if placement is not None:
+                demand = np.ceil(float(neurons) / vps) * indegree # synapses of the busiest virtual process
+                breakdown["spares"] = (demand * vps - float(neurons) * indegree) / ranks * sizes[model]
+            build = 3 * float(neurons) * indegree * python_int_bytes # pair lists on every rank
+
+        per_rank = sum(breakdown.values())
+        return {
+            "per_rank": per_rank,
+            "total": per_rank * ranks,
+            "peak_per_rank": per_rank + build,
+            "breakdown": breakdown,
+        }
+
+    def _checkpoint(prefix):
+        """Save the plasticity state of this rank to `prefix`.<rank>.stdp."""
+        return nest.sli_func("STDPCheckpoint", prefix)
+
+    def _restore(prefix):
+        """Restore the plasticity state of this rank from `prefix`.<rank>.stdp."""
+        return nest.sli_func("STDPRestore", prefix)
+
+    def _set_stdp_states(targets, values, keys = ("weight",)):
+        """Set plastic states of STDP nodes or connections in bulk.
+
+        `values` is an array of shape (len(targets), len(keys)) or the path of a
+        .npy file of that shape, which is memory-mapped instead of being read.
+        """
+        if not isinstance(values, str):
+            values = np.ascontiguousarray(values, dtype = np.float64).ravel()
+        nest.sli_func("SetSTDPStates", list(targets), list(keys), values)
+
+    def _freeze_stdp(synapses):
+        """Replace plastic synapses by static_synapse connections with their learned weights.
+
+        `synapses` are either STDP nodes (as returned by nest.Connect with a
+        node model) or stdp_triplet_all_in_one_synapse connections. Synapses
+        already pruned (`active` false) are skipped. Static connections take
+        the combined axonal and dendritic delay, through the stdp_post_hub of
+        nodes that have one (see `hub`), the plastic synapses are
+        deactivated (see `active`): they stop updating and nodes release their
+        buffers at the next simulation. NEST 2.10 cannot delete nodes nor
+        connections, plastic connections and the connections of nodes stay in
+        their connectors and still receive spikes.
+        """
+        synapses = list(synapses)
+        if not synapses:
+            return
+
+        active = nest.GetStatus(synapses, "active")
+        synapses = [synapse for synapse, alive in zip(synapses, active) if alive]
+        if not synapses:
+            return
+
+        if isinstance(synapses[0], (int, long, np.integer)):
+
+            weights = dict(zip(synapses, nest.GetStatus(synapses, "weight")))
+
+            # pre -> synapse on port 0, post -> synapse feedback on port 1
+            axons = {}
+            incoming = nest.GetConnections(target = synapses)
+            for source, target, delay, receptor in nest.GetStatus(incoming, ["source", "target", "delay", "receptor"]):
+                if receptor == 0:
+                    axons[target] = (source, delay)
+
+            # nodes of a stdp_post_hub reach their post-synaptic neuron through the hub connection,
+            # aggregation_delay after their spikes
+            hubs = dict(zip(synapses, nest.GetStatus(synapses, "hub")))
+            sources = list(synapses)
+            aggregation = {}
+            for hub in set(hubs.values()) - set([0]):
+                aggregation[hub] = nest.GetStatus([hub], "aggregation_delay")[0]
+                sources.append(hub)
+
+            outputs = {}
+            outgoing = nest.GetConnections(source = sources)
+            for source, target, delay, receptor in nest.GetStatus(outgoing, ["source", "target", "delay", "receptor"]):
+                outputs.setdefault(source, []).append((target, aggregation.get(source, 0.0) + delay, receptor))
+
+            frozen = {}
+            for synapse in synapses:
+                source = hubs[synapse] or synapse
+                if source not in outputs:
+                    raise nest.NESTError('Node %d has no connection to its post-synaptic neuron' % synapse)
+                pre, axonal_delay = axons[synapse]
+                for target, delay, receptor in outputs[source]:
+                    frozen.setdefault(receptor, []).append((pre, target, weights[synapse], axonal_delay + delay))
+
+        else:
+
+            frozen = {}
+            for source, target, weight, delay, receptor in nest.GetStatus(synapses, ["source", "target", "weight", "delay", "receptor"]):
+                frozen.setdefault(receptor, []).append((source, target, weight, delay))
+
+        for receptor, connections in frozen.items():
+            pre, post, weights, delays = zip(*connections)
+            nest_connect(list(pre), list(post), 'one_to_one', {
+                "model": "static_synapse",
+                "weight": np.array(weights),
+                "delay": np.array(delays),
+                "receptor_type": receptor
+            })
+
+        nest.SetStatus(synapses, { "active": False })
 
     nest.Connect = _connect
     nest.Spikes = _spikes
+    nest.ReplaySpikes = _replay_spikes
+    nest.STDPSimulate = _stdp_simulate
+    nest.SetSTDPStatistics = _set_stdp_statistics
+    nest.GetSTDPStatistics = _get_stdp_statistics
+    nest.ResetSTDPStatistics = _reset_stdp_statistics
+    nest.SetSTDPPlasticity = _set_stdp_plasticity
+    nest.GetSTDPPlasticity = _get_stdp_plasticity
+    nest.GetSTDPMemory = _get_stdp_memory
+    nest.PlanSTDPMemory = _plan_stdp_memory
+    nest.STDPCheckpoint = _checkpoint
+    nest.STDPRestore = _restore
+    nest.SetSTDPStates = _set_stdp_states
+    nest.FreezeSTDP = _freeze_stdp
+    nest.ReadSTDPSnapshot = ReadSTDPSnapshot
@@ -0,0 +1,597 @@
+/*
+ * Offline replay of the plasticity rules over recorded spike trains, without
+ * NEST: every synapse of a connectivity list is replayed independently, in
+ * parallel over the cores (OpenMP), with the kernels of stdp_triplet_rule.h
+ * and stdp_longterm_rule.h.
+ *
+ *     g++ -O2 -fopenmp -I.. stdp_replay.cpp -o stdp-replay
+ *     ./stdp-replay --rule triplet --set Aplus=0.01 --spikes spikes.gdf \
+ *         --connections connections.txt --weights weights.txt
+ *
+ * Spike files hold one spike per line, "gid time" (ms) and any further
+ * columns, as written by spike_detector (withgid, withtime). The connectivity
+ * file holds one synapse per line, "source target [weight [delay]]", its
+ * weight and delay default to --set weight=... and --delay. Lines starting
+ * with # are skipped in both.
+ *
+ * --rule triplet replays stdp_triplet_all_in_one_synapse: on each spike of
+ * its source at t, the post-synaptic spikes tp of its target with
+ * t_last < tp + delay <= t (t_last the previous spike of the source, 0 at
+ * first) potentiate first, then the spike depresses, as in
+ * STDPTripletConnection::send, the delay being the dendritic delay.
+ *
+ * --rule longterm replays stdp_longterm_node on its step grid: a spike of the
+ * source at t reaches the node at t + --pre-delay, a spike of the target at
+ * tp comes back at tp + delay (the delay of the connection from the
+ * post-synaptic neuron to port 1), both are handled at the step before their
+ * arrival. Every step with a spike or ending a plasticity_subsampling bin
+ * decays the traces, bins end by the consolidation, then pre and
+ * post-synaptic spikes apply the rule, as in STDPLongNeuron::update_plastic_,
+ * until --until (ms, the latest spike by default).
+ *
+ * Plasticity gating, modulation, rate-based mode and pruning are not
+ * replayed. --weights writes "source target weight" per synapse, in the
+ * order of the connectivity file, --trajectories "source target time weight"
+ * after every update of every synapse.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "stdp_longterm_rule.h"
+#include "stdp_triplet_rule.h"
+
+using namespace stdpmodule;
+
+namespace {
+
+typedef std::vector<double> Train;
+typedef std::map<long, Train> Trains;
+typedef std::vector<std::pair<double, double> > Trajectory;
+
+// spike times read from text files are rounded, windows are widened by this
+const double eps = 1e-6;
+
+struct Options {
+  std::string rule;
+  std::vector<std::string> spikes;
+  std::string connections;
+  std::string weights;
+  std::string trajectories;
+  std::vector<std::pair<std::string, double> > sets;
+  double delay;
+  double pre_delay;
+  double resolution;
+  double until;
+
+  Options()
+      : rule("triplet"), delay(1.0), pre_delay(-1.0), resolution(0.1),
+        until(-1.0) {}
+};
+
+struct Synapse {
+  long source;
+  long target;
+  double weight;
+  double delay;
+  bool has_weight;
+  bool has_delay;
+};
+
+void fail(const std::string &message) {
+  std::cerr << "stdp-replay: " << message << std::endl;
+  std::exit(2);
+}
+
+/* ----------------------------------------------------------- triplet */
+
+struct TripletSynapse {
+  double weight_;
+  double tau_plus_;
+  double tau_plus_triplet_;
+  double tau_minus_;
+  double tau_minus_triplet_;
+  double Aplus_;
+  double Aminus_;
+  double Aplus_triplet_;
+  double Aminus_triplet_;
+  double Kplus_;
+  double Kplus_triplet_;
+  double Kminus_;
+  double Kminus_triplet_;
+  double Wmax_;
+  double Wmin_;
+  bool nearest_spike_;
+
+  // defaults of stdp_triplet_all_in_one_synapse
+  TripletSynapse()
+      : weight_(1.0), tau_plus_(16.8), tau_plus_triplet_(101),
+        tau_minus_(33.7), tau_minus_triplet_(125), Aplus_(0.1), Aminus_(0.1),
+        Aplus_triplet_(0.1), Aminus_triplet_(0.1), Kplus_(0.0),
+        Kplus_triplet_(0.0), Kminus_(0.0), Kminus_triplet_(0.0), Wmax_(100.0),
+        Wmin_(0.0), nearest_spike_(false) {}
+
+  bool set(const std::string &name, double value) {
+    double *fields[] = {&weight_, &tau_plus_, &tau_plus_triplet_, &tau_minus_,
+                        &tau_minus_triplet_, &Aplus_, &Aminus_,
+                        &Aplus_triplet_, &Aminus_triplet_, &Kplus_,
+                        &Kplus_triplet_, &Kminus_, &Kminus_triplet_, &Wmax_,
+                        &Wmin_};
+    const char *names[] = {"weight", "tau_plus", "tau_plus_triplet",
+                           "tau_minus", "tau_minus_triplet", "Aplus",
+                           "Aminus", "Aplus_triplet", "Aminus_triplet",
+                           "Kplus", "Kplus_triplet", "Kminus",
+                           "Kminus_triplet", "Wmax", "Wmin"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+      if (name == names[i]) {
+        *fields[i] = value;
+        return true;
+      }
+    }
+    if (name == "nearest_spike") {
+      nearest_spike_ = value != 0.0;
+      return true;
+    }
+    return false;
+  }
+
+  void check() const {
+    if (!(Wmax_ >= Wmin_)) {
+      fail("Parameter Wmax must be larger than or equal to Wmin.");
+    }
+  }
+
+  triplet_rule::Traces traces() {
+    return triplet_rule::Traces(Kplus_, Kplus_triplet_, Kminus_,
+                                Kminus_triplet_);
+  }
+
+  void decay(double interval) {
+    triplet_rule::decay_over(traces(), interval, tau_plus_, tau_plus_triplet_,
+                             tau_minus_, tau_minus_triplet_);
+  }
+
+  /**
+   * Replays the spikes of the source (pre) on the target spikes (post),
+   * following STDPTripletConnection::update_.
+   */
+  void replay(const Train &pre, const Train &post, double delay, double until,
+              Trajectory *trajectory) {
+    const double ceiling = triplet_rule::ceiling(nearest_spike_);
+    double t_last_prespike = 0.0;
+    size_t p = 0;
+
+    for (size_t i = 0; i < pre.size() and pre[i] <= until + eps; ++i) {
+      const double t_spike = pre[i];
+
+      // post-synaptic spikes in (t_last_prespike, t_spike] once delayed
+      while (p < post.size() and post[p] + delay <= t_last_prespike + eps) {
+        ++p;
+      }
+      double t_last_postspike = t_last_prespike;
+      for (; p < post.size() and post[p] + delay <= t_spike + eps; ++p) {
+        const double t_adjusted = post[p] + delay;
+        const double delta = std::max(t_adjusted - t_last_postspike, 0.0);
+        t_last_postspike = t_adjusted;
+
+        decay(delta);
+        const double change =
+            triplet_rule::on_post(traces(), Aplus_, Aplus_triplet_, ceiling);
+        if (delta > 0) {
+          weight_ = triplet_rule::clamp(weight_ + change, Wmin_, Wmax_);
+          if (trajectory) {
+            trajectory->push_back(std::make_pair(t_adjusted, weight_));
+          }
+        }
+      }
+
+      decay(std::max(t_spike - t_last_postspike, 0.0));
+      const double change =
+          triplet_rule::on_pre(traces(), Aminus_, Aminus_triplet_, ceiling);
+      weight_ = triplet_rule::clamp(weight_ + change, Wmin_, Wmax_);
+      if (trajectory) {
+        trajectory->push_back(std::make_pair(t_spike, weight_));
+      }
+
+      t_last_prespike = t_spike;
+    }
+  }
+};
+
+/* ----------------------------------------------------------- long-term */
+
+struct LongtermSynapse {
+  double weight_;
+  double weight_ref_;
+  double B_;
+  double C_;
+  double Zplus_;
+  double Zslow_;
+  double Zminus_;
+  double Zht_;
+  double tau_plus_;
+  double tau_slow_;
+  double tau_minus_;
+  double tau_ht_;
+  double tau_hom_;
+  double tau_const_;
+  double A_;
+  double P_;
+  double WP_;
+  double beta_;
+  double delta_;
+  long subsampling_;
+
+  // defaults of stdp_longterm_node
+  LongtermSynapse()
+      : weight_(1.0), weight_ref_(1.0), B_(5e-3), C_(0.0), Zplus_(0.0),
+        Zslow_(0.0), Zminus_(0.0), Zht_(0.0), tau_plus_(20), tau_slow_(100),
+        tau_minus_(20), tau_ht_(100), tau_hom_(20 * 60 * 1000),
+        tau_const_(20 * 60 * 1000), A_(5e-3), P_(20), WP_(0.5), beta_(0.05),
+        delta_(2e-5), subsampling_(1) {}
+
+  bool set(const std::string &name, double value) {
+    double *fields[] = {&weight_, &weight_ref_, &B_, &C_, &Zplus_, &Zslow_,
+                        &Zminus_, &Zht_, &tau_plus_, &tau_slow_, &tau_minus_,
+                        &tau_ht_, &tau_hom_, &tau_const_, &A_, &P_, &WP_,
+                        &beta_, &delta_};
+    const char *names[] = {"weight", "weight_ref", "B", "C", "Zplus",
+                           "Zslow", "Zminus", "Zht", "tau_plus", "tau_slow",
+                           "tau_minus", "tau_ht", "tau_hom", "tau_const",
+                           "A", "P", "WP", "beta", "delta"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+      if (name == names[i]) {
+        *fields[i] = value;
+        return true;
+      }
+    }
+    if (name == "plasticity_subsampling") {
+      subsampling_ = static_cast<long>(value);
+      return true;
+    }
+    return false;
+  }
+
+  void check() const {
+    if (subsampling_ < 1) {
+      fail("Parameter plasticity_subsampling must be at least 1.");
+    }
+  }
+
+  /**
+   * Replays the spikes of the source (pre) and of the target (post) on the
+   * step grid of the node, following STDPLongNeuron::update_plastic_.
+   */
+  void replay(const Train &pre, const Train &post, double pre_delay,
+              double delay, double resolution, double until,
+              Trajectory *trajectory) {
+    const long last = static_cast<long>(std::floor(until / resolution + 0.5));
+    const double bin = subsampling_ * resolution;
+    const double bin_decays[] = {
+        std::exp(-bin / tau_plus_), std::exp(-bin / tau_slow_),
+        std::exp(-bin / tau_minus_), std::exp(-bin / tau_ht_)};
+
+    long t_traces = -1;
+    size_t i = 0;
+    size_t p = 0;
+    for (;;) {
+      // next step with a spike, handled the step before its arrival
+      const long pre_step =
+          i < pre.size() ? step_(pre[i] + pre_delay, resolution) : last;
+      const long post_step =
+          p < post.size() ? step_(post[p] + delay, resolution) : last;
+      const long step = std::min(std::min(pre_step, post_step), last);
+
+      // bins ending before it, each decayed by a whole bin where possible
+      for (long end = ((t_traces + 1) / subsampling_ + 1) * subsampling_ - 1;
+           end < step; end += subsampling_) {
+        if (end - t_traces == subsampling_) {
+          longterm_rule::decay(*this, bin_decays[0], bin_decays[1],
+                               bin_decays[2], bin_decays[3]);
+        } else {
+          longterm_rule::decay_over(*this, *this,
+                                    (end - t_traces) * resolution);
+        }
+        t_traces = end;
+        longterm_rule::consolidate(*this, *this, bin, Zht_ * Zht_);
+      }
+
+      if (step >= last) {
+        return;
+      }
+
+      if (step > t_traces) {
+        longterm_rule::decay_over(*this, *this, (step - t_traces) * resolution);
+        t_traces = step;
+      }
+      if ((step + 1) % subsampling_ == 0) {
+        longterm_rule::consolidate(*this, *this, bin, Zht_ * Zht_);
+      }
+
+      const double time = (step + 1) * resolution;
+      if (pre_step == step) {
+        weight_ += longterm_rule::on_pre(*this, *this);
+        if (trajectory) {
+          trajectory->push_back(std::make_pair(time, weight_));
+        }
+      }
+      if (post_step == step) {
+        weight_ += longterm_rule::on_post(*this, *this);
+        if (trajectory) {
+          trajectory->push_back(std::make_pair(time, weight_));
+        }
+      }
+
+      // spikes arriving at the same step are counted once
+      while (i < pre.size() and step_(pre[i] + pre_delay, resolution) == step) {
+        ++i;
+      }
+      while (p < post.size() and step_(post[p] + delay, resolution) == step) {
+        ++p;
+      }
+    }
+  }
+
+  static long step_(double arrival, double resolution) {
+    return static_cast<long>(std::floor(arrival / resolution + 0.5)) - 1;
+  }
+};
+
+/* ----------------------------------------------------------- input */
+
+void read_spikes(const std::string &filename, Trains &trains, double &latest) {
+  std::ifstream in(filename.c_str());
+  if (!in) {
+    fail("cannot open spike file " + filename);
+  }
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() or line[0] == '#') {
+      continue;
+    }
+    std::istringstream fields(line);
+    long gid;
+    double time;
+    if (!(fields >> gid >> time)) {
+      fail("bad spike line in " + filename + ": " + line);
+    }
+    trains[gid].push_back(time);
+    latest = std::max(latest, time);
+  }
+}
+
+void read_connections(const std::string &filename,
+                      std::vector<Synapse> &synapses) {
+  std::ifstream in(filename.c_str());
+  if (!in) {
+    fail("cannot open connectivity file " + filename);
+  }
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() or line[0] == '#') {
+      continue;
+    }
+    std::istringstream fields(line);
+    Synapse s = {0, 0, 0.0, 0.0, false, false};
+    if (!(fields >> s.source >> s.target)) {
+      fail("bad connectivity line in " + filename + ": " + line);
+    }
+    s.has_weight = static_cast<bool>(fields >> s.weight);
+    s.has_delay = s.has_weight and static_cast<bool>(fields >> s.delay);
+    synapses.push_back(s);
+  }
+}
+
+void usage() {
+  std::cerr
+      << "usage: stdp-replay --spikes FILE [--spikes FILE ...] --connections "
+         "FILE\n"
+         "                   [--rule triplet|longterm] [--set NAME=VALUE ...]\n"
+         "                   [--delay MS] [--pre-delay MS] [--resolution MS] "
+         "[--until MS]\n"
+         "                   [--weights FILE] [--trajectories FILE]\n";
+  std::exit(2);
+}
+
+Options parse(int argc, char **argv) {
+  Options o;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      usage();
+    }
+    const std::string value = argv[++i];
+    if (arg == "--rule") {
+      o.rule = value;
+    } else if (arg == "--spikes") {
+      o.spikes.push_back(value);
+    } else if (arg == "--connections") {
+      o.connections = value;
+    } else if (arg == "--weights") {
+      o.weights = value;
+    } else if (arg == "--trajectories") {
+      o.trajectories = value;
+    } else if (arg == "--delay") {
+      o.delay = std::atof(value.c_str());
+    } else if (arg == "--pre-delay") {
+      o.pre_delay = std::atof(value.c_str());
+    } else if (arg == "--resolution") {
+      o.resolution = std::atof(value.c_str());
+    } else if (arg == "--until") {
+      o.until = std::atof(value.c_str());
+    } else if (arg == "--set") {
+      const size_t equal = value.find('=');
+      if (equal == std::string::npos) {
+        usage();
+      }
+      o.sets.push_back(std::make_pair(value.substr(0, equal),
+                                      std::atof(value.c_str() + equal + 1)));
+    } else {
+      usage();
+    }
+  }
+  if (o.spikes.empty() or o.connections.empty() or
+      (o.rule != "triplet" and o.rule != "longterm")) {
+    usage();
+  }
+  if (!(o.resolution > 0)) {
+    fail("resolution must be strictly positive");
+  }
+  if (o.pre_delay < 0) {
+    o.pre_delay = o.resolution;
+  }
+  return o;
+}
+
+/* ----------------------------------------------------------- replay */
+
+void replay_(TripletSynapse &rule, const Options &, const Train &pre,
+             const Train &post, double delay, double until,
+             Trajectory *trajectory) {
+  rule.replay(pre, post, delay, until, trajectory);
+}
+
+void replay_(LongtermSynapse &rule, const Options &o, const Train &pre,
+             const Train &post, double delay, double until,
+             Trajectory *trajectory) {
+  rule.replay(pre, post, o.pre_delay, delay, o.resolution, until, trajectory);
+}
+
+/**
+ * Replays all synapses from a prototype carrying the --set values, returns
+ * the final weights.
+ */
+template <typename Rule>
+std::vector<double> replay_all(const Options &o, const Rule &prototype,
+                               const Trains &trains,
+                               const std::vector<Synapse> &synapses,
+                               double until,
+                               std::vector<Trajectory> *trajectories) {
+  const long n = static_cast<long>(synapses.size());
+  std::vector<double> weights(n);
+  const Train none;
+
+#pragma omp parallel for schedule(dynamic, 64)
+  for (long k = 0; k < n; ++k) {
+    const Synapse &s = synapses[k];
+    Trains::const_iterator pre = trains.find(s.source);
+    Trains::const_iterator post = trains.find(s.target);
+
+    Rule rule = prototype;
+    if (s.has_weight) {
+      rule.weight_ = s.weight;
+    }
+    replay_(rule, o, pre == trains.end() ? none : pre->second,
+            post == trains.end() ? none : post->second,
+            s.has_delay ? s.delay : o.delay, until,
+            trajectories ? &(*trajectories)[k] : 0);
+    weights[k] = rule.weight_;
+  }
+  return weights;
+}
+
+template <typename Rule>
+std::vector<double> run(const Options &o, const Trains &trains,
+                        const std::vector<Synapse> &synapses, double until,
+                        std::vector<Trajectory> *trajectories) {
+  Rule prototype;
+  for (size_t i = 0; i < o.sets.size(); ++i) {
+    if (!prototype.set(o.sets[i].first, o.sets[i].second)) {
+      fail("unknown parameter " + o.sets[i].first + " of rule " + o.rule);
+    }
+  }
+  prototype.check();
+  return replay_all(o, prototype, trains, synapses, until, trajectories);
+}
+}
+
+int main(int argc, char **argv) {
+  const Options o = parse(argc, argv);
+
+  Trains trains;
+  double latest = 0.0;
+  for (size_t i = 0; i < o.spikes.size(); ++i) {
+    read_spikes(o.spikes[i], trains, latest);
+  }
+  for (Trains::iterator t = trains.begin(); t != trains.end(); ++t) {
+    std::sort(t->second.begin(), t->second.end());
+  }
+
+  std::vector<Synapse> synapses;
+  read_connections(o.connections, synapses);
+
+  const double until = o.until >= 0 ? o.until : latest;
+  std::vector<Trajectory> trajectories;
+  if (!o.trajectories.empty()) {
+    trajectories.resize(synapses.size());
+  }
+  std::vector<Trajectory> *recorded =
+      o.trajectories.empty() ? 0 : &trajectories;
+
+  double start = 0.0;
+  int threads = 1;
+#ifdef _OPENMP
+  start = omp_get_wtime();
+  threads = omp_get_max_threads();
+#endif
+
+  const std::vector<double> weights =
+      o.rule == "triplet"
+          ? run<TripletSynapse>(o, trains, synapses, until, recorded)
+          : run<LongtermSynapse>(o, trains, synapses, until, recorded);
+
+  double elapsed = 0.0;
+#ifdef _OPENMP
+  elapsed = omp_get_wtime() - start;
+#endif
+  std::cerr << "stdp-replay: " << synapses.size() << " synapses, "
+            << trains.size() << " spike trains up to " << until << " ms, "
+            << threads << " threads, " << elapsed << " s" << std::endl;
+
+  if (!o.weights.empty()) {
+    std::FILE *out = std::fopen(o.weights.c_str(), "w");
+    if (!out) {
+      fail("cannot write " + o.weights);
+    }
+    for (size_t k = 0; k < synapses.size(); ++k) {
+      std::fprintf(out, "%ld %ld %.17g\n", synapses[k].source,
+                   synapses[k].target, weights[k]);
+    }
+    std::fclose(out);
+  } else {
+    for (size_t k = 0; k < synapses.size(); ++k) {
+      std::printf("%ld %ld %.17g\n", synapses[k].source, synapses[k].target,
+                  weights[k]);
+    }
+  }
+
+  if (!o.trajectories.empty()) {
+    std::FILE *out = std::fopen(o.trajectories.c_str(), "w");
+    if (!out) {
+      fail("cannot write " + o.trajectories);
+    }
+    for (size_t k = 0; k < synapses.size(); ++k) {
+      for (size_t j = 0; j < trajectories[k].size(); ++j) {
+        std::fprintf(out, "%ld %ld %.17g %.17g\n", synapses[k].source,
+                     synapses[k].target, trajectories[k][j].first,
+                     trajectories[k][j].second);
+      }
+    }
+    std::fclose(out);
+  }
+  return 0;
+}
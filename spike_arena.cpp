@@ -0,0 +1,116 @@
+//
+//  spike_arena.cpp
+//  NEST
+//
+//
+
+#include "spike_arena.h"
+
+#include "stdpnames.h"
+#include "dictutils.h"
+
+using namespace nest;
+
+namespace {
+
+// doubles per block, 1 MiB
+const size_t block_size = 1 << 17;
+}
+
+std::vector<stdpmodule::SpikeArena::Arena_> *stdpmodule::SpikeArena::arenas_ =
+    0;
+
+stdpmodule::SpikeArena::Arena_::Arena_()
+    : pools_(), blocks_(), next_(0), end_(0), used_(0), reserved_(0) {}
+
+void stdpmodule::SpikeArena::reserve(size_t n_threads) {
+  if (arenas_ == 0) {
+    arenas_ = new std::vector<Arena_>();
+  }
+  if (arenas_->size() < n_threads) {
+    arenas_->resize(n_threads);
+  }
+}
+
+stdpmodule::SpikeArena::Pool_ &
+stdpmodule::SpikeArena::pool_(Arena_ &arena, size_t n) {
+  // nodes use a handful of sizes
+  for (size_t i = 0; i < arena.pools_.size(); ++i) {
+    if (arena.pools_[i].size_ == n) {
+      return arena.pools_[i];
+    }
+  }
+
+  arena.pools_.push_back(Pool_());
+  arena.pools_.back().size_ = n;
+  return arena.pools_.back();
+}
+
+double_t *stdpmodule::SpikeArena::allocate(thread t, size_t n) {
+  if (arenas_ == 0 or static_cast<size_t>(t) >= arenas_->size()) {
+    double_t *array = new double_t[n];
+    std::fill(array, array + n, 0.0);
+    return array;
+  }
+
+  Arena_ &arena = (*arenas_)[t];
+  Pool_ &pool = pool_(arena, n);
+
+  double_t *array;
+  if (!pool.free_.empty()) {
+    array = pool.free_.back();
+    pool.free_.pop_back();
+  } else {
+    if (static_cast<size_t>(arena.end_ - arena.next_) < n) {
+      const size_t size = std::max(block_size, n);
+      arena.next_ = new double_t[size];
+      arena.end_ = arena.next_ + size;
+      arena.blocks_.push_back(arena.next_);
+      arena.reserved_ += size;
+    }
+    array = arena.next_;
+    arena.next_ += n;
+  }
+
+  arena.used_ += n;
+  std::fill(array, array + n, 0.0);
+  return array;
+}
+
+void stdpmodule::SpikeArena::deallocate(thread t, double_t *array, size_t n) {
+  if (arenas_ == 0 or static_cast<size_t>(t) >= arenas_->size()) {
+    delete[] array;
+    return;
+  }
+
+  Arena_ &arena = (*arenas_)[t];
+  pool_(arena, n).free_.push_back(array);
+  arena.used_ -= n;
+
+  if (arena.used_ > 0) {
+    return;
+  }
+
+  // all nodes of the thread are gone or released their arrays
+  for (size_t i = 0; i < arena.blocks_.size(); ++i) {
+    delete[] arena.blocks_[i];
+  }
+  arena = Arena_();
+}
+
+DictionaryDatum stdpmodule::SpikeArena::get_status() {
+  size_t reserved = 0;
+  size_t used = 0;
+  size_t n_blocks = 0;
+  for (size_t t = 0; arenas_ != 0 and t < arenas_->size(); ++t) {
+    reserved += (*arenas_)[t].reserved_;
+    used += (*arenas_)[t].used_;
+    n_blocks += (*arenas_)[t].blocks_.size();
+  }
+
+  DictionaryDatum d(new Dictionary);
+  def<long_t>(d, stdpnames::bytes, reserved * sizeof(double_t));
+  def<long_t>(d, stdpnames::bytes_used, used * sizeof(double_t));
+  def<long_t>(d, stdpnames::n_blocks, n_blocks);
+  return d;
+}
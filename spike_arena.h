@@ -0,0 +1,132 @@
+//
+//  spike_arena.h
+//  NEST
+//
+//
+
+#ifndef SPIKE_ARENA_H
+#define SPIKE_ARENA_H
+
+#include <algorithm>
+#include <vector>
+
+#include "nest.h"
+#include "dictdatum.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+/**
+ * Per-thread pools of the buffers and tables of STDP nodes. Arrays are carved
+ * one after the other from large blocks and recycled through a free list per
+ * size, so that initializing millions of nodes costs no heap allocation per
+ * node and the arrays of nodes of a thread lie next to each other. Blocks are
+ * returned to the heap once all arrays of their thread are released.
+ * @note Arrays are drawn and released by the thread of their node, or outside
+ * of parallel regions. Threads beyond those reserved when the module is
+ * initialized draw their arrays from the heap.
+ */
+class SpikeArena {
+public:
+  /**
+   * Make room for the pools of n threads, called once on module
+   * initialization which is not parallel.
+   */
+  static void reserve(size_t n_threads);
+
+  /**
+   * Draw a zeroed array of n doubles from the pools of a thread.
+   */
+  static double_t *allocate(thread t, size_t n);
+
+  /**
+   * Give an array of n doubles back to the pools of a thread.
+   */
+  static void deallocate(thread t, double_t *array, size_t n);
+
+  /**
+   * Bytes reserved in blocks and in use by arrays over all threads, number of
+   * blocks (see stdp_memory).
+   */
+  static DictionaryDatum get_status();
+
+private:
+  struct Pool_ {
+    size_t size_;
+    std::vector<double_t *> free_;
+  };
+
+  struct Arena_ {
+    std::vector<Pool_> pools_;
+    std::vector<double_t *> blocks_;
+    // unused end of the last block
+    double_t *next_;
+    double_t *end_;
+    size_t used_;
+    size_t reserved_;
+
+    Arena_();
+  };
+
+  static Pool_ &pool_(Arena_ &, size_t n);
+
+  // never freed, nodes may release their arrays after static destructors
+  static std::vector<Arena_> *arenas_;
+};
+
+/**
+ * Array of doubles drawn from the arena of a thread. Copies start empty.
+ */
+class ArenaArray {
+public:
+  ArenaArray() : data_(0), size_(0), thread_(0) {}
+  ArenaArray(const ArenaArray &) : data_(0), size_(0), thread_(0) {}
+  ~ArenaArray() { release(); }
+
+  /**
+   * Hold n zeroes, drawn from the arena of the given thread unless the size
+   * is unchanged.
+   */
+  void assign(thread t, size_t n) {
+    if (data_ != 0 and n == size_) {
+      std::fill(data_, data_ + size_, 0.0);
+      return;
+    }
+
+    release();
+    data_ = SpikeArena::allocate(t, n);
+    size_ = n;
+    thread_ = t;
+  }
+
+  /**
+   * Give the storage back to the arena.
+   */
+  void release() {
+    if (data_ != 0) {
+      SpikeArena::deallocate(thread_, data_, size_);
+    }
+    data_ = 0;
+    size_ = 0;
+  }
+
+  double_t &operator[](size_t i) { return data_[i]; }
+  const double_t &operator[](size_t i) const { return data_[i]; }
+
+  size_t size() const { return size_; }
+
+  /**
+   * Bytes of storage drawn by the array.
+   */
+  size_t memory_size() const { return size_ * sizeof(double_t); }
+
+private:
+  ArenaArray &operator=(const ArenaArray &);
+
+  double_t *data_;
+  size_t size_;
+  thread thread_;
+};
+}
+
+#endif /* SPIKE_ARENA_H */
@@ -0,0 +1,150 @@
+//
+//  spike_ring_buffer.h
+//  NEST
+//
+//
+
+#ifndef SPIKE_RING_BUFFER_H
+#define SPIKE_RING_BUFFER_H
+
+#include <vector>
+
+#include "nest.h"
+#include "scheduler.h"
+
+#include "spike_arena.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+/**
+ * Ring buffer of spike multiplicities, laid out as NEST's RingBuffer, whose
+ * storage is drawn from the arena of its thread (see SpikeArena) and can be
+ * released when its node no longer receives spikes.
+ */
+class SpikeRingBuffer {
+public:
+  SpikeRingBuffer() : buffer_() {}
+
+  /**
+   * Add a value to the slot of the given delay from the slice origin.
+   */
+  void add_value(const long_t offs, const double_t v) {
+    buffer_[get_index_(offs)] += v;
+  }
+
+  /**
+   * Read and clear the slot of the given lag of the current slice.
+   */
+  double_t get_value(const long_t offs) {
+    const size_t idx = get_index_(offs);
+    const double_t v = buffer_[idx];
+    buffer_[idx] = 0.0;
+    return v;
+  }
+
+  /**
+   * Size the buffer for the current delays and clear it, drawing its storage
+   * from the arena of the thread of its node.
+   */
+  void clear(thread t) {
+    buffer_.assign(t, Scheduler::get_min_delay() + Scheduler::get_max_delay());
+  }
+
+  /**
+   * Free the storage, clear() must be called before the buffer is used again.
+   */
+  void release() { buffer_.release(); }
+
+  size_t size() const { return buffer_.size(); }
+
+  /**
+   * Bytes of storage allocated by the buffer.
+   */
+  size_t memory_size() const { return buffer_.memory_size(); }
+
+private:
+  size_t get_index_(const long_t d) const {
+    const size_t idx = Scheduler::get_modulo(d);
+    assert(idx < buffer_.size());
+    return idx;
+  }
+
+  ArenaArray buffer_;
+};
+
+/**
+ * Ring buffer of precise spikes, each slot keeping the offsets and
+ * multiplicities of the spikes arriving during one step.
+ */
+class PreciseSpikeRingBuffer {
+public:
+  struct Spike {
+    double_t offset_;
+    double_t multiplicity_;
+
+    /**
+     * Order of spikes in time, larger offsets come first.
+     */
+    static bool earlier(const Spike &a, const Spike &b) {
+      return a.offset_ > b.offset_;
+    }
+  };
+
+  PreciseSpikeRingBuffer() : buffer_() {}
+
+  /**
+   * Add a spike to the slot of the given delay from the slice origin.
+   */
+  void add_spike(const long_t offs, const double_t offset,
+                 const double_t multiplicity) {
+    Spike spike = {offset, multiplicity};
+    buffer_[get_index_(offs)].push_back(spike);
+  }
+
+  /**
+   * Spikes of the given lag of the current slice, to be cleared by the caller
+   * once processed.
+   */
+  std::vector<Spike> &get_spikes(const long_t offs) {
+    return buffer_[get_index_(offs)];
+  }
+
+  /**
+   * Size the buffer for the current delays and clear it.
+   */
+  void clear() {
+    buffer_.assign(Scheduler::get_min_delay() + Scheduler::get_max_delay(),
+                   std::vector<Spike>());
+  }
+
+  /**
+   * Free the storage, clear() must be called before the buffer is used again.
+   */
+  void release() { std::vector<std::vector<Spike> >().swap(buffer_); }
+
+  size_t size() const { return buffer_.size(); }
+
+  /**
+   * Bytes of storage allocated by the buffer and its slots.
+   */
+  size_t memory_size() const {
+    size_t bytes = buffer_.capacity() * sizeof(std::vector<Spike>);
+    for (size_t i = 0; i < buffer_.size(); ++i) {
+      bytes += buffer_[i].capacity() * sizeof(Spike);
+    }
+    return bytes;
+  }
+
+private:
+  size_t get_index_(const long_t d) const {
+    const size_t idx = Scheduler::get_modulo(d);
+    assert(idx < buffer_.size());
+    return idx;
+  }
+
+  std::vector<std::vector<Spike> > buffer_;
+};
+}
+
+#endif /* SPIKE_RING_BUFFER_H */
@@ -0,0 +1,273 @@
+//
+//  stdp_checkpoint.cpp
+//  NEST
+//
+//
+
+#include "stdp_checkpoint.h"
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#include "stdpnames.h"
+#include "mapped_file.h"
+#include "plastic_node.h"
+#include "network.h"
+#include "nestmodule.h"
+#include "communicator.h"
+#include "arraydatum.h"
+#include "dictutils.h"
+#include "nestdatums.h"
+#include "sliexceptions.h"
+
+using namespace nest;
+
+namespace {
+
+const char magic[8] = {'S', 'T', 'D', 'P', 'C', 'K', 'P', 'T'};
+const unsigned int version = 3;
+const char *const connection_model = "stdp_triplet_all_in_one_synapse";
+
+struct Header {
+  char magic_[8];
+  unsigned int version_;
+  unsigned int rank_;
+  unsigned long n_nodes_;
+  unsigned long n_connections_;
+  double time_;
+};
+
+struct NodeRecord {
+  unsigned long gid_;
+  unsigned int model_id_;
+  unsigned int version_;
+  unsigned long n_values_;
+};
+
+struct ConnectionRecord {
+  unsigned long source_;
+  unsigned long target_;
+  unsigned int thread_;
+  unsigned int syn_id_;
+  unsigned long port_;
+  unsigned int active_;
+  unsigned int padding_;
+  double weight_;
+  double Kplus_;
+  double Kplus_triplet_;
+  double Kminus_;
+  double Kminus_triplet_;
+  // time at or below the pruning threshold, -1 when above (ms)
+  double depressed_;
+  double last_offset_;
+};
+
+/**
+ * Write n items to the file, closing it on failure.
+ */
+void write(const void *data, size_t size, size_t n, FILE *file) {
+  if (std::fwrite(data, size, n, file) != n) {
+    std::fclose(file);
+    throw IOError();
+  }
+}
+
+ArrayDatum local_connections() {
+  DictionaryDatum params(new Dictionary);
+  (*params)[names::synapse_model] = LiteralDatum(connection_model);
+  return nest::NestModule::get_network().get_connections(params);
+}
+}
+
+std::string stdpmodule::STDPCheckpoint::filename_(const std::string &prefix) {
+  std::ostringstream filename;
+  filename << prefix << "." << Communicator::get_rank() << ".stdp";
+  return filename.str();
+}
+
+/* ----------------------------------------------------------- save */
+
+DictionaryDatum
+stdpmodule::STDPCheckpoint::save(const std::string &prefix) {
+  Network &net = nest::NestModule::get_network();
+  const std::string filename = filename_(prefix);
+
+  FILE *file = std::fopen(filename.c_str(), "wb");
+  if (file == 0) {
+    throw IOError();
+  }
+
+  // header is rewritten with the final counts
+  Header header;
+  std::memcpy(header.magic_, magic, sizeof(magic));
+  header.version_ = version;
+  header.rank_ = Communicator::get_rank();
+  header.n_nodes_ = 0;
+  header.n_connections_ = 0;
+  header.time_ = net.get_time().get_ms();
+  write(&header, sizeof(Header), 1, file);
+
+  std::vector<double> values;
+  for (nest::index gid = 1; gid < net.size(); ++gid) {
+    if (!net.is_local_gid(gid)) {
+      continue;
+    }
+
+    Node *node = net.get_node(gid);
+    const PlasticNode *plastic = dynamic_cast<PlasticNode *>(node);
+    if (plastic == 0) {
+      continue;
+    }
+
+    NodeRecord record;
+    record.gid_ = gid;
+    record.model_id_ = node->get_model_id();
+    record.version_ = plastic->plastic_state_version();
+    record.n_values_ = plastic->plastic_state_size();
+
+    values.assign(record.n_values_, 0.0);
+    plastic->write_plastic_state(&values[0]);
+
+    write(&record, sizeof(NodeRecord), 1, file);
+    write(&values[0], sizeof(double), values.size(), file);
+    ++header.n_nodes_;
+  }
+
+  ArrayDatum connections = local_connections();
+  for (size_t i = 0; i < connections.size(); ++i) {
+    const ConnectionDatum conn = getValue<ConnectionDatum>(connections[i]);
+
+    ConnectionRecord record;
+    record.source_ = conn.get_source_gid();
+    record.target_ = conn.get_target_gid();
+    record.thread_ = conn.get_target_thread();
+    record.syn_id_ = conn.get_synapse_model_id();
+    record.port_ = conn.get_port();
+    record.padding_ = 0;
+
+    const DictionaryDatum status = net.get_synapse_status(
+        record.source_, record.syn_id_, record.port_, record.thread_);
+    record.active_ = getValue<bool>(status, stdpnames::active);
+    record.weight_ = getValue<double_t>(status, names::weight);
+    record.Kplus_ = getValue<double_t>(status, stdpnames::Kplus);
+    record.Kplus_triplet_ = getValue<double_t>(status, stdpnames::Kplus_triplet);
+    record.Kminus_ = getValue<double_t>(status, stdpnames::Kminus);
+    record.Kminus_triplet_ =
+        getValue<double_t>(status, stdpnames::Kminus_triplet);
+    const double_t t_depressed =
+        getValue<double_t>(status, stdpnames::t_depressed);
+    record.depressed_ = t_depressed < 0.0 ? -1.0 : header.time_ - t_depressed;
+    record.last_offset_ = getValue<double_t>(status, stdpnames::last_offset);
+
+    write(&record, sizeof(ConnectionRecord), 1, file);
+    ++header.n_connections_;
+  }
+
+  std::rewind(file);
+  write(&header, sizeof(Header), 1, file);
+
+  if (std::fclose(file) != 0) {
+    throw IOError();
+  }
+
+  DictionaryDatum result(new Dictionary);
+  def<long_t>(result, stdpnames::n_nodes, header.n_nodes_);
+  def<long_t>(result, stdpnames::n_connections, header.n_connections_);
+  def<double_t>(result, stdpnames::time, header.time_);
+  return result;
+}
+
+/* ----------------------------------------------------------- restore */
+
+DictionaryDatum
+stdpmodule::STDPCheckpoint::restore(const std::string &prefix) {
+  Network &net = nest::NestModule::get_network();
+  const std::string filename = filename_(prefix);
+
+  const MappedFile file(filename);
+  file.advise_sequential();
+
+  const char *data = file.data();
+  const char *const end = data + file.size();
+
+  if (file.size() < sizeof(Header)) {
+    throw IOError();
+  }
+
+  Header header;
+  std::memcpy(&header, data, sizeof(Header));
+  data += sizeof(Header);
+
+  if (std::memcmp(header.magic_, magic, sizeof(magic)) != 0 or
+      header.version_ != version or
+      header.rank_ != static_cast<unsigned int>(Communicator::get_rank())) {
+    throw KernelException("Checkpoint " + filename +
+                          " does not belong to this rank or version.");
+  }
+
+  const double now = net.get_time().get_ms();
+  std::vector<double> values;
+  for (unsigned long i = 0; i < header.n_nodes_; ++i) {
+    NodeRecord record;
+    if (data + sizeof(NodeRecord) > end) {
+      throw IOError();
+    }
+    std::memcpy(&record, data, sizeof(NodeRecord));
+    data += sizeof(NodeRecord);
+
+    const size_t size = record.n_values_ * sizeof(double);
+    if (data + size > end) {
+      throw IOError();
+    }
+
+    Node *node = net.get_node(record.gid_);
+    PlasticNode *plastic = dynamic_cast<PlasticNode *>(node);
+    if (plastic == 0 or
+        node->get_model_id() != static_cast<int>(record.model_id_) or
+        plastic->plastic_state_size() != record.n_values_) {
+      throw KernelException("Checkpoint " + filename +
+                            " does not match the network.");
+    }
+    if (plastic->plastic_state_version() != record.version_) {
+      throw KernelException("Checkpoint " + filename +
+                            " was written by another version of model " +
+                            node->get_name() + ".");
+    }
+
+    values.resize(record.n_values_);
+    std::memcpy(&values[0], data, size);
+    plastic->read_plastic_state(&values[0]);
+    data += size;
+  }
+
+  DictionaryDatum status(new Dictionary);
+  for (unsigned long i = 0; i < header.n_connections_; ++i) {
+    ConnectionRecord record;
+    if (data + sizeof(ConnectionRecord) > end) {
+      throw IOError();
+    }
+    std::memcpy(&record, data, sizeof(ConnectionRecord));
+    data += sizeof(ConnectionRecord);
+
+    (*status)[stdpnames::active] = record.active_ != 0;
+    (*status)[names::weight] = record.weight_;
+    (*status)[stdpnames::Kplus] = record.Kplus_;
+    (*status)[stdpnames::Kplus_triplet] = record.Kplus_triplet_;
+    (*status)[stdpnames::Kminus] = record.Kminus_;
+    (*status)[stdpnames::Kminus_triplet] = record.Kminus_triplet_;
+    (*status)[stdpnames::t_depressed] =
+        record.depressed_ < 0.0 ? -1.0 : now - record.depressed_;
+    (*status)[stdpnames::last_offset] = record.last_offset_;
+
+    net.set_synapse_status(record.source_, record.syn_id_, record.port_,
+                           record.thread_, status);
+  }
+
+  DictionaryDatum result(new Dictionary);
+  def<long_t>(result, stdpnames::n_nodes, header.n_nodes_);
+  def<long_t>(result, stdpnames::n_connections, header.n_connections_);
+  def<double_t>(result, stdpnames::time, header.time_);
+  return result;
+}
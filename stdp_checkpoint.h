@@ -0,0 +1,77 @@
+//
+//  stdp_checkpoint.h
+//  NEST
+//
+//
+
+/* BeginDocumentation
+ Name: stdp_checkpoint - Binary checkpoint and restore of plasticity state.
+
+ Description:
+ STDPCheckpoint writes the plastic state of all local STDP nodes (weight and
+ traces, e.g. weight_ref, B, C and Z traces of stdp_longterm_node, pruning,
+ rate and modulation state) and of all local stdp_triplet_all_in_one_synapse
+ connections (weight, K traces, pruning state and offset of the last spike)
+ into one compact binary file per rank, named <prefix>.<rank>.stdp.
+
+ STDPRestore memory-maps the file of the rank and copies node states back in
+ place. It expects the network to be built the same way as when the
+ checkpoint was written (same GIDs and connection order).
+
+ File layout:
+ header             magic, version, rank, number of node and connection
+ records, simulation time
+ node record        gid, model id, version of the state fields of the model,
+ number of values, values (doubles)
+ connection record  source, target, thread, synapse id, port, active, weight,
+ Kplus, Kplus_triplet, Kminus, Kminus_triplet, time depressed, last offset
+
+ Notes:
+ Node states are written field by field by each model (see plastic_node.h),
+ with their traces caught up to the checkpoint time and their times (last
+ decay, modulation, start of depression) stored relative to it. They are
+ rebased to the kernel time of the restore, so a checkpoint can be restored
+ into a fresh kernel. A model whose fields changed since the checkpoint is an
+ error rather than a silent misread. Connections have no such access in the
+ kernel, they are read and written through the synapse status dictionaries,
+ which still happens entirely in C++. Spikes in flight (ring buffers) and
+ spike histories are not part of the checkpoint, checkpoints should be taken
+ at the end of a Simulate call and restored before the next one. Connection
+ traces are those of their last pre-synaptic spike, so the kernel time must
+ be restored along with them (see time in the returned dictionary).
+
+ SeeAlso: stdp_triplet_node, stdp_longterm_node,
+ stdp_triplet_all_in_one_synapse
+ */
+
+#ifndef STDP_CHECKPOINT_H
+#define STDP_CHECKPOINT_H
+
+#include <string>
+
+#include "nest.h"
+#include "dictdatum.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+class STDPCheckpoint {
+public:
+  /**
+   * Write the checkpoint file of this rank.
+   * @return dict number of node and connection records written
+   */
+  static DictionaryDatum save(const std::string &prefix);
+
+  /**
+   * Restore the state from the checkpoint file of this rank.
+   * @return dict number of records restored and checkpoint time
+   */
+  static DictionaryDatum restore(const std::string &prefix);
+
+private:
+  static std::string filename_(const std::string &prefix);
+};
+}
+
+#endif /* STDP_CHECKPOINT_H */
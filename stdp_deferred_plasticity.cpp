@@ -0,0 +1,73 @@
+//
+//  stdp_deferred_plasticity.cpp
+//  NEST
+//
+//
+
+#include "stdp_deferred_plasticity.h"
+
+#include <algorithm>
+
+#include "stdpnames.h"
+#include "network.h"
+#include "dictutils.h"
+
+using namespace nest;
+
+std::vector<char> stdpmodule::STDPDeferredPlasticity::enabled_;
+std::vector<std::vector<stdpmodule::STDPDeferredPlasticity::Update> >
+    stdpmodule::STDPDeferredPlasticity::queues_;
+
+/* ----------------------------------------------------------- constructors */
+
+stdpmodule::STDPDeferredPlasticity::STDPDeferredPlasticity()
+    : Node(), n_updates_(0), enabled_here_(false) {}
+
+stdpmodule::STDPDeferredPlasticity::STDPDeferredPlasticity(
+    const STDPDeferredPlasticity &n)
+    : Node(n), n_updates_(0), enabled_here_(false) {}
+
+stdpmodule::STDPDeferredPlasticity::~STDPDeferredPlasticity() {
+  if (enabled_here_) {
+    enabled_[get_thread()] = 0;
+    std::vector<Update>().swap(queues_[get_thread()]);
+  }
+}
+
+void stdpmodule::STDPDeferredPlasticity::get_status(DictionaryDatum &d) const {
+  def<long_t>(d, stdpnames::n_updates, n_updates_);
+}
+
+/* ----------------------------------------------------------- initialization */
+
+void stdpmodule::STDPDeferredPlasticity::calibrate() {
+// instances are calibrated in parallel
+#pragma omp critical(stdp_deferred_plasticity)
+  {
+    const size_t n_threads = network()->get_num_threads();
+    if (enabled_.size() < n_threads) {
+      enabled_.resize(n_threads, 0);
+      queues_.resize(n_threads);
+    }
+  }
+
+  enabled_[get_thread()] = 1;
+  enabled_here_ = true;
+}
+
+/* ----------------------------------------------------------- updates */
+
+void stdpmodule::STDPDeferredPlasticity::update(Time const &, const long_t,
+                                                const long_t) {
+  // delivery of the slice is done on this thread, the updates of each
+  // connection keep their order within its target's group
+  std::vector<Update> &queue = queues_[get_thread()];
+  std::stable_sort(queue.begin(), queue.end(), Update::by_target);
+
+  for (std::vector<Update>::const_iterator update = queue.begin();
+       update != queue.end(); ++update) {
+    update->apply_(*update, get_thread());
+  }
+  n_updates_ += queue.size();
+  queue.clear();
+}
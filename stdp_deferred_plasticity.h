@@ -0,0 +1,105 @@
+//
+//  stdp_deferred_plasticity.h
+//  NEST
+//
+//
+
+/* BeginDocumentation
+ Name: stdp_deferred_plasticity - Device batching the plasticity of
+ stdp_triplet_all_in_one_synapse.
+
+ Description:
+ Once created, stdp_triplet_all_in_one_synapse connections deliver their
+ spikes with their current weight and queue their plasticity update instead
+ of running it during delivery. Every min delay slice, after delivery, the
+ device applies the queued updates grouped by post-synaptic target, so that
+ the history of each target is read in one pass instead of being interleaved
+ with the ones of unrelated targets.
+
+ Updates of a connection are applied in the order of its spikes with the
+ same spike times and history as inline, weights thus end up identical.
+ Delivered weights lag behind by the updates of the current slice, and a
+ pruned connection still delivers the spike that pruned it.
+
+ The device is replicated on each thread, each instance applying the updates
+ of its thread. Deferral stops when the device is deleted (ResetKernel).
+
+ States:
+ n_updates          int: updates applied by this instance
+
+ SeeAlso: stdp_triplet_all_in_one_synapse
+ */
+
+#ifndef STDP_DEFERRED_PLASTICITY_H
+#define STDP_DEFERRED_PLASTICITY_H
+
+#include <vector>
+
+#include "nest.h"
+#include "node.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+class STDPDeferredPlasticity : public Node {
+
+public:
+  /**
+   * Plasticity update of a connection, applied by a function of the
+   * connection type.
+   */
+  struct Update {
+    void (*apply_)(const Update &, thread);
+    void *connection_;
+    Node *target_;
+    nest::index source_;
+    double_t t_last_prespike_;
+    double_t t_spike_;
+
+    /**
+     * Order of updates in a batch, by target.
+     */
+    static bool by_target(const Update &a, const Update &b) {
+      return a.target_ < b.target_;
+    }
+  };
+
+  STDPDeferredPlasticity();
+  STDPDeferredPlasticity(const STDPDeferredPlasticity &);
+  ~STDPDeferredPlasticity();
+
+  bool has_proxies() const { return false; }
+
+  /**
+   * Whether updates of connections of a thread are deferred.
+   */
+  static bool deferred(thread t) {
+    return static_cast<size_t>(t) < enabled_.size() and enabled_[t];
+  }
+
+  /**
+   * Queue an update of a connection of a thread.
+   */
+  static void defer(thread t, const Update &update) {
+    queues_[t].push_back(update);
+  }
+
+  void get_status(DictionaryDatum &) const;
+  void set_status(const DictionaryDatum &) {}
+
+private:
+  void init_state_(const Node &) {}
+  void init_buffers_() {}
+  void calibrate();
+
+  void update(Time const &, const long_t, const long_t);
+
+  long_t n_updates_;
+  bool enabled_here_;
+
+  static std::vector<char> enabled_;
+  static std::vector<std::vector<Update> > queues_;
+};
+}
+
+#endif /* STDP_DEFERRED_PLASTICITY_H */
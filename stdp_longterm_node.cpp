@@ -6,17 +6,26 @@
 
 #include "stdp_longterm_node.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "stdpnames.h"
+#include "stdp_statistics.h"
+#include "stdp_plasticity.h"
 #include "network.h"
 #include "namedatum.h"
 #include "universal_data_logger_impl.h"
 
 using namespace nest;
 
+static const double_t unbounded = std::numeric_limits<double_t>::infinity();
+
 /* ----------------------------------------------------------- devices */
 
 nest::RecordablesMap<stdpmodule::STDPLongNeuron>
     stdpmodule::STDPLongNeuron::recordablesMap_;
+stdpmodule::STDPStatistics::Model
+    stdpmodule::STDPLongNeuron::stdp_model_ = 0;
 
 // Override the create() method with one call to RecordablesMap::insert_()
 // for each quantity to be recorded.
@@ -38,7 +47,10 @@ template <> void RecordablesMap<stdpmodule::STDPLongNeuron>::create() {
 stdpmodule::STDPLongNeuron::Parameters_::Parameters_()
     : tau_plus_(20), tau_slow_(100), tau_minus_(20), tau_ht_(100),
       tau_hom_(20 * 60 * 1000), tau_const_(20 * 60 * 1000), A_(5e-3), P_(20),
-      WP_(0.5), beta_(0.05), delta_(2e-5), nearest_spike_(false) {}
+      WP_(0.5), beta_(0.05), delta_(2e-5), nearest_spike_(false),
+      prune_threshold_(-unbounded), prune_time_(0.0), subsampling_(1),
+      rate_based_(false), rate_interval_(100.0), rate_tau_(1000.0),
+      hub_(0) {}
 
 void stdpmodule::STDPLongNeuron::Parameters_::get(DictionaryDatum &d) const {
   def<double_t>(d, stdpnames::tau_plus, tau_plus_);
@@ -53,6 +65,13 @@ void stdpmodule::STDPLongNeuron::Parameters_::get(DictionaryDatum &d) const {
   def<double_t>(d, stdpnames::beta, beta_);
   def<double_t>(d, stdpnames::delta, delta_);
   def<bool>(d, stdpnames::nearest_spike, nearest_spike_);
+  def<double_t>(d, stdpnames::prune_threshold, prune_threshold_);
+  def<double_t>(d, stdpnames::prune_time, prune_time_);
+  def<long_t>(d, stdpnames::plasticity_subsampling, subsampling_);
+  def<bool>(d, stdpnames::rate_based, rate_based_);
+  def<double_t>(d, stdpnames::rate_interval, rate_interval_);
+  def<double_t>(d, stdpnames::rate_tau, rate_tau_);
+  def<long_t>(d, stdpnames::hub, hub_);
 }
 
 void stdpmodule::STDPLongNeuron::Parameters_::set(const DictionaryDatum &d) {
@@ -69,13 +88,42 @@ void stdpmodule::STDPLongNeuron::Parameters_::set(const DictionaryDatum &d) {
   updateValue<double_t>(d, stdpnames::beta, beta_);
   updateValue<double_t>(d, stdpnames::delta, delta_);
   updateValue<bool>(d, stdpnames::nearest_spike, nearest_spike_);
+  updateValue<double_t>(d, stdpnames::prune_threshold, prune_threshold_);
+  updateValue<double_t>(d, stdpnames::prune_time, prune_time_);
+  updateValue<long_t>(d, stdpnames::plasticity_subsampling, subsampling_);
+  updateValue<bool>(d, stdpnames::rate_based, rate_based_);
+  updateValue<double_t>(d, stdpnames::rate_interval, rate_interval_);
+  updateValue<double_t>(d, stdpnames::rate_tau, rate_tau_);
+  updateValue<long_t>(d, stdpnames::hub, hub_);
+
+  if (!(prune_time_ >= 0)) {
+    throw BadProperty("Parameter prune_time must be positive.");
+  }
+
+  if (subsampling_ < 1) {
+    throw BadProperty("Parameter plasticity_subsampling must be at least 1.");
+  }
+
+  if (!(rate_interval_ > 0)) {
+    throw BadProperty("Parameter rate_interval must be strictly positive.");
+  }
+
+  if (!(rate_tau_ > 0)) {
+    throw BadProperty("Parameter rate_tau must be strictly positive.");
+  }
+
+  if (hub_ < 0) {
+    throw BadProperty("Parameter hub must be a gid or 0.");
+  }
 }
 
 /* ----------------------------------------------------------- states */
 
 stdpmodule::STDPLongNeuron::State_::State_()
     : weight_(1.0), weight_ref_(1.0), B_(5e-3), C_(0.0), Zplus_(0.0),
-      Zslow_(0.0), Zminus_(0.0), Zht_(0.0) {}
+      Zslow_(0.0), Zminus_(0.0), Zht_(0.0), t_depressed_(-1), t_traces_(-1),
+      active_(true), rate_pre_(0.0), rate_post_(0.0), rate_covariance_(0.0),
+      n_pre_(0.0), n_post_(0.0) {}
 
 void stdpmodule::STDPLongNeuron::State_::get(DictionaryDatum &d) const {
   def<double_t>(d, names::weight, weight_);
@@ -86,6 +134,10 @@ void stdpmodule::STDPLongNeuron::State_::get(DictionaryDatum &d) const {
   def<double_t>(d, stdpnames::Zslow, Zslow_);
   def<double_t>(d, stdpnames::Zminus, Zminus_);
   def<double_t>(d, stdpnames::Zht, Zht_);
+  def<bool>(d, stdpnames::active, active_);
+  def<double_t>(d, stdpnames::rate_pre, 1000.0 * rate_pre_);
+  def<double_t>(d, stdpnames::rate_post, 1000.0 * rate_post_);
+  def<double_t>(d, stdpnames::rate_covariance, rate_covariance_);
 }
 
 void stdpmodule::STDPLongNeuron::State_::set(const DictionaryDatum &d) {
@@ -97,6 +149,110 @@ void stdpmodule::STDPLongNeuron::State_::set(const DictionaryDatum &d) {
   updateValue<double_t>(d, stdpnames::Zslow, Zslow_);
   updateValue<double_t>(d, stdpnames::Zminus, Zminus_);
   updateValue<double_t>(d, stdpnames::Zht, Zht_);
+  updateValue<bool>(d, stdpnames::active, active_);
+
+  double_t rate_pre = 1000.0 * rate_pre_;
+  double_t rate_post = 1000.0 * rate_post_;
+  updateValue<double_t>(d, stdpnames::rate_pre, rate_pre);
+  updateValue<double_t>(d, stdpnames::rate_post, rate_post);
+  updateValue<double_t>(d, stdpnames::rate_covariance, rate_covariance_);
+  rate_pre_ = rate_pre / 1000.0;
+  rate_post_ = rate_post / 1000.0;
+}
+
+void stdpmodule::STDPLongNeuron::State_::decay(long_t step,
+                                               const Parameters_ &p) {
+  if (step <= t_traces_) {
+    return;
+  }
+
+  longterm_rule::decay_over(*this, p,
+                            Time(Time::step(step - t_traces_)).get_ms());
+  t_traces_ = step;
+}
+
+double *stdpmodule::STDPLongNeuron::plastic_value(const Name &name) {
+  S_.decay(network()->get_time().get_steps() - 1, P_);
+
+  if (name == names::weight) {
+    return &S_.weight_;
+  }
+  if (name == stdpnames::weight_ref) {
+    return &S_.weight_ref_;
+  }
+  if (name == stdpnames::B) {
+    return &S_.B_;
+  }
+  if (name == stdpnames::C) {
+    return &S_.C_;
+  }
+  if (name == stdpnames::Zplus) {
+    return &S_.Zplus_;
+  }
+  if (name == stdpnames::Zslow) {
+    return &S_.Zslow_;
+  }
+  if (name == stdpnames::Zminus) {
+    return &S_.Zminus_;
+  }
+  if (name == stdpnames::Zht) {
+    return &S_.Zht_;
+  }
+  return 0;
+}
+
+void stdpmodule::STDPLongNeuron::write_plastic_state(double *values) const {
+  const long_t now = network()->get_time().get_steps();
+  State_ s = S_;
+  s.decay(now - 1, P_);
+
+  values[0] = s.weight_;
+  values[1] = s.weight_ref_;
+  values[2] = s.B_;
+  values[3] = s.C_;
+  values[4] = s.Zplus_;
+  values[5] = s.Zslow_;
+  values[6] = s.Zminus_;
+  values[7] = s.Zht_;
+  values[8] = s.active_;
+  // steps at or below the pruning threshold, -1 when above
+  values[9] = s.t_depressed_ < 0 ? -1.0 : now - s.t_depressed_;
+  values[10] = s.rate_pre_;
+  values[11] = s.rate_post_;
+  values[12] = s.rate_covariance_;
+  values[13] = s.n_pre_;
+  values[14] = s.n_post_;
+}
+
+void stdpmodule::STDPLongNeuron::read_plastic_state(const double *values) {
+  const long_t now = network()->get_time().get_steps();
+
+  S_.weight_ = values[0];
+  S_.weight_ref_ = values[1];
+  S_.B_ = values[2];
+  S_.C_ = values[3];
+  S_.Zplus_ = values[4];
+  S_.Zslow_ = values[5];
+  S_.Zminus_ = values[6];
+  S_.Zht_ = values[7];
+  // buffers of revived nodes are drawn again on calibration
+  S_.active_ = values[8] != 0.0;
+  S_.t_depressed_ =
+      values[9] < 0.0 ? -1 : now - static_cast<long_t>(values[9]);
+  S_.rate_pre_ = values[10];
+  S_.rate_post_ = values[11];
+  S_.rate_covariance_ = values[12];
+  S_.n_pre_ = values[13];
+  S_.n_post_ = values[14];
+
+  // traces were written at their time, which becomes the restore time
+  S_.t_traces_ = now - 1;
+}
+
+size_t stdpmodule::STDPLongNeuron::memory_size() const {
+  return sizeof(STDPLongNeuron) + B_.n_pre_spikes_.memory_size() +
+         B_.n_post_spikes_.memory_size() +
+         V_.decays_.memory_size();
 }
 
 /* ----------------------------------------------------------- buffers */
@@ -113,16 +269,22 @@ stdpmodule::STDPLongNeuron::Buffers_::Buffers_(const Buffers_ &,
 stdpmodule::STDPLongNeuron::STDPLongNeuron()
     : Archiving_Node(), P_(), S_(), B_(*this) {
   recordablesMap_.create();
+  V_.statistics_epoch_ = -1;
+  V_.hub_ = 0;
 }
 
 stdpmodule::STDPLongNeuron::STDPLongNeuron(const STDPLongNeuron &n)
-    : Archiving_Node(n), P_(n.P_), S_(n.S_), B_(n.B_, *this) {}
+    : Archiving_Node(n), P_(n.P_), S_(n.S_), B_(n.B_, *this) {
+  V_.statistics_epoch_ = -1;
+  V_.hub_ = 0;
+}
 
 /* ----------------------------------------------------------- initialization */
 
 void stdpmodule::STDPLongNeuron::init_buffers_() {
-  B_.n_pre_spikes_.clear();
-  B_.n_post_spikes_.clear();
+  // buffers are drawn again on calibration
+  B_.n_pre_spikes_.release();
+  B_.n_post_spikes_.release();
   B_.logger_.reset();
   Archiving_Node::clear_history();
 }
@@ -132,11 +294,42 @@ void stdpmodule::STDPLongNeuron::calibrate() {
 
   const double negative_delta = -Time::get_resolution().get_ms();
 
-  // precompute decays
-  V_.Zplus_decay_ = std::exp(negative_delta / P_.tau_plus_);
-  V_.Zslow_decay_ = std::exp(negative_delta / P_.tau_slow_);
-  V_.Zminus_decay_ = std::exp(negative_delta / P_.tau_minus_);
-  V_.Zht_decay_ = std::exp(negative_delta / P_.tau_ht_);
+  // precompute decays over up to one subsampling bin
+  V_.subsampling_ = P_.subsampling_;
+  V_.decays_.assign(get_thread(), 4 * (V_.subsampling_ + 1));
+  for (long_t n = 0; n <= V_.subsampling_; ++n) {
+    V_.decays_[4 * n] = std::exp(n * negative_delta / P_.tau_plus_);
+    V_.decays_[4 * n + 1] = std::exp(n * negative_delta / P_.tau_slow_);
+    V_.decays_[4 * n + 2] = std::exp(n * negative_delta / P_.tau_minus_);
+    V_.decays_[4 * n + 3] = std::exp(n * negative_delta / P_.tau_ht_);
+  }
+
+  V_.prune_steps_ = Time(Time::ms(P_.prune_time_)).get_steps();
+
+  V_.rate_steps_ =
+      std::max(Time(Time::ms(P_.rate_interval_)).get_steps(), (long_t)1);
+  V_.rate_decay_ =
+      std::exp(-Time(Time::step(V_.rate_steps_)).get_ms() / P_.rate_tau_);
+
+  V_.hub_ = P_.hub_ == 0 ? 0 : STDPPostHub::accumulator(P_.hub_);
+
+  // pruned nodes keep no buffers, revived ones get them back
+  if (!S_.active_) {
+    B_.n_pre_spikes_.release();
+    B_.n_post_spikes_.release();
+    return;
+  }
+
+  if (B_.n_pre_spikes_.size() == 0) {
+    B_.n_pre_spikes_.clear(get_thread());
+    B_.n_post_spikes_.clear(get_thread());
+  }
+
+  depressed_(network()->get_time().get_steps());
+
+  // weights of this model are unbounded
+  STDPStatistics::enter(stdp_model_, get_thread(), V_.statistics_epoch_,
+                        S_.weight_, -unbounded, unbounded);
 }
 
 /* ----------------------------------------------------------- updates */
@@ -146,70 +339,258 @@ void stdpmodule::STDPLongNeuron::update(Time const &origin, const long_t from,
   assert(to >= 0 && (delay)from < Scheduler::get_min_delay());
   assert(from < to);
 
-  const double delta = Time::get_resolution().get_ms();
+  if (!S_.active_) {
+    return;
+  }
+
+  if (V_.hub_ != 0) {
+    receive_(origin, from, to);
+  }
+
+  // the rate-based mode gates its drift itself, the spike-based mode runs the
+  // slice in segments of constant plasticity
+  if (P_.rate_based_) {
+    update_rates_(origin, from, to);
+  } else {
+    for (long_t lag = from; lag < to;) {
+      long_t until;
+      const bool plastic = STDPPlasticity::plastic_steps(
+          stdp_model_, origin.get_steps() + lag, origin.get_steps() + to,
+          until);
+
+      if (plastic) {
+        update_plastic_(origin, lag, until - origin.get_steps());
+      } else {
+        update_gated_(origin, lag, until - origin.get_steps());
+      }
+      lag = until - origin.get_steps();
+    }
+  }
+
+  // pruning happens at slice boundaries only
+  if (S_.t_depressed_ >= 0 and
+      origin.get_steps() + to - S_.t_depressed_ >= V_.prune_steps_) {
+    prune_();
+  }
+}
+
+void stdpmodule::STDPLongNeuron::update_plastic_(Time const &origin,
+                                                 const long_t from,
+                                                 const long_t to) {
+  // slow variables are integrated once per subsampling bin
+  const double delta = V_.subsampling_ * Time::get_resolution().get_ms();
+
+  decay_to_(origin.get_steps() + from - 1);
 
   for (long_t lag = from; lag < to; ++lag) {
 
+    const long_t step = origin.get_steps() + lag;
     const double_t current_pre_spikes_n = B_.n_pre_spikes_.get_value(lag);
     const double_t current_post_spikes_n = B_.n_post_spikes_.get_value(lag);
+    const bool bin_end = (step + 1) % V_.subsampling_ == 0;
 
-    // model states decay
-    S_.Zplus_ *= V_.Zplus_decay_;
-    S_.Zslow_ *= V_.Zslow_decay_;
-    S_.Zminus_ *= V_.Zminus_decay_;
-    S_.Zht_ *= V_.Zht_decay_;
+    // model states decay, on spikes and at the end of subsampling bins
+    if (current_pre_spikes_n > 0 or current_post_spikes_n > 0 or bin_end) {
+      decay_to_(step);
+    }
 
     // others states variables
-    S_.weight_ref_ +=
-        (S_.weight_ - S_.weight_ref_ -
-         P_.P_ * S_.weight_ref_ * (P_.WP_ / 2.0 - S_.weight_ref_) *
-             (P_.WP_ - S_.weight_ref_)) /
-        P_.tau_const_ * delta; // (16)
-    S_.C_ +=
-        (-S_.C_ / P_.tau_hom_ + S_.Zht_ * S_.Zht_ / 1000.0) * delta; // (18)
-    S_.B_ = P_.A_ * std::min(S_.C_, 1.0);                            // (17)
+    if (bin_end) {
+      longterm_rule::consolidate(S_, P_, delta, S_.Zht_ * S_.Zht_);
+    }
 
     if (current_pre_spikes_n > 0) {
 
       // depress: t = t^pre
-      S_.weight_ -= S_.B_ * S_.Zminus_ // doublet LTD (12)
-                    + P_.delta_;       // transmitter - induced (14)
-
-      S_.Zplus_ += 1.0;
+      const double_t weight = S_.weight_;
+      S_.weight_ += longterm_rule::on_pre(S_, P_);
+      STDPStatistics::record(stdp_model_, get_thread(), V_.statistics_epoch_,
+                             weight, S_.weight_, -unbounded, unbounded);
+      depressed_(step);
 
-      if (P_.nearest_spike_) {
-      }
-
-      SpikeEvent se;
-      se.set_multiplicity(current_pre_spikes_n);
-      se.set_weight(S_.weight_);
-      network()->send(*this, se, lag);
+      send_(origin.get_steps() + lag, lag, current_pre_spikes_n);
     }
 
     if (current_post_spikes_n > 0) {
 
       // potentiate: t = t^post
-      S_.weight_ += P_.A_ * S_.Zplus_ * S_.Zslow_ // triplet LTP (11)
-                    -
-                    P_.beta_ * (S_.weight_ - 1.0) * S_.Zminus_ * S_.Zminus_ *
-                        S_.Zminus_; // heterosynpatic (13)
+      const double_t weight = S_.weight_;
+      S_.weight_ += longterm_rule::on_post(S_, P_);
+      STDPStatistics::record(stdp_model_, get_thread(), V_.statistics_epoch_,
+                             weight, S_.weight_, -unbounded, unbounded);
+      depressed_(step);
+    }
+
+    B_.logger_.record_data(step);
+  }
+}
+
+void stdpmodule::STDPLongNeuron::update_rates_(Time const &origin,
+                                               const long_t from,
+                                               const long_t to) {
+  for (long_t lag = from; lag < to; ++lag) {
+
+    const long_t step = origin.get_steps() + lag;
+    const double_t current_pre_spikes_n = B_.n_pre_spikes_.get_value(lag);
+    const double_t current_post_spikes_n = B_.n_post_spikes_.get_value(lag);
+
+    S_.n_pre_ += current_pre_spikes_n;
+    S_.n_post_ += current_post_spikes_n;
+
+    if (current_pre_spikes_n > 0) {
+      send_(origin.get_steps() + lag, lag, current_pre_spikes_n);
+    }
+
+    if ((step + 1) % V_.rate_steps_ == 0) {
+      drift_(step);
+    }
+
+    B_.logger_.record_data(step);
+  }
+}
+
+void stdpmodule::STDPLongNeuron::drift_(long_t step) {
+  const double_t interval = Time(Time::step(V_.rate_steps_)).get_ms();
+  const double_t pre = S_.n_pre_ / interval;
+  const double_t post = S_.n_post_ / interval;
+  S_.n_pre_ = 0.0;
+  S_.n_post_ = 0.0;
+
+  const double_t decay = V_.rate_decay_;
+  S_.rate_pre_ = decay * S_.rate_pre_ + (1.0 - decay) * pre;
+  S_.rate_post_ = decay * S_.rate_post_ + (1.0 - decay) * post;
+  S_.rate_covariance_ =
+      decay * S_.rate_covariance_ +
+      (1.0 - decay) * (pre - S_.rate_pre_) * (post - S_.rate_post_) * interval;
+
+  if (!STDPPlasticity::plastic(stdp_model_,
+                               Time(Time::step(step + 1)).get_ms())) {
+    return;
+  }
+
+  const double_t x = S_.rate_pre_;
+  const double_t y = S_.rate_post_;
+
+  // moments of the post-synaptic traces seen at post-synaptic spikes
+  const double_t minus = y * P_.tau_minus_;
+  const double_t minus_cubed =
+      minus * minus * minus + 1.5 * minus * minus + minus / 3.0;
+  const double_t ht = y * P_.tau_ht_;
+  const double_t ht_squared = ht * ht + ht / 2.0;
+
+  longterm_rule::consolidate(S_, P_, interval, ht_squared);
+
+  // expected drift of (11)-(14) under Poisson statistics
+  const double_t drift =
+      y * (P_.A_ * P_.tau_plus_ * x * P_.tau_slow_ * y -
+           P_.beta_ * (S_.weight_ - 1.0) * minus_cubed) -
+      x * (S_.B_ * P_.tau_minus_ * y + P_.delta_) +
+      (P_.A_ * P_.tau_slow_ * y - S_.B_) * S_.rate_covariance_ / 2.0;
+
+  const double_t weight = S_.weight_;
+  S_.weight_ += drift * interval;
+  STDPStatistics::record(stdp_model_, get_thread(), V_.statistics_epoch_,
+                         weight, S_.weight_, -unbounded, unbounded);
+  depressed_(step);
+}
+
+void stdpmodule::STDPLongNeuron::decay_to_(long_t step) {
+  const long_t n = step - S_.t_traces_;
+
+  if (n <= 0) {
+    return;
+  }
+
+  if (n > V_.subsampling_) {
+    S_.decay(step, P_);
+    return;
+  }
+
+  longterm_rule::decay(S_, V_.decays_[4 * n], V_.decays_[4 * n + 1],
+                       V_.decays_[4 * n + 2], V_.decays_[4 * n + 3]);
+  S_.t_traces_ = step;
+}
+
+void stdpmodule::STDPLongNeuron::update_gated_(Time const &origin,
+                                               const long_t from,
+                                               const long_t to) {
+  for (long_t lag = from; lag < to; ++lag) {
+
+    const double_t current_pre_spikes_n = B_.n_pre_spikes_.get_value(lag);
+    const double_t current_post_spikes_n = B_.n_post_spikes_.get_value(lag);
+
+    // Z traces follow spikes, weight, weight_ref, B and C are held
+    if (current_pre_spikes_n > 0) {
+      S_.decay(origin.get_steps() + lag, P_);
+
+      S_.Zplus_ += 1.0;
+
+      send_(origin.get_steps() + lag, lag, current_pre_spikes_n);
+    }
+
+    if (current_post_spikes_n > 0) {
+      S_.decay(origin.get_steps() + lag, P_);
 
       S_.Zslow_ += 1.0;
       S_.Zminus_ += 1.0;
       S_.Zht_ += 1.0;
-
-      if (P_.nearest_spike_) {
-      }
     }
 
     B_.logger_.record_data(origin.get_steps() + lag);
   }
 }
 
+void stdpmodule::STDPLongNeuron::receive_(Time const &origin,
+                                          const long_t from, const long_t to) {
+  for (long_t lag = from; lag < to; ++lag) {
+    const double_t n = V_.hub_->post_spikes(origin.get_steps() + lag);
+    if (n != 0.0) {
+      B_.n_post_spikes_.add_value(lag, n);
+    }
+  }
+}
+
+void stdpmodule::STDPLongNeuron::send_(long_t step, long_t lag,
+                                       long_t multiplicity) {
+  if (V_.hub_ != 0) {
+    V_.hub_->add(get_thread(), step, S_.weight_ * multiplicity);
+    return;
+  }
+
+  SpikeEvent se;
+  se.set_multiplicity(multiplicity);
+  se.set_weight(S_.weight_);
+  network()->send(*this, se, lag);
+}
+
+void stdpmodule::STDPLongNeuron::depressed_(long_t step) {
+  if (S_.weight_ > P_.prune_threshold_) {
+    S_.t_depressed_ = -1;
+  } else if (S_.t_depressed_ < 0) {
+    S_.t_depressed_ = step;
+  }
+}
+
+void stdpmodule::STDPLongNeuron::prune_() {
+  S_.active_ = false;
+  S_.t_depressed_ = -1;
+
+  STDPStatistics::prune(stdp_model_, get_thread(), V_.statistics_epoch_,
+                        S_.weight_, -unbounded, unbounded);
+
+  B_.n_pre_spikes_.release();
+  B_.n_post_spikes_.release();
+  Archiving_Node::clear_history();
+}
+
 void stdpmodule::STDPLongNeuron::handle(SpikeEvent &e) {
 
   assert(e.get_delay() > 0);
 
+  if (!S_.active_) {
+    return;
+  }
+
   switch (e.get_rport()) {
   case 0: // PRE
     B_.n_pre_spikes_.add_value(
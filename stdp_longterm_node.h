@@ -7,19 +7,26 @@
 #ifndef STDP_LONG_NEURON_H
 #define STDP_LONG_NEURON_H
 
+#include <vector>
+
 #include "nest.h"
 #include "event.h"
 #include "archiving_node.h"
-#include "ring_buffer.h"
 #include "namedatum.h"
 #include "universal_data_logger.h"
 
+#include "plastic_node.h"
+#include "spike_ring_buffer.h"
+#include "stdp_statistics.h"
+#include "stdp_longterm_rule.h"
+#include "stdp_post_hub.h"
+
 namespace stdpmodule {
 using namespace nest;
 
 class Network;
 
-class STDPLongNeuron : public Archiving_Node {
+class STDPLongNeuron : public Archiving_Node, public PlasticNode {
 
 public:
   STDPLongNeuron();
@@ -38,12 +45,61 @@ public:
   void handle(SpikeEvent &);
   void handle(DataLoggingRequest &);
 
+  unsigned int plastic_state_version() const { return 1; }
+  size_t plastic_state_size() const { return 15; }
+  void write_plastic_state(double *) const;
+  void read_plastic_state(const double *);
+  double *plastic_value(const Name &);
+  size_t memory_size() const;
+
+  /**
+   * Register the model under its kernel name, for statistics, plasticity
+   * schedules and pruning counts.
+   */
+  static void register_stdp_model(const std::string &name) {
+    stdp_model_ = STDPStatistics::register_model(name);
+  }
+
 private:
   void init_state_(const Node &proto) {}
   void init_buffers_();
   void calibrate();
 
   void update(Time const &, const long_t, const long_t);
+  void update_plastic_(Time const &, const long_t, const long_t);
+  void update_gated_(Time const &, const long_t, const long_t);
+  void update_rates_(Time const &, const long_t, const long_t);
+
+  /**
+   * Update the rate estimates from the spikes of the last interval and apply
+   * the expected drift of the rule over it (Poisson statistics, symmetric
+   * correlations much shorter than the time constants), slow variables are
+   * integrated over the interval.
+   */
+  void drift_(long_t step);
+
+  /**
+   * Decay the Z traces up to the given step from the table of decays.
+   */
+  void decay_to_(long_t step);
+
+  /**
+   * Add the post-synaptic spikes shared by the hub to the buffers of the
+   * slice.
+   */
+  void receive_(Time const &, const long_t, const long_t);
+
+  /**
+   * Forward pre-synaptic spikes of the given step with the weight, to the
+   * post-synaptic neuron or to the accumulator of the hub.
+   */
+  void send_(long_t step, long_t lag, long_t multiplicity);
+
+  /**
+   * Track since when the weight is at or below the pruning threshold.
+   */
+  void depressed_(long_t step);
+  void prune_();
 
   friend class RecordablesMap<STDPLongNeuron>;
   friend class UniversalDataLogger<STDPLongNeuron>;
@@ -64,6 +120,17 @@ private:
 
     bool nearest_spike_;
 
+    double_t prune_threshold_;
+    double_t prune_time_;
+
+    long_t subsampling_;
+
+    bool rate_based_;
+    double_t rate_interval_;
+    double_t rate_tau_;
+
+    long_t hub_;
+
     Parameters_();
     void get(DictionaryDatum &) const;
     void set(const DictionaryDatum &);
@@ -80,14 +147,30 @@ private:
     double_t Zminus_;
     double_t Zht_;
 
+    long_t t_depressed_;
+    long_t t_traces_;
+    bool active_;
+
+    // rate estimates (1/ms) and spike counts of the current interval
+    double_t rate_pre_;
+    double_t rate_post_;
+    double_t rate_covariance_;
+    double_t n_pre_;
+    double_t n_post_;
+
     State_();
     void get(DictionaryDatum &) const;
     void set(const DictionaryDatum &);
+
+    /**
+     * Decay the Z traces up to the given step, once they lag behind.
+     */
+    void decay(long_t step, const Parameters_ &);
   };
 
   struct Buffers_ {
-    RingBuffer n_pre_spikes_;
-    RingBuffer n_post_spikes_;
+    SpikeRingBuffer n_pre_spikes_;
+    SpikeRingBuffer n_post_spikes_;
     UniversalDataLogger<STDPLongNeuron> logger_;
 
     Buffers_(STDPLongNeuron &);
@@ -95,10 +178,20 @@ private:
   };
 
   struct Variables_ {
-    double_t Zplus_decay_;
-    double_t Zslow_decay_;
-    double_t Zminus_decay_;
-    double_t Zht_decay_;
+    long_t subsampling_;
+    // decays of Zplus, Zslow, Zminus and Zht over 0 to subsampling steps
+    ArenaArray decays_;
+
+    long_t prune_steps_;
+    long_t statistics_epoch_;
+
+    long_t rate_steps_;
+    // decay of the rate estimates over one interval
+    double_t rate_decay_;
+
+    // accumulator of the hub, 0 when spikes are sent to the post-synaptic
+    // neuron
+    STDPPostHub::Accumulator *hub_;
   };
 
   // Access functions for UniversalDataLogger
@@ -117,6 +210,7 @@ private:
   Buffers_ B_;
 
   static RecordablesMap<STDPLongNeuron> recordablesMap_;
+  static STDPStatistics::Model stdp_model_;
 };
 
 inline port STDPLongNeuron::send_test_event(Node &target, rport receptor_type,
@@ -144,13 +238,18 @@ inline port STDPLongNeuron::handles_test_event(DataLoggingRequest &dlr,
 }
 
 inline void STDPLongNeuron::get_status(DictionaryDatum &d) const {
+  // traces are not decayed while not plastic
+  State_ s = S_;
+  s.decay(network()->get_time().get_steps() - 1, P_);
+
   P_.get(d);
-  S_.get(d);
+  s.get(d);
   Archiving_Node::get_status(d);
   (*d)[names::recordables] = recordablesMap_.get_list();
 }
 
 inline void STDPLongNeuron::set_status(const DictionaryDatum &d) {
+  S_.decay(network()->get_time().get_steps() - 1, P_);
   P_.set(d);
   S_.set(d);
   Archiving_Node::set_status(d);
@@ -0,0 +1,90 @@
+//
+//  stdp_longterm_rule.h
+//  NEST
+//
+//
+
+#ifndef STDP_LONGTERM_RULE_H
+#define STDP_LONGTERM_RULE_H
+
+#include <algorithm>
+#include <cmath>
+
+namespace stdpmodule {
+
+/**
+ * Kernels of the long-term stable rule (Zenke 2015), shared by
+ * stdp_longterm_node and the offline replay (replay/stdp_replay.cpp). They
+ * work on any state and parameters holding the members of stdp_longterm_node
+ * (weight_, weight_ref_, B_, C_, Zplus_, Zslow_, Zminus_, Zht_ and tau_*_,
+ * A_, P_, WP_, beta_, delta_), without the simulation kernel.
+ */
+namespace longterm_rule {
+
+typedef double double_t;
+
+/**
+ * Decay of the Z traces by one factor each, e.g. taken from a table.
+ */
+template <typename S>
+inline void decay(S &s, double_t plus, double_t slow, double_t minus,
+                  double_t ht) {
+  s.Zplus_ *= plus;
+  s.Zslow_ *= slow;
+  s.Zminus_ *= minus;
+  s.Zht_ *= ht;
+}
+
+/**
+ * Decay of the Z traces over an interval (ms).
+ */
+template <typename S, typename P>
+inline void decay_over(S &s, const P &p, double_t interval) {
+  decay(s, std::exp(-interval / p.tau_plus_), std::exp(-interval / p.tau_slow_),
+        std::exp(-interval / p.tau_minus_), std::exp(-interval / p.tau_ht_));
+}
+
+/**
+ * Slow variables over an interval (ms), from the squared homeostatic trace
+ * (Zht^2 on the grid, its expectation in the rate-based mode).
+ */
+template <typename S, typename P>
+inline void consolidate(S &s, const P &p, double_t interval,
+                        double_t Zht_squared) {
+  s.weight_ref_ += (s.weight_ - s.weight_ref_ -
+                    p.P_ * s.weight_ref_ * (p.WP_ / 2.0 - s.weight_ref_) *
+                        (p.WP_ - s.weight_ref_)) /
+                   p.tau_const_ * interval;                          // (16)
+  s.C_ += (-s.C_ / p.tau_hom_ + Zht_squared / 1000.0) * interval; // (18)
+  s.B_ = p.A_ * std::min(s.C_, 1.0);                               // (17)
+}
+
+/**
+ * Pre-synaptic spike: returns the weight change and increments the
+ * pre-synaptic trace.
+ */
+template <typename S, typename P> inline double_t on_pre(S &s, const P &p) {
+  const double_t change = -s.B_ * s.Zminus_ // doublet LTD (12)
+                          - p.delta_;       // transmitter - induced (14)
+  s.Zplus_ += 1.0;
+  return change;
+}
+
+/**
+ * Post-synaptic spike: returns the weight change and increments the
+ * post-synaptic traces.
+ */
+template <typename S, typename P> inline double_t on_post(S &s, const P &p) {
+  const double_t change =
+      p.A_ * s.Zplus_ * s.Zslow_ // triplet LTP (11)
+      - p.beta_ * (s.weight_ - 1.0) * s.Zminus_ * s.Zminus_ *
+            s.Zminus_; // heterosynpatic (13)
+  s.Zslow_ += 1.0;
+  s.Zminus_ += 1.0;
+  s.Zht_ += 1.0;
+  return change;
+}
+}
+}
+
+#endif /* STDP_LONGTERM_RULE_H */
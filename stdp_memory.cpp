@@ -0,0 +1,149 @@
+//
+//  stdp_memory.cpp
+//  NEST
+//
+//
+
+#include "stdp_memory.h"
+
+#include <map>
+#include <string>
+
+#include "stdpnames.h"
+#include "plastic_node.h"
+#include "spike_ring_buffer.h"
+#include "stdp_triplet_node.h"
+#include "stdp_triplet_ensemble_node.h"
+#include "stdp_longterm_node.h"
+#include "stdp_triplet_connection.h"
+#include "static_connection.h"
+#include "archiving_node.h"
+#include "network.h"
+#include "nestmodule.h"
+#include "dictutils.h"
+#include "target_identifier.h"
+
+using namespace nest;
+
+namespace {
+
+typedef stdpmodule::STDPTripletConnection<TargetIdentifierPtrRport>
+    TripletConnection;
+typedef StaticConnection<TargetIdentifierPtrRport> StaticSynapse;
+
+struct Usage {
+  Usage() : n_(0), bytes_(0) {}
+
+  void add(size_t bytes) {
+    ++n_;
+    bytes_ += bytes;
+  }
+
+  DictionaryDatum get() const {
+    DictionaryDatum d(new Dictionary);
+    def<long_t>(d, stdpnames::n, n_);
+    def<long_t>(d, stdpnames::bytes, bytes_);
+    def<double_t>(d, stdpnames::bytes_per_instance,
+                  n_ > 0 ? static_cast<double_t>(bytes_) / n_ : 0.0);
+    return d;
+  }
+
+  size_t n_;
+  size_t bytes_;
+};
+
+/**
+ * Local connections of a synapse model, as counted by the kernel.
+ */
+size_t count_connections(nest::Network &net, const Name &model) {
+  const Dictionary &synapsedict = net.get_synapsedict();
+  if (!synapsedict.known(model)) {
+    return 0;
+  }
+
+  const nest::index syn_id = getValue<long_t>(synapsedict.lookup(model));
+  return getValue<long_t>(net.get_connector_defaults(syn_id),
+                          names::num_connections);
+}
+}
+
+DictionaryDatum stdpmodule::STDPMemory::report() {
+  nest::Network &net = nest::NestModule::get_network();
+
+  std::map<std::string, Usage> models;
+  models["stdp_triplet_node"] = Usage();
+  models["stdp_longterm_node"] = Usage();
+  models["stdp_triplet_ensemble_node"] = Usage();
+
+  Usage history;
+  size_t n_entries = 0;
+  for (nest::index gid = 1; gid < net.size(); ++gid) {
+    if (!net.is_local_gid(gid)) {
+      continue;
+    }
+
+    Node *node = net.get_node(gid);
+    const PlasticNode *plastic = dynamic_cast<PlasticNode *>(node);
+    if (plastic != 0) {
+      models[node->get_name()].add(plastic->memory_size());
+    }
+
+    const Archiving_Node *archiving = dynamic_cast<Archiving_Node *>(node);
+    if (archiving != 0) {
+      DictionaryDatum status(new Dictionary);
+      archiving->Archiving_Node::get_status(status);
+      const long_t length = getValue<long_t>(status, names::archiver_length);
+      if (length > 0) {
+        history.add(length * sizeof(histentry));
+        n_entries += length;
+      }
+    }
+  }
+
+  const size_t n_triplet =
+      count_connections(net, Name("stdp_triplet_all_in_one_synapse"));
+  const size_t n_static = count_connections(net, Name("static_synapse"));
+  models["stdp_triplet_all_in_one_synapse"].n_ = n_triplet;
+  models["stdp_triplet_all_in_one_synapse"].bytes_ =
+      n_triplet * sizeof(TripletConnection);
+  models["static_synapse"].n_ = n_static;
+  models["static_synapse"].bytes_ = n_static * sizeof(StaticSynapse);
+
+  DictionaryDatum result(new Dictionary);
+  size_t bytes = history.bytes_;
+  for (std::map<std::string, Usage>::const_iterator it = models.begin();
+       it != models.end(); ++it) {
+    (*result)[Name(it->first)] = it->second.get();
+    bytes += it->second.bytes_;
+  }
+
+  DictionaryDatum history_status = history.get();
+  def<long_t>(history_status, stdpnames::n_entries, n_entries);
+  (*result)[stdpnames::history] = history_status;
+
+  // arrays drawn from the arenas are part of their nodes, only the unused
+  // space of the arenas adds up
+  DictionaryDatum arena = SpikeArena::get_status();
+  bytes += getValue<long_t>(arena, stdpnames::bytes) -
+           getValue<long_t>(arena, stdpnames::bytes_used);
+  (*result)[stdpnames::arena] = arena;
+  def<long_t>(result, stdpnames::bytes, bytes);
+  (*result)[stdpnames::sizes] = sizes();
+  return result;
+}
+
+DictionaryDatum stdpmodule::STDPMemory::sizes() {
+  DictionaryDatum d(new Dictionary);
+  def<long_t>(d, Name("stdp_triplet_node"), sizeof(STDPTripletNeuron));
+  def<long_t>(d, Name("stdp_longterm_node"), sizeof(STDPLongNeuron));
+  def<long_t>(d, Name("stdp_triplet_ensemble_node"),
+              sizeof(STDPTripletEnsemble));
+  def<long_t>(d, Name("stdp_triplet_all_in_one_synapse"),
+              sizeof(TripletConnection));
+  def<long_t>(d, Name("static_synapse"), sizeof(StaticSynapse));
+  def<long_t>(d, stdpnames::histentry, sizeof(histentry));
+  def<long_t>(d, stdpnames::spike_slot, sizeof(double_t));
+  def<long_t>(d, stdpnames::precise_spike,
+              sizeof(PreciseSpikeRingBuffer::Spike));
+  return d;
+}
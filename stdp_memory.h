@@ -0,0 +1,65 @@
+//
+//  stdp_memory.h
+//  NEST
+//
+//
+
+/* BeginDocumentation
+ Name: stdp_memory - Memory accounting of STDP models.
+
+ Description:
+ GetSTDPMemory reports the bytes used on this rank by every STDP model of the
+ module: its instances, the spike buffers and decay tables STDP nodes
+ allocate, and the spike histories archived for STDP by neurons and nodes.
+ It also reports the sizes of single model instances and elements, from
+ which the memory of a network can be planned before it is built (see
+ PlanSTDPMemory in pynest).
+
+ Report (GetSTDPMemory):
+ <model>            dict: n (local instances), bytes, bytes_per_instance,
+ for stdp_triplet_node, stdp_longterm_node, stdp_triplet_all_in_one_synapse
+ and static_synapse (connections of the STDPNode approach)
+ history            dict: n (archiving nodes with a history), n_entries, bytes
+ arena              dict: bytes reserved by the per-thread arenas spike
+ buffers and decay tables of STDP nodes are drawn from, bytes_used by them
+ (part of their nodes) and n_blocks
+ bytes              int: total of the above, arenas counting for their unused
+ bytes
+ sizes              dict: bytes of one instance of each model, of one history
+ entry (histentry) and of one ring buffer slot (spike_slot, precise_spike)
+
+ Notes:
+ Connections are accounted by their size, the containers of the kernel
+ holding them are not. Histories are accounted by their number of entries,
+ data loggers by their size only (they hold at most one slice of records per
+ recording device).
+
+ SeeAlso: stdp_triplet_node, stdp_longterm_node,
+ stdp_triplet_all_in_one_synapse
+ */
+
+#ifndef STDP_MEMORY_H
+#define STDP_MEMORY_H
+
+#include "nest.h"
+#include "dictdatum.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+class STDPMemory {
+public:
+  /**
+   * Memory used by the STDP models on this rank.
+   * @return dict one usage dictionary per model, history, total and sizes
+   */
+  static DictionaryDatum report();
+
+  /**
+   * Bytes of single model instances and elements.
+   */
+  static DictionaryDatum sizes();
+};
+}
+
+#endif /* STDP_MEMORY_H */
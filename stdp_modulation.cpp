@@ -0,0 +1,92 @@
+//
+//  stdp_modulation.cpp
+//  NEST
+//
+//
+
+#include "stdp_modulation.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace nest;
+
+std::map<nest::long_t, stdpmodule::STDPModulation::Region>
+    stdpmodule::STDPModulation::regions_;
+
+stdpmodule::STDPModulation::Region::Region()
+    : tau_d_(200.0), baseline_(0.0), history_(1000.0), pulses_() {}
+
+void stdpmodule::STDPModulation::Region::add(thread t, double_t time,
+                                             double_t amount) {
+  // pulses mostly arrive in time order, equal times keep their arrival order
+  std::deque<Pulse> &pulses = pulses_[t];
+  Pulse pulse = {time, amount};
+  pulses.insert(
+      std::upper_bound(pulses.begin(), pulses.end(), time, Pulse::before),
+      pulse);
+}
+
+void stdpmodule::STDPModulation::Region::trim(thread t, double_t before) {
+  std::deque<Pulse> &pulses = pulses_[t];
+  while (!pulses.empty() and pulses.front().time_ < before) {
+    pulses.pop_front();
+  }
+}
+
+void stdpmodule::STDPModulation::Region::clear(thread t) {
+  std::deque<Pulse>().swap(pulses_[t]);
+}
+
+nest::double_t stdpmodule::STDPModulation::Region::integrate(
+    thread t, double_t from, double_t to, double_t tau_c, double_t &c,
+    double_t &d) const {
+  if (!(to > from)) {
+    return 0.0;
+  }
+
+  const std::deque<Pulse> &pulses = pulses_[t];
+  std::deque<Pulse>::const_iterator pulse =
+      std::upper_bound(pulses.begin(), pulses.end(), from, Pulse::before);
+
+  // the level jumps at pulses, both traces decay exactly in between
+  double_t integral = 0.0;
+  for (; pulse != pulses.end() and pulse->time_ <= to; ++pulse) {
+    integral += segment_(pulse->time_ - from, tau_c, c, d);
+    d += pulse->amount_;
+    from = pulse->time_;
+  }
+  return integral + segment_(to - from, tau_c, c, d);
+}
+
+nest::double_t stdpmodule::STDPModulation::Region::segment_(
+    double_t elapsed, double_t tau_c, double_t &c, double_t &d) const {
+  if (elapsed == 0.0) {
+    return 0.0;
+  }
+
+  const double_t decay_c = std::exp(-elapsed / tau_c);
+  const double_t decay_d = std::exp(-elapsed / tau_d_);
+  const double_t tau = tau_c * tau_d_ / (tau_c + tau_d_);
+
+  const double_t integral = c * d * tau * (1.0 - decay_c * decay_d) -
+                            c * baseline_ * tau_c * (1.0 - decay_c);
+  c *= decay_c;
+  d *= decay_d;
+  return integral;
+}
+
+stdpmodule::STDPModulation::Region *
+stdpmodule::STDPModulation::region(long_t id, thread n_threads) {
+  Region *region;
+
+// nodes look their region up while being calibrated in parallel
+#pragma omp critical(stdp_modulation)
+  {
+    region = &regions_[id];
+    if (region->pulses_.size() < static_cast<size_t>(n_threads)) {
+      region->pulses_.resize(n_threads);
+    }
+  }
+  return region;
+}
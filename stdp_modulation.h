@@ -0,0 +1,118 @@
+//
+//  stdp_modulation.h
+//  NEST
+//
+//
+
+/* BeginDocumentation
+ Name: stdp_modulation - Shared neuromodulator signals of STDP nodes.
+
+ Description:
+ A region is a neuromodulator signal broadcast to all STDP nodes whose region
+ parameter names it. Its level d decays with tau_d and jumps by the weight of
+ every pulse received by a stdp_modulator of the region. A modulated node
+ feeds the changes of its rule into an eligibility trace c decaying with
+ tau_c, and its weight follows
+
+   dw/dt = c(t) (d(t) - baseline).
+
+ Pulses are kept once per thread and region, nodes do not receive them as
+ events: they integrate the product exactly, from the pulses of their thread,
+ only on their own spikes and at least every history / 2. Modulated learning
+ thus costs one catch-up per spike and history / 2 per node, whatever the
+ number of pulses and nodes.
+
+ Notes:
+ The weight is clamped to [Wmin, Wmax] after each catch-up and is not
+ changed outside learning windows of stdp_plasticity. Pulses older than
+ history are dropped, history must be larger than twice the min delay.
+
+ SeeAlso: stdp_modulator, stdp_triplet_node, stdp_plasticity
+ */
+
+#ifndef STDP_MODULATION_H
+#define STDP_MODULATION_H
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "nest.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+/**
+ * Registry of the neuromodulator signals of all regions.
+ */
+class STDPModulation {
+public:
+  /**
+   * Modulator pulses and parameters of one region.
+   */
+  class Region {
+  public:
+    Region();
+
+    double_t tau_d_;
+    double_t baseline_;
+    double_t history_;
+
+    /**
+     * Add a pulse of the given time (ms) to the pulses of a thread.
+     */
+    void add(thread t, double_t time, double_t amount);
+
+    /**
+     * Drop the pulses of a thread older than the given time (ms).
+     */
+    void trim(thread t, double_t before);
+
+    /**
+     * Drop all pulses of a thread.
+     */
+    void clear(thread t);
+
+    /**
+     * Integrate c (d - baseline) from time from to time to (ms) with the
+     * pulses of a thread, bringing the eligibility c, decaying with tau_c,
+     * and the level d up to time to. Returns the integral.
+     */
+    double_t integrate(thread t, double_t from, double_t to, double_t tau_c,
+                       double_t &c, double_t &d) const;
+
+    size_t n_pulses(thread t) const { return pulses_[t].size(); }
+
+  private:
+    friend class STDPModulation;
+
+    struct Pulse {
+      double_t time_;
+      double_t amount_;
+
+      static bool before(double_t time, const Pulse &p) {
+        return time < p.time_;
+      }
+    };
+
+    /**
+     * Integrate over a time without pulses.
+     */
+    double_t segment_(double_t elapsed, double_t tau_c, double_t &c,
+                      double_t &d) const;
+
+    std::vector<std::deque<Pulse> > pulses_;
+  };
+
+  /**
+   * Region of the given id, created on first use with pulses for the given
+   * number of threads. Regions stay at the same address.
+   */
+  static Region *region(long_t id, thread n_threads);
+
+private:
+  static std::map<long_t, Region> regions_;
+};
+}
+
+#endif /* STDP_MODULATION_H */
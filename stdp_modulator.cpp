@@ -0,0 +1,122 @@
+//
+//  stdp_modulator.cpp
+//  NEST
+//
+//
+
+#include "stdp_modulator.h"
+
+#include "stdpnames.h"
+#include "network.h"
+#include "dictutils.h"
+#include "exceptions.h"
+
+using namespace nest;
+
+/* ----------------------------------------------------------- parameters */
+
+stdpmodule::STDPModulator::Parameters_::Parameters_()
+    : region_(0), tau_d_(200.0), baseline_(0.0), history_(1000.0) {}
+
+void stdpmodule::STDPModulator::Parameters_::get(DictionaryDatum &d) const {
+  def<long_t>(d, stdpnames::region, region_);
+  def<double_t>(d, stdpnames::tau_d, tau_d_);
+  def<double_t>(d, stdpnames::baseline, baseline_);
+  def<double_t>(d, stdpnames::history, history_);
+}
+
+void stdpmodule::STDPModulator::Parameters_::set(const DictionaryDatum &d) {
+  updateValue<long_t>(d, stdpnames::region, region_);
+  updateValue<double_t>(d, stdpnames::tau_d, tau_d_);
+  updateValue<double_t>(d, stdpnames::baseline, baseline_);
+  updateValue<double_t>(d, stdpnames::history, history_);
+
+  if (region_ < 0) {
+    throw BadProperty("Parameter region must be positive.");
+  }
+
+  if (!(tau_d_ > 0)) {
+    throw BadProperty("Parameter tau_d must be strictly positive.");
+  }
+
+  if (!(history_ > 0)) {
+    throw BadProperty("Parameter history must be strictly positive.");
+  }
+}
+
+/* ----------------------------------------------------------- states */
+
+stdpmodule::STDPModulator::State_::State_() : n_events_(0) {}
+
+void stdpmodule::STDPModulator::State_::get(DictionaryDatum &d) const {
+  def<long_t>(d, stdpnames::n_events, n_events_);
+}
+
+/* ----------------------------------------------------------- constructors */
+
+stdpmodule::STDPModulator::STDPModulator() : Node(), P_(), S_() {
+  B_.reset_ = true;
+  V_.region_ = 0;
+}
+
+stdpmodule::STDPModulator::STDPModulator(const STDPModulator &n)
+    : Node(n), P_(n.P_), S_(n.S_) {
+  B_.reset_ = true;
+  V_.region_ = 0;
+}
+
+/* ----------------------------------------------------------- initialization */
+
+void stdpmodule::STDPModulator::init_state_(const Node &proto) {
+  const STDPModulator &pr = downcast<STDPModulator>(proto);
+  S_ = pr.S_;
+}
+
+void stdpmodule::STDPModulator::init_buffers_() { B_.reset_ = true; }
+
+void stdpmodule::STDPModulator::calibrate() {
+  // nodes catch up at slice boundaries once history / 2 has passed, pulses
+  // must outlive a slice more
+  const double_t min_delay =
+      Time(Time::step(Scheduler::get_min_delay())).get_ms();
+  if (P_.history_ < 2 * min_delay) {
+    throw BadProperty("Parameter history must be at least twice the min delay.");
+  }
+
+  V_.region_ =
+      STDPModulation::region(P_.region_, network()->get_num_threads());
+
+  if (B_.reset_) {
+    V_.region_->clear(get_thread());
+    B_.reset_ = false;
+  }
+
+#pragma omp critical(stdp_modulation)
+  {
+    V_.region_->tau_d_ = P_.tau_d_;
+    V_.region_->baseline_ = P_.baseline_;
+    V_.region_->history_ = P_.history_;
+  }
+}
+
+/* ----------------------------------------------------------- updates */
+
+void stdpmodule::STDPModulator::update(Time const &origin, const long_t from,
+                                       const long_t to) {
+  assert(to >= 0 && (delay)from < Scheduler::get_min_delay());
+  assert(from < to);
+
+  // nodes of this thread have caught up within the last history / 2
+  V_.region_->trim(get_thread(), Time(Time::step(origin.get_steps() + to))
+                                         .get_ms() -
+                                     P_.history_);
+}
+
+void stdpmodule::STDPModulator::handle(SpikeEvent &e) {
+  const long_t step = network()->get_slice_origin().get_steps() +
+                      e.get_rel_delivery_steps(network()->get_slice_origin());
+
+  V_.region_->add(get_thread(), Time(Time::step(step + 1)).get_ms(),
+                  e.get_weight() * e.get_multiplicity());
+  ++S_.n_events_;
+}
@@ -0,0 +1,127 @@
+//
+//  stdp_modulator.h
+//  NEST
+//
+//
+
+/* BeginDocumentation
+ Name: stdp_modulator - Device feeding the neuromodulator signal of a region.
+
+ Description:
+ stdp_modulator turns the spikes it receives into pulses of the signal of its
+ region (see stdp_modulation), scaled by their weight. STDP nodes of the
+ region read the signal from a buffer shared by the nodes of each thread and
+ receive no event. Like volume_transmitter, the device is replicated on each
+ thread and every instance receives all spikes, from neurons only (put a
+ parrot_neuron behind spike generators).
+
+ A pulse of a spike arriving at the device at step s is at time (s + 1) h,
+ the time at which STDP nodes see the spikes of step s.
+
+ Parameters:
+ region             int: region of the signal
+ tau_d              double: time constant of the level of the signal (ms)
+ baseline           double: level at which weights do not change
+ history            double: time pulses are kept for (ms), nodes catch up at
+ least every history / 2, at least twice the min delay
+
+ States:
+ n_events           int: pulses received by this instance
+
+ Receives: SpikeEvent
+
+ SeeAlso: stdp_modulation, stdp_triplet_node, volume_transmitter
+ */
+
+#ifndef STDP_MODULATOR_H
+#define STDP_MODULATOR_H
+
+#include "nest.h"
+#include "event.h"
+#include "node.h"
+
+#include "stdp_modulation.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+class STDPModulator : public Node {
+
+public:
+  STDPModulator();
+  STDPModulator(const STDPModulator &);
+
+  bool has_proxies() const { return false; }
+  bool local_receiver() const { return false; }
+
+  using Node::handle;
+  using Node::handles_test_event;
+
+  port handles_test_event(SpikeEvent &, rport);
+
+  void handle(SpikeEvent &);
+
+  void get_status(DictionaryDatum &) const;
+  void set_status(const DictionaryDatum &);
+
+private:
+  void init_state_(const Node &proto);
+  void init_buffers_();
+  void calibrate();
+
+  void update(Time const &, const long_t, const long_t);
+
+  struct Parameters_ {
+    long_t region_;
+    double_t tau_d_;
+    double_t baseline_;
+    double_t history_;
+
+    Parameters_();
+    void get(DictionaryDatum &) const;
+    void set(const DictionaryDatum &);
+  };
+
+  struct State_ {
+    long_t n_events_;
+
+    State_();
+    void get(DictionaryDatum &) const;
+  };
+
+  struct Buffers_ {
+    // pulses of the thread are dropped at the next calibration
+    bool reset_;
+  };
+
+  struct Variables_ {
+    STDPModulation::Region *region_;
+  };
+
+  Parameters_ P_;
+  State_ S_;
+  Variables_ V_;
+  Buffers_ B_;
+};
+
+inline port STDPModulator::handles_test_event(SpikeEvent &,
+                                              rport receptor_type) {
+  if (receptor_type != 0) {
+    throw UnknownReceptorType(receptor_type, get_name());
+  }
+  return 0;
+}
+
+inline void STDPModulator::get_status(DictionaryDatum &d) const {
+  P_.get(d);
+  S_.get(d);
+}
+
+inline void STDPModulator::set_status(const DictionaryDatum &d) {
+  Parameters_ ptmp = P_;
+  ptmp.set(d);
+  P_ = ptmp;
+}
+}
+
+#endif /* STDP_MODULATOR_H */
@@ -0,0 +1,292 @@
+//
+//  stdp_pair_connection.h
+//  NEST
+//
+//  Generated by codegen/stdp_codegen.py from codegen/rules/stdp_pair.json, do not edit.
+//
+
+/* BeginDocumentation
+ Name: stdp_pair_synapse - Synapse type with spike-timing dependent plasticity.
+
+ Description:
+ Pair-based additive STDP with all-to-all spike interactions [1], the pair
+ terms of the triplet rule.
+
+ Parameters:
+ weight             double: current synaptic weight
+ Aminus             double: weight of depression
+ Aplus              double: weight of potentiation
+ Wmax               double: maximum allowed weight
+ Wmin               double: minimum allowed weight
+ prune_threshold    double: weight at or below which the synapse is depressed
+ (pruning is disabled by default)
+ prune_time         double: time the synapse must stay depressed before it is
+ pruned (ms)
+
+ States:
+ weight             double: synaptic weight
+ Kplus              double: pre-synaptic trace (tau tau_plus, on pre-synaptic spikes)
+ Kminus             double: post-synaptic trace (tau tau_minus, on post-synaptic spikes)
+ active             bool: false once pruned, the connection then neither
+ updates nor transmits (set it back to true to revive it)
+ t_depressed        double: time since which the weight is at or below the
+ pruning threshold, -1 when above (ms)
+
+ Notes:
+ Weight updates follow stdp_plasticity and feed stdp_statistics, pruning is
+ checked on pre-synaptic spikes, as for stdp_triplet_all_in_one_synapse. A
+ pruned connection does not read the post-synaptic history, it marks what it
+ skipped as read on its first spike once revived.
+ Constants of the rule are not parameters: tau_minus = 33.7, tau_plus = 16.8.
+
+ Transmits: SpikeEvent
+
+ References:
+ [1] S. Song, K. D. Miller & L. F. Abbott (2000) Competitive Hebbian
+ learning through spike-timing-dependent synaptic plasticity. Nature
+ Neuroscience 3(9):919-926; doi:10.1038/78829
+
+ SeeAlso: stdp_pair_node, stdp_triplet_all_in_one_synapse
+ */
+
+#ifndef STDP_PAIR_CONNECTION_H
+#define STDP_PAIR_CONNECTION_H
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "connection.h"
+#include "stdpnames.h"
+#include "stdp_statistics.h"
+#include "stdp_plasticity.h"
+#include "stdp_pair_names.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+template <typename targetidentifierT>
+class STDPPairConnection : public Connection<targetidentifierT> {
+
+public:
+  typedef CommonSynapseProperties CommonPropertiesType;
+  typedef Connection<targetidentifierT> ConnectionBase;
+
+  STDPPairConnection();
+
+  using ConnectionBase::get_delay_steps;
+  using ConnectionBase::get_delay;
+  using ConnectionBase::get_rport;
+  using ConnectionBase::get_target;
+
+  void get_status(DictionaryDatum &d) const;
+  void set_status(const DictionaryDatum &d, ConnectorModel &cm);
+
+  void send(Event &e, thread t, double_t t_lastspike,
+            const CommonSynapseProperties &cp);
+
+  class ConnTestDummyNode : public ConnTestDummyNodeBase {
+  public:
+    using ConnTestDummyNodeBase::handles_test_event;
+    port handles_test_event(SpikeEvent &, rport) { return invalid_port_; }
+  };
+
+  void check_connection(Node &s, Node &t, rport receptor_type,
+                        double_t t_lastspike, const CommonPropertiesType &) {
+    ConnTestDummyNode dummy_target;
+    ConnectionBase::check_connection_(dummy_target, s, t, receptor_type);
+    t.register_stdp_connection(t_lastspike - get_delay());
+  }
+
+  void set_weight(double_t w) { weight_ = w; }
+
+  /**
+   * Register the model under its kernel name, for statistics, plasticity
+   * schedules and pruning counts.
+   */
+  static void register_stdp_model(const std::string &name) {
+    stdp_model_ = STDPStatistics::register_model(name);
+  }
+
+private:
+  /**
+   * Keep the weight change of a spike at t_change (ms), from the given
+   * weight, while plastic and undo it otherwise.
+   */
+  void change_(thread t, double_t t_change, double_t weight) {
+    if (!STDPPlasticity::plastic(stdp_model_, t_change)) {
+      weight_ = weight;
+      return;
+    }
+
+    STDPStatistics::record(stdp_model_, t, statistics_epoch_, weight, weight_,
+                           Wmin_, Wmax_);
+    depressed_(t_change);
+  }
+
+  /**
+   * Track since when the weight is at or below the pruning threshold.
+   */
+  void depressed_(double_t t) {
+    if (weight_ > prune_threshold_) {
+      t_depressed_ = -1.0;
+    } else if (t_depressed_ < 0.0) {
+      t_depressed_ = t;
+    }
+  }
+
+  double_t weight_;
+  double_t Aminus_;
+  double_t Aplus_;
+  double_t Wmax_;
+  double_t Wmin_;
+  double_t Kplus_;
+  double_t Kminus_;
+
+  double_t prune_threshold_;
+  double_t prune_time_;
+  double_t t_depressed_;
+  bool active_;
+  // time since which the post-synaptic history is unread, -1 when read
+  double_t t_unread_;
+  long_t statistics_epoch_;
+
+  static STDPStatistics::Model stdp_model_;
+};
+}
+
+template <typename targetidentifierT>
+stdpmodule::STDPStatistics::Model
+    stdpmodule::STDPPairConnection<targetidentifierT>::stdp_model_ = 0;
+
+template <typename targetidentifierT>
+stdpmodule::STDPPairConnection<targetidentifierT>::STDPPairConnection()
+    : ConnectionBase(), weight_(1.0),
+      Aminus_(0.1),
+      Aplus_(0.1),
+      Wmax_(100.0),
+      Wmin_(0.0),
+      Kplus_(0.0),
+      Kminus_(0.0),
+      prune_threshold_(-std::numeric_limits<double_t>::infinity()),
+      prune_time_(0.0), t_depressed_(-1.0), active_(true), t_unread_(-1.0),
+      statistics_epoch_(-1) {}
+
+template <typename targetidentifierT>
+inline void stdpmodule::STDPPairConnection<targetidentifierT>::send(
+    Event &e, thread t, double_t t_lastspike, const CommonSynapseProperties &) {
+
+  double_t t_spike = e.get_stamp().get_ms();
+  Node *target = get_target(t);
+
+  // pruned connections leave the history unread from their last spike
+  if (!active_) {
+    if (t_unread_ < 0.0) {
+      t_unread_ = t_lastspike;
+    }
+    return;
+  }
+
+  double_t dendritic_delay = get_delay();
+  std::deque<histentry>::iterator start;
+  std::deque<histentry>::iterator finish;
+
+  // a revived connection marks the history it skipped as read
+  if (t_unread_ >= 0.0) {
+    target->get_history(t_unread_ - dendritic_delay,
+                        t_lastspike - dendritic_delay, &start, &finish);
+    t_unread_ = -1.0;
+  }
+
+  // go through the post-synaptic spikes since the last pre-synaptic spike
+  // (without the added dendritic delay)
+  target->get_history(t_lastspike - dendritic_delay, t_spike - dendritic_delay,
+                      &start, &finish);
+
+  double_t t_last = t_lastspike;
+  for (; start != finish; ++start) {
+    const double_t t_post = start->t_ + dendritic_delay;
+    double_t delta = t_post - t_last;
+    assert(delta >= 0);
+    t_last = t_post;
+
+    Kplus_ *= std::exp(-delta * 0.05952380952380952);
+    Kminus_ *= std::exp(-delta * 0.029673590504451036);
+    const double_t weight = weight_;
+    weight_ += Aplus_ * Kplus_;
+    weight_ = std::min(std::max(weight_, Wmin_), Wmax_);
+    change_(t, t_post, weight);
+    Kminus_ += 1.0;
+  }
+
+  double_t delta = t_spike - t_last;
+  assert(delta >= 0);
+  Kplus_ *= std::exp(-delta * 0.05952380952380952);
+  Kminus_ *= std::exp(-delta * 0.029673590504451036);
+  const double_t weight = weight_;
+  weight_ -= Aminus_ * Kminus_;
+  weight_ = std::min(std::max(weight_, Wmin_), Wmax_);
+  change_(t, t_spike, weight);
+  Kplus_ += 1.0;
+
+  if (t_depressed_ >= 0.0 and t_spike - t_depressed_ >= prune_time_) {
+    active_ = false;
+    t_depressed_ = -1.0;
+    STDPStatistics::prune(stdp_model_, t, statistics_epoch_, weight_,
+                          Wmin_, Wmax_);
+    return;
+  }
+
+  e.set_receiver(*target);
+  e.set_weight(weight_);
+  e.set_delay(get_delay_steps());
+  e.set_rport(get_rport());
+  e();
+}
+
+template <typename targetidentifierT>
+void stdpmodule::STDPPairConnection<targetidentifierT>::get_status(
+    DictionaryDatum &d) const {
+  ConnectionBase::get_status(d);
+  def<double_t>(d, names::weight, weight_);
+  def<double_t>(d, stdp_pair_names::Aminus, Aminus_);
+  def<double_t>(d, stdp_pair_names::Aplus, Aplus_);
+  def<double_t>(d, stdp_pair_names::Kminus, Kminus_);
+  def<double_t>(d, stdp_pair_names::Kplus, Kplus_);
+  def<double_t>(d, stdp_pair_names::Wmax, Wmax_);
+  def<double_t>(d, stdp_pair_names::Wmin, Wmin_);
+  def<double_t>(d, stdpnames::prune_threshold, prune_threshold_);
+  def<double_t>(d, stdpnames::prune_time, prune_time_);
+  def<bool>(d, stdpnames::active, active_);
+  def<double_t>(d, stdpnames::t_depressed, t_depressed_);
+
+  def<long_t>(d, names::size_of, sizeof(*this));
+}
+
+template <typename targetidentifierT>
+void stdpmodule::STDPPairConnection<targetidentifierT>::set_status(
+    const DictionaryDatum &d, ConnectorModel &cm) {
+  ConnectionBase::set_status(d, cm);
+  updateValue<double_t>(d, names::weight, weight_);
+  updateValue<double_t>(d, stdp_pair_names::Aminus, Aminus_);
+  updateValue<double_t>(d, stdp_pair_names::Aplus, Aplus_);
+  updateValue<double_t>(d, stdp_pair_names::Kminus, Kminus_);
+  updateValue<double_t>(d, stdp_pair_names::Kplus, Kplus_);
+  updateValue<double_t>(d, stdp_pair_names::Wmax, Wmax_);
+  updateValue<double_t>(d, stdp_pair_names::Wmin, Wmin_);
+  updateValue<double_t>(d, stdpnames::prune_threshold, prune_threshold_);
+  updateValue<double_t>(d, stdpnames::prune_time, prune_time_);
+  updateValue<bool>(d, stdpnames::active, active_);
+  updateValue<double_t>(d, stdpnames::t_depressed, t_depressed_);
+
+  if (!(Wmax_ >= Wmin_)) {
+    throw BadProperty("Parameter Wmax must be larger than Wmin.");
+  }
+
+  if (!(prune_time_ >= 0)) {
+    throw BadProperty("Parameter prune_time must be positive.");
+  }
+}
+
+#endif /* STDP_PAIR_CONNECTION_H */
@@ -0,0 +1,22 @@
+//
+//  stdp_pair_names.h
+//  NEST
+//
+//  Generated by codegen/stdp_codegen.py from codegen/rules/stdp_pair.json, do not edit.
+//
+
+#ifndef STDP_PAIR_NAMES_H
+#define STDP_PAIR_NAMES_H
+
+#include "name.h"
+
+namespace stdp_pair_names {
+const Name Aminus("Aminus");
+const Name Aplus("Aplus");
+const Name Kminus("Kminus");
+const Name Kplus("Kplus");
+const Name Wmax("Wmax");
+const Name Wmin("Wmin");
+}
+
+#endif /* STDP_PAIR_NAMES_H */
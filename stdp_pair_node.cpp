@@ -0,0 +1,348 @@
+//
+//  stdp_pair_node.cpp
+//  NEST
+//
+//  Generated by codegen/stdp_codegen.py from codegen/rules/stdp_pair.json, do not edit.
+//
+
+#include "stdp_pair_node.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "stdp_pair_names.h"
+#include "stdpnames.h"
+#include "stdp_plasticity.h"
+#include "network.h"
+#include "dictutils.h"
+#include "universal_data_logger_impl.h"
+
+using namespace nest;
+
+/* ----------------------------------------------------------- devices */
+
+nest::RecordablesMap<stdpmodule::STDPPairNeuron>
+    stdpmodule::STDPPairNeuron::recordablesMap_;
+stdpmodule::STDPStatistics::Model stdpmodule::STDPPairNeuron::stdp_model_ = 0;
+
+namespace nest {
+template <> void RecordablesMap<stdpmodule::STDPPairNeuron>::create() {
+  insert_(names::weight, &stdpmodule::STDPPairNeuron::get_weight_);
+  insert_(stdp_pair_names::Kplus, &stdpmodule::STDPPairNeuron::get_Kplus_);
+  insert_(stdp_pair_names::Kminus, &stdpmodule::STDPPairNeuron::get_Kminus_);
+}
+}
+
+/* ----------------------------------------------------------- parameters */
+
+stdpmodule::STDPPairNeuron::Parameters_::Parameters_()
+    : Aminus_(0.1), Aplus_(0.1), Wmax_(100.0), Wmin_(0.0), prune_threshold_(-std::numeric_limits<double_t>::infinity()), prune_time_(0.0) {}
+
+void stdpmodule::STDPPairNeuron::Parameters_::get(DictionaryDatum &d) const {
+  def<double_t>(d, stdp_pair_names::Aminus, Aminus_);
+  def<double_t>(d, stdp_pair_names::Aplus, Aplus_);
+  def<double_t>(d, stdp_pair_names::Wmax, Wmax_);
+  def<double_t>(d, stdp_pair_names::Wmin, Wmin_);
+  def<double_t>(d, stdpnames::prune_threshold, prune_threshold_);
+  def<double_t>(d, stdpnames::prune_time, prune_time_);
+}
+
+void stdpmodule::STDPPairNeuron::Parameters_::set(const DictionaryDatum &d) {
+  updateValue<double_t>(d, stdp_pair_names::Aminus, Aminus_);
+  updateValue<double_t>(d, stdp_pair_names::Aplus, Aplus_);
+  updateValue<double_t>(d, stdp_pair_names::Wmax, Wmax_);
+  updateValue<double_t>(d, stdp_pair_names::Wmin, Wmin_);
+  updateValue<double_t>(d, stdpnames::prune_threshold, prune_threshold_);
+  updateValue<double_t>(d, stdpnames::prune_time, prune_time_);
+
+  if (!(Wmax_ >= Wmin_)) {
+    throw BadProperty("Parameter Wmax must be larger than Wmin.");
+  }
+
+  if (!(prune_time_ >= 0)) {
+    throw BadProperty("Parameter prune_time must be positive.");
+  }
+}
+
+/* ----------------------------------------------------------- states */
+
+stdpmodule::STDPPairNeuron::State_::State_()
+    : weight_(1.0), Kplus_(0.0), Kminus_(0.0), t_traces_(-1), t_depressed_(-1), active_(true) {}
+
+void stdpmodule::STDPPairNeuron::State_::get(DictionaryDatum &d) const {
+  def<double_t>(d, names::weight, weight_);
+  def<double_t>(d, stdp_pair_names::Kplus, Kplus_);
+  def<double_t>(d, stdp_pair_names::Kminus, Kminus_);
+  def<bool>(d, stdpnames::active, active_);
+}
+
+void stdpmodule::STDPPairNeuron::State_::set(const DictionaryDatum &d) {
+  updateValue<double_t>(d, names::weight, weight_);
+  updateValue<double_t>(d, stdp_pair_names::Kplus, Kplus_);
+  updateValue<double_t>(d, stdp_pair_names::Kminus, Kminus_);
+  updateValue<bool>(d, stdpnames::active, active_);
+
+  if (!(Kplus_ >= 0)) {
+    throw BadProperty("State Kplus must be positive.");
+  }
+
+  if (!(Kminus_ >= 0)) {
+    throw BadProperty("State Kminus must be positive.");
+  }
+}
+
+void stdpmodule::STDPPairNeuron::State_::decay(long_t step, const Parameters_ &/* p */) {
+  if (step <= t_traces_) {
+    return;
+  }
+
+  const double_t elapsed = Time(Time::step(step - t_traces_)).get_ms();
+  Kplus_ *= std::exp(-elapsed * 0.05952380952380952);
+  Kminus_ *= std::exp(-elapsed * 0.029673590504451036);
+  t_traces_ = step;
+}
+
+double *stdpmodule::STDPPairNeuron::plastic_value(const Name &name) {
+  S_.decay(network()->get_time().get_steps() - 1, P_);
+
+  if (name == names::weight) {
+    return &S_.weight_;
+  }
+  if (name == stdp_pair_names::Kplus) {
+    return &S_.Kplus_;
+  }
+  if (name == stdp_pair_names::Kminus) {
+    return &S_.Kminus_;
+  }
+  return 0;
+}
+
+void stdpmodule::STDPPairNeuron::write_plastic_state(double *values) const {
+  const long_t now = network()->get_time().get_steps();
+  State_ s = S_;
+  s.decay(now - 1, P_);
+
+  values[0] = s.weight_;
+  values[1] = s.Kplus_;
+  values[2] = s.Kminus_;
+  values[3] = s.active_;
+  // steps at or below the pruning threshold, -1 when above
+  values[4] = s.t_depressed_ < 0 ? -1.0 : now - s.t_depressed_;
+}
+
+void stdpmodule::STDPPairNeuron::read_plastic_state(const double *values) {
+  const long_t now = network()->get_time().get_steps();
+
+  S_.weight_ = values[0];
+  S_.Kplus_ = values[1];
+  S_.Kminus_ = values[2];
+  // buffers of revived nodes are drawn again on calibration
+  S_.active_ = values[3] != 0.0;
+  S_.t_depressed_ = values[4] < 0.0 ? -1 : now - static_cast<long_t>(values[4]);
+
+  // traces were written at their time, which becomes the restore time
+  S_.t_traces_ = now - 1;
+}
+
+size_t stdpmodule::STDPPairNeuron::memory_size() const {
+  return sizeof(STDPPairNeuron) + B_.n_pre_spikes_.memory_size() +
+         B_.n_post_spikes_.memory_size() +
+         V_.decays_.memory_size();
+}
+
+/* ----------------------------------------------------------- buffers */
+
+stdpmodule::STDPPairNeuron::Buffers_::Buffers_(STDPPairNeuron &n) : logger_(n) {}
+
+stdpmodule::STDPPairNeuron::Buffers_::Buffers_(const Buffers_ &, STDPPairNeuron &n)
+    : logger_(n) {}
+
+/* ----------------------------------------------------------- constructors */
+
+stdpmodule::STDPPairNeuron::STDPPairNeuron()
+    : Archiving_Node(), P_(), S_(), B_(*this) {
+  recordablesMap_.create();
+  V_.statistics_epoch_ = -1;
+}
+
+stdpmodule::STDPPairNeuron::STDPPairNeuron(const STDPPairNeuron &n)
+    : Archiving_Node(n), P_(n.P_), S_(n.S_), B_(n.B_, *this) {
+  V_.statistics_epoch_ = -1;
+}
+
+/* ----------------------------------------------------------- initialization */
+
+void stdpmodule::STDPPairNeuron::init_buffers_() {
+  B_.n_pre_spikes_.clear(get_thread());
+  B_.n_post_spikes_.clear(get_thread());
+  B_.logger_.reset();
+  Archiving_Node::clear_history();
+}
+
+void stdpmodule::STDPPairNeuron::calibrate() {
+  B_.logger_.init();
+
+  const double_t negative_delta = -Time::get_resolution().get_ms();
+
+  // spikes of a slice are at most min delay apart
+  V_.table_steps_ = Scheduler::get_min_delay();
+  V_.decays_.assign(get_thread(), 2 * (V_.table_steps_ + 1));
+  for (long_t n = 0; n <= V_.table_steps_; ++n) {
+    V_.decays_[2 * n + 0] = std::exp(n * negative_delta * 0.05952380952380952);
+    V_.decays_[2 * n + 1] = std::exp(n * negative_delta * 0.029673590504451036);
+  }
+
+  V_.prune_steps_ = Time(Time::ms(P_.prune_time_)).get_steps();
+
+  // pruned nodes keep no buffers, revived ones get them back
+  if (!S_.active_) {
+    B_.n_pre_spikes_.release();
+    B_.n_post_spikes_.release();
+    return;
+  }
+  if (B_.n_pre_spikes_.size() == 0) {
+    B_.n_pre_spikes_.clear(get_thread());
+    B_.n_post_spikes_.clear(get_thread());
+  }
+
+  depressed_(network()->get_time().get_steps());
+
+  STDPStatistics::enter(stdp_model_, get_thread(), V_.statistics_epoch_,
+                        S_.weight_, P_.Wmin_, P_.Wmax_);
+}
+
+/* ----------------------------------------------------------- updates */
+
+void stdpmodule::STDPPairNeuron::update(Time const &origin, const long_t from, const long_t to) {
+  assert(to >= 0 && (delay)from < Scheduler::get_min_delay());
+  assert(from < to);
+
+  if (!S_.active_) {
+    return;
+  }
+
+  // steps are gated in segments of constant plasticity
+  bool plastic = true;
+  long_t until = origin.get_steps() + from;
+
+  for (long_t lag = from; lag < to; ++lag) {
+
+    const long_t step = origin.get_steps() + lag;
+    if (step == until) {
+      plastic = STDPPlasticity::plastic_steps(stdp_model_, step, origin.get_steps() + to, until);
+    }
+
+    const double_t current_pre_spikes_n = B_.n_pre_spikes_.get_value(lag);
+    const double_t current_post_spikes_n = B_.n_post_spikes_.get_value(lag);
+
+    if (current_pre_spikes_n > 0 or current_post_spikes_n > 0) {
+      decay_to_(step);
+    }
+
+    if (current_pre_spikes_n > 0) {
+      const double_t weight = S_.weight_;
+      S_.weight_ -= P_.Aminus_ * S_.Kminus_;
+      S_.weight_ = std::min(std::max(S_.weight_, P_.Wmin_), P_.Wmax_);
+      change_(step, weight, plastic);
+      S_.Kplus_ += 1.0;
+
+      SpikeEvent se;
+      se.set_multiplicity(current_pre_spikes_n);
+      se.set_weight(S_.weight_);
+      network()->send(*this, se, lag);
+    }
+
+    if (current_post_spikes_n > 0) {
+      const double_t weight = S_.weight_;
+      S_.weight_ += P_.Aplus_ * S_.Kplus_;
+      S_.weight_ = std::min(std::max(S_.weight_, P_.Wmin_), P_.Wmax_);
+      change_(step, weight, plastic);
+      S_.Kminus_ += 1.0;
+    }
+
+    B_.logger_.record_data(step);
+  }
+
+  // pruning happens at slice boundaries only
+  if (S_.t_depressed_ >= 0 and origin.get_steps() + to - S_.t_depressed_ >= V_.prune_steps_) {
+    prune_();
+  }
+}
+
+void stdpmodule::STDPPairNeuron::decay_to_(long_t step) {
+  const long_t n = step - S_.t_traces_;
+
+  if (n <= 0) {
+    return;
+  }
+
+  if (n > V_.table_steps_) {
+    S_.decay(step, P_);
+    return;
+  }
+
+  S_.Kplus_ *= V_.decays_[2 * n + 0];
+  S_.Kminus_ *= V_.decays_[2 * n + 1];
+  S_.t_traces_ = step;
+}
+
+void stdpmodule::STDPPairNeuron::change_(long_t step, double_t weight, bool plastic) {
+  if (!plastic) {
+    S_.weight_ = weight;
+    return;
+  }
+
+  STDPStatistics::record(stdp_model_, get_thread(), V_.statistics_epoch_, weight, S_.weight_,
+                         P_.Wmin_, P_.Wmax_);
+  depressed_(step);
+}
+
+void stdpmodule::STDPPairNeuron::depressed_(long_t step) {
+  if (S_.weight_ > P_.prune_threshold_) {
+    S_.t_depressed_ = -1;
+  } else if (S_.t_depressed_ < 0) {
+    S_.t_depressed_ = step;
+  }
+}
+
+void stdpmodule::STDPPairNeuron::prune_() {
+  S_.active_ = false;
+  S_.t_depressed_ = -1;
+
+  STDPStatistics::prune(stdp_model_, get_thread(), V_.statistics_epoch_, S_.weight_,
+                        P_.Wmin_, P_.Wmax_);
+
+  B_.n_pre_spikes_.release();
+  B_.n_post_spikes_.release();
+  Archiving_Node::clear_history();
+}
+
+void stdpmodule::STDPPairNeuron::handle(SpikeEvent &e) {
+  assert(e.get_delay() > 0);
+
+  if (!S_.active_) {
+    return;
+  }
+
+  switch (e.get_rport()) {
+  case 0: // PRE
+    B_.n_pre_spikes_.add_value(
+        e.get_rel_delivery_steps(network()->get_slice_origin()),
+        e.get_multiplicity());
+    break;
+
+  case 1: // POST
+    B_.n_post_spikes_.add_value(
+        e.get_rel_delivery_steps(network()->get_slice_origin()),
+        e.get_multiplicity());
+    break;
+
+  default:
+    break;
+  }
+}
+
+void stdpmodule::STDPPairNeuron::handle(DataLoggingRequest &e) {
+  B_.logger_.handle(e);
+}
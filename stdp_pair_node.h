@@ -0,0 +1,236 @@
+//
+//  stdp_pair_node.h
+//  NEST
+//
+//  Generated by codegen/stdp_codegen.py from codegen/rules/stdp_pair.json, do not edit.
+//
+
+/* BeginDocumentation
+ Name: stdp_pair_node - Neuron that acts like a stdp_pair_synapse.
+
+ Description:
+ Pair-based additive STDP with all-to-all spike interactions [1], the pair
+ terms of the triplet rule.
+
+ Parameters:
+ Aminus             double: weight of depression
+ Aplus              double: weight of potentiation
+ Wmax               double: maximum allowed weight
+ Wmin               double: minimum allowed weight
+ prune_threshold    double: weight at or below which the synapse is depressed
+ (pruning is disabled by default)
+ prune_time         double: time the synapse must stay depressed before it is
+ pruned (ms)
+
+ States:
+ weight             double: synaptic weight
+ Kplus              double: pre-synaptic trace (tau tau_plus, on pre-synaptic spikes)
+ Kminus             double: post-synaptic trace (tau tau_minus, on post-synaptic spikes)
+ active             bool: false once pruned, the node then ignores its input,
+ stops updating and releases its buffers (set it back to true to revive it)
+
+ Notes:
+ Traces decay on spikes only, from a table of exact decays, recorded traces
+ are updated on spikes. Weight updates follow stdp_plasticity and feed
+ stdp_statistics, pruning is checked at slice boundaries, as for
+ stdp_triplet_node. Constants of the rule are not parameters: tau_minus = 33.7, tau_plus = 16.8.
+
+ Receives: SpikeEvent, DataLoggingRequest
+
+ Sends: SpikeEvent
+
+ References:
+ [1] S. Song, K. D. Miller & L. F. Abbott (2000) Competitive Hebbian
+ learning through spike-timing-dependent synaptic plasticity. Nature
+ Neuroscience 3(9):919-926; doi:10.1038/78829
+
+ SeeAlso: stdp_pair_synapse, stdp_triplet_node
+ */
+
+#ifndef STDP_PAIR_NODE_H
+#define STDP_PAIR_NODE_H
+
+#include <vector>
+
+#include "nest.h"
+#include "event.h"
+#include "archiving_node.h"
+#include "universal_data_logger.h"
+
+#include "plastic_node.h"
+#include "spike_ring_buffer.h"
+#include "stdp_statistics.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+class Network;
+
+class STDPPairNeuron : public Archiving_Node, public PlasticNode {
+
+public:
+  STDPPairNeuron();
+  STDPPairNeuron(const STDPPairNeuron &);
+
+  using Node::handle;
+  using Node::handles_test_event;
+
+  port send_test_event(Node &, rport, synindex, bool);
+  port handles_test_event(SpikeEvent &, rport);
+  port handles_test_event(DataLoggingRequest &, rport);
+
+  void get_status(DictionaryDatum &) const;
+  void set_status(const DictionaryDatum &);
+
+  void handle(SpikeEvent &);
+  void handle(DataLoggingRequest &);
+
+  unsigned int plastic_state_version() const { return 2; }
+  size_t plastic_state_size() const { return 5; }
+  void write_plastic_state(double *) const;
+  void read_plastic_state(const double *);
+  double *plastic_value(const Name &);
+  size_t memory_size() const;
+
+  /**
+   * Register the model under its kernel name, for statistics, plasticity
+   * schedules and pruning counts.
+   */
+  static void register_stdp_model(const std::string &name) {
+    stdp_model_ = STDPStatistics::register_model(name);
+  }
+
+private:
+  void init_state_(const Node &proto) {}
+  void init_buffers_();
+  void calibrate();
+
+  void update(Time const &, const long_t, const long_t);
+
+  /**
+   * Decay the traces up to the given step.
+   */
+  void decay_to_(long_t step);
+
+  /**
+   * Keep the weight change of a spike at the given step, from the given
+   * weight, while plastic and undo it otherwise.
+   */
+  void change_(long_t step, double_t weight, bool plastic);
+
+  /**
+   * Track since when the weight is at or below the pruning threshold.
+   */
+  void depressed_(long_t step);
+  void prune_();
+
+  friend class RecordablesMap<STDPPairNeuron>;
+  friend class UniversalDataLogger<STDPPairNeuron>;
+
+  struct Parameters_ {
+    double_t Aminus_;
+    double_t Aplus_;
+    double_t Wmax_;
+    double_t Wmin_;
+    double_t prune_threshold_;
+    double_t prune_time_;
+
+    Parameters_();
+    void get(DictionaryDatum &) const;
+    void set(const DictionaryDatum &);
+  };
+
+  struct State_ {
+    double_t weight_;
+    double_t Kplus_;
+    double_t Kminus_;
+
+    long_t t_traces_;
+    // step since which the weight is at or below the pruning threshold
+    long_t t_depressed_;
+    bool active_;
+
+    State_();
+    void get(DictionaryDatum &) const;
+    void set(const DictionaryDatum &);
+
+    /**
+     * Decay the traces up to the given step, once they lag behind.
+     */
+    void decay(long_t step, const Parameters_ &);
+  };
+
+  struct Buffers_ {
+    SpikeRingBuffer n_pre_spikes_;
+    SpikeRingBuffer n_post_spikes_;
+    UniversalDataLogger<STDPPairNeuron> logger_;
+
+    Buffers_(STDPPairNeuron &);
+    Buffers_(const Buffers_ &, STDPPairNeuron &);
+  };
+
+  struct Variables_ {
+    // decays of the traces over 0 to table_steps steps
+    long_t table_steps_;
+    ArenaArray decays_;
+
+    long_t prune_steps_;
+    long_t statistics_epoch_;
+  };
+
+  // Access functions for UniversalDataLogger
+  double_t get_weight_() const { return S_.weight_; }
+  double_t get_Kplus_() const { return S_.Kplus_; }
+  double_t get_Kminus_() const { return S_.Kminus_; }
+
+  Parameters_ P_;
+  State_ S_;
+  Variables_ V_;
+  Buffers_ B_;
+
+  static RecordablesMap<STDPPairNeuron> recordablesMap_;
+  static STDPStatistics::Model stdp_model_;
+};
+
+inline port STDPPairNeuron::send_test_event(Node &target, rport receptor_type, synindex, bool) {
+  SpikeEvent e;
+  e.set_sender(*this);
+  return target.handles_test_event(e, receptor_type);
+}
+
+inline port STDPPairNeuron::handles_test_event(SpikeEvent &, rport receptor_type) {
+  // Allow connections to port 0 (pre-synaptic) and port 1 (post-synaptic)
+  if (receptor_type != 0 and receptor_type != 1) {
+    throw UnknownReceptorType(receptor_type, get_name());
+  }
+  return receptor_type;
+}
+
+inline port STDPPairNeuron::handles_test_event(DataLoggingRequest &dlr, rport receptor_type) {
+  if (receptor_type != 0) {
+    throw UnknownReceptorType(receptor_type, get_name());
+  }
+  return B_.logger_.connect_logging_device(dlr, recordablesMap_);
+}
+
+inline void STDPPairNeuron::get_status(DictionaryDatum &d) const {
+  // traces are decayed on spikes only
+  State_ s = S_;
+  s.decay(network()->get_time().get_steps() - 1, P_);
+
+  P_.get(d);
+  s.get(d);
+  Archiving_Node::get_status(d);
+  (*d)[names::recordables] = recordablesMap_.get_list();
+}
+
+inline void STDPPairNeuron::set_status(const DictionaryDatum &d) {
+  // pruned nodes did not decay, revived ones catch up here
+  S_.decay(network()->get_time().get_steps() - 1, P_);
+  P_.set(d);
+  S_.set(d);
+  Archiving_Node::set_status(d);
+}
+}
+
+#endif // STDP_PAIR_NODE_H
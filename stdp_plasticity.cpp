@@ -0,0 +1,78 @@
+//
+//  stdp_plasticity.cpp
+//  NEST
+//
+//
+
+#include "stdp_plasticity.h"
+
+#include "stdpnames.h"
+#include "arraydatum.h"
+#include "dictutils.h"
+
+using namespace nest;
+
+bool stdpmodule::STDPPlasticity::plastic_ = true;
+std::vector<std::vector<nest::double_t> > stdpmodule::STDPPlasticity::schedule_;
+
+bool stdpmodule::STDPPlasticity::plastic_steps(Model m, long_t step,
+                                               long_t limit, long_t &until) {
+  double_t until_ms;
+  const bool plastic = STDPPlasticity::plastic(
+      m, Time(Time::step(step + 1)).get_ms(), until_ms);
+
+  until = limit;
+  if (until_ms <= Time(Time::step(limit)).get_ms()) {
+    until = std::max(step + 1, Time(Time::ms(until_ms)).get_steps() - 1);
+  }
+  return plastic;
+}
+
+void stdpmodule::STDPPlasticity::set_status(const DictionaryDatum &d) {
+  bool plastic = plastic_;
+  std::vector<std::vector<double_t> > schedule = schedule_;
+  schedule.resize(STDPStatistics::n_models());
+
+  updateValue<bool>(d, stdpnames::plastic, plastic);
+
+  for (size_t m = 0; m < schedule.size(); ++m) {
+    const Name name(STDPStatistics::model_name(m));
+    if (!d->known(name)) {
+      continue;
+    }
+
+    const TokenArray edges = getValue<TokenArray>((*d)[name]);
+    if (edges.size() % 2 != 0) {
+      throw BadProperty("Schedule of " + name.toString() +
+                        " must alternate start and stop times.");
+    }
+
+    schedule[m].clear();
+    for (size_t i = 0; i < edges.size(); ++i) {
+      const double_t edge = getValue<double_t>(edges[i]);
+      if (!schedule[m].empty() and !(edge > schedule[m].back())) {
+        throw BadProperty("Schedule of " + name.toString() +
+                          " must be strictly increasing.");
+      }
+      schedule[m].push_back(edge);
+    }
+  }
+
+  plastic_ = plastic;
+  schedule_ = schedule;
+}
+
+void stdpmodule::STDPPlasticity::get_status(DictionaryDatum &d) {
+  def<bool>(d, stdpnames::plastic, plastic_);
+
+  for (size_t m = 0; m < STDPStatistics::n_models(); ++m) {
+    ArrayDatum edges;
+    if (m < schedule_.size()) {
+      edges.reserve(schedule_[m].size());
+      for (size_t i = 0; i < schedule_[m].size(); ++i) {
+        edges.push_back(new DoubleDatum(schedule_[m][i]));
+      }
+    }
+    (*d)[Name(STDPStatistics::model_name(m))] = edges;
+  }
+}
@@ -0,0 +1,114 @@
+//
+//  stdp_plasticity.h
+//  NEST
+//
+//
+
+/* BeginDocumentation
+ Name: stdp_plasticity - Plasticity gating schedule of STDP models.
+
+ Description:
+ Plasticity of every STDP model of this module can be switched off globally
+ or restricted to a schedule of learning windows. Outside of them synapses
+ only forward spikes with their current weight: weights stay unchanged while
+ traces still follow pre- and post-synaptic spikes, as if the amplitudes of
+ the rule were zero.
+
+ STDP nodes do not decay their traces every step while not plastic, traces
+ are caught up exactly on spikes and when plasticity turns back on, so their
+ cost is close to the one of static synapses. stdp_triplet_all_in_one_synapse
+ does not read the post-synaptic history while not plastic, its post-synaptic
+ traces catch up with it when plasticity turns back on. Generated connections
+ still go through the history to update their traces but skip weight updates.
+
+ Parameters (SetSTDPPlasticity):
+ plastic            bool: global toggle, no model is plastic when false
+ <model name>       array: schedule of a registered model (e.g.
+ stdp_triplet_node, stdp_longterm_node, stdp_triplet_all_in_one_synapse or
+ the generated stdp_pair_node and stdp_pair_synapse, see stdp_statistics),
+ alternating start and stop times (ms) of its learning windows; an empty
+ array (default) means always plastic
+
+ Notes:
+ Windows are half-open, [start, stop). Steps of STDP nodes are gated at
+ their time of arrival of spikes (step end). weight_ref, B and C of
+ stdp_longterm_node are held while it is not plastic, its Z traces follow
+ spikes. Recorded traces of nodes are only updated on spikes while not
+ plastic, their status is caught up when read.
+
+ SeeAlso: stdp_triplet_node, stdp_longterm_node,
+ stdp_triplet_all_in_one_synapse, stdp_statistics
+ */
+
+#ifndef STDP_PLASTICITY_H
+#define STDP_PLASTICITY_H
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "nest.h"
+#include "nest_time.h"
+#include "dictdatum.h"
+
+#include "stdp_statistics.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+/**
+ * Registry of the plasticity schedules of all models.
+ */
+class STDPPlasticity {
+public:
+  typedef STDPStatistics::Model Model;
+
+  /**
+   * Whether a model is plastic at time t (ms).
+   */
+  static bool plastic(Model m, double_t t);
+
+  /**
+   * Whether a model is plastic at time t (ms), until the given time.
+   */
+  static bool plastic(Model m, double_t t, double_t &until);
+
+  /**
+   * Whether a model is plastic at the given step of an STDP node, and the
+   * first step before the limit at which this changes (limit otherwise).
+   * Steps are gated at the time of the spikes they read, (step + 1) h.
+   */
+  static bool plastic_steps(Model m, long_t step, long_t limit,
+                            long_t &until);
+
+  static void set_status(const DictionaryDatum &);
+  static void get_status(DictionaryDatum &);
+
+private:
+  static bool plastic_;
+  static std::vector<std::vector<double_t> > schedule_;
+};
+
+inline bool STDPPlasticity::plastic(Model m, double_t t) {
+  double_t until;
+  return plastic(m, t, until);
+}
+
+inline bool STDPPlasticity::plastic(Model m, double_t t, double_t &until) {
+  // schedules are sized for the models registered when they were last set
+  if (!plastic_ or m >= schedule_.size() or schedule_[m].empty()) {
+    until = std::numeric_limits<double_t>::infinity();
+    return plastic_;
+  }
+
+  // inside a window when an odd number of edges is behind t
+  const std::vector<double_t> &edges = schedule_[m];
+  const size_t passed =
+      std::upper_bound(edges.begin(), edges.end(), t) - edges.begin();
+  until = passed < edges.size() ? edges[passed]
+                                : std::numeric_limits<double_t>::infinity();
+  return passed % 2 == 1;
+}
+}
+
+#endif /* STDP_PLASTICITY_H */
@@ -0,0 +1,175 @@
+//
+//  stdp_post_hub.cpp
+//  NEST
+//
+//
+
+#include "stdp_post_hub.h"
+
+#include <map>
+
+#include "stdpnames.h"
+#include "network.h"
+#include "nestmodule.h"
+#include "dictutils.h"
+#include "exceptions.h"
+
+using namespace nest;
+
+namespace {
+
+// accumulators by gid of their hub, kept over resets of the kernel
+std::map<nest::index, stdpmodule::STDPPostHub::Accumulator> accumulators;
+}
+
+/* ----------------------------------------------------------- parameters */
+
+stdpmodule::STDPPostHub::Parameters_::Parameters_()
+    : aggregation_delay_(1.0) {}
+
+void stdpmodule::STDPPostHub::Parameters_::get(DictionaryDatum &d) const {
+  def<double_t>(d, stdpnames::aggregation_delay, aggregation_delay_);
+}
+
+void stdpmodule::STDPPostHub::Parameters_::set(const DictionaryDatum &d) {
+  updateValue<double_t>(d, stdpnames::aggregation_delay, aggregation_delay_);
+
+  if (!(aggregation_delay_ > 0)) {
+    throw BadProperty("Parameter aggregation_delay must be strictly positive.");
+  }
+}
+
+/* ----------------------------------------------------------- states */
+
+stdpmodule::STDPPostHub::State_::State_() : n_events_(0), n_post_spikes_(0) {}
+
+void stdpmodule::STDPPostHub::State_::get(DictionaryDatum &d) const {
+  def<long_t>(d, stdpnames::n_events, n_events_);
+  def<long_t>(d, stdpnames::n_post_spikes, n_post_spikes_);
+}
+
+/* ----------------------------------------------------------- constructors */
+
+stdpmodule::STDPPostHub::STDPPostHub() : Node(), P_(), S_() {
+  V_.delay_steps_ = 0;
+  V_.accumulator_ = 0;
+}
+
+stdpmodule::STDPPostHub::STDPPostHub(const STDPPostHub &n)
+    : Node(n), P_(n.P_), S_(n.S_) {
+  V_.delay_steps_ = 0;
+  V_.accumulator_ = 0;
+}
+
+/* ----------------------------------------------------------- accumulators */
+
+stdpmodule::STDPPostHub::Accumulator *
+stdpmodule::STDPPostHub::accumulator(nest::index gid) {
+  Network &net = nest::NestModule::get_network();
+  if (gid == 0 or gid >= net.size() or !net.is_local_gid(gid) or
+      net.get_node(gid)->get_name() != "stdp_post_hub") {
+    throw BadProperty("Parameter hub must be the gid of a stdp_post_hub on "
+                      "the same rank.");
+  }
+
+  Accumulator *accumulator;
+#pragma omp critical(stdp_post_hub)
+  accumulator = &accumulators[gid];
+  return accumulator;
+}
+
+/* ----------------------------------------------------------- initialization */
+
+void stdpmodule::STDPPostHub::init_state_(const Node &proto) {
+  const STDPPostHub &pr = downcast<STDPPostHub>(proto);
+  S_ = pr.S_;
+}
+
+void stdpmodule::STDPPostHub::init_buffers_() {
+// a hub of a previous kernel may have left inputs under the same gid
+#pragma omp critical(stdp_post_hub)
+  accumulators[get_gid()] = Accumulator();
+}
+
+void stdpmodule::STDPPostHub::calibrate() {
+  V_.delay_steps_ = Time(Time::ms(P_.aggregation_delay_)).get_steps();
+  if (V_.delay_steps_ < Scheduler::get_min_delay()) {
+    throw BadProperty("Parameter aggregation_delay must be at least the min "
+                      "delay.");
+  }
+
+  // spikes of the current slice and those still to be sent
+  const long_t size = V_.delay_steps_ + Scheduler::get_min_delay();
+  const size_t n_threads = network()->get_num_threads();
+
+  // post-synaptic spikes still to be read, those being read by the nodes of
+  // the current slice and those delivered ahead of it
+  const size_t post_size = V_.delay_steps_ + Scheduler::get_min_delay() +
+                           Scheduler::get_max_delay();
+
+#pragma omp critical(stdp_post_hub)
+  {
+    V_.accumulator_ = &accumulators[get_gid()];
+    if (V_.accumulator_->size_ != size or
+        V_.accumulator_->inputs_.size() != n_threads) {
+      V_.accumulator_->inputs_.assign(n_threads,
+                                      std::vector<double_t>(size, 0.0));
+      V_.accumulator_->size_ = size;
+    }
+    if (V_.accumulator_->post_spikes_.size() != post_size) {
+      V_.accumulator_->post_spikes_.assign(post_size, 0.0);
+    }
+    V_.accumulator_->delay_steps_ = V_.delay_steps_;
+  }
+}
+
+/* ----------------------------------------------------------- updates */
+
+void stdpmodule::STDPPostHub::update(Time const &origin, const long_t from,
+                                     const long_t to) {
+  assert(to >= 0 && (delay)from < Scheduler::get_min_delay());
+  assert(from < to);
+
+  std::vector<std::vector<double_t> > &inputs = V_.accumulator_->inputs_;
+  std::vector<double_t> &post_spikes = V_.accumulator_->post_spikes_;
+
+  for (long_t lag = from; lag < to; ++lag) {
+
+    // post-synaptic spikes read by the nodes of the previous slice
+    const long_t read = origin.get_steps() + lag - V_.delay_steps_ -
+                        Scheduler::get_min_delay();
+    if (read >= 0) {
+      post_spikes[read % post_spikes.size()] = 0.0;
+    }
+
+    // rows were written at least one slice ago, by all threads
+    const long_t spiked = origin.get_steps() + lag - V_.delay_steps_;
+    if (spiked < 0) {
+      continue;
+    }
+
+    const size_t slot = spiked % V_.accumulator_->size_;
+    double_t sum = 0.0;
+    for (size_t t = 0; t < inputs.size(); ++t) {
+      sum += inputs[t][slot];
+      inputs[t][slot] = 0.0;
+    }
+
+    if (sum != 0.0) {
+      SpikeEvent se;
+      se.set_weight(sum);
+      network()->send(*this, se, lag);
+      ++S_.n_events_;
+    }
+  }
+}
+
+void stdpmodule::STDPPostHub::handle(SpikeEvent &e) {
+  const long_t step = network()->get_slice_origin().get_steps() +
+                      e.get_rel_delivery_steps(network()->get_slice_origin());
+
+  // nodes read the step once the deliveries of its slice are over
+  std::vector<double_t> &post_spikes = V_.accumulator_->post_spikes_;
+  post_spikes[step % post_spikes.size()] += e.get_multiplicity();
+  ++S_.n_post_spikes_;
+}
@@ -0,0 +1,172 @@
+//
+//  stdp_post_hub.h
+//  NEST
+//
+//
+
+/* BeginDocumentation
+ Name: stdp_post_hub - Node summing the output of the STDP nodes of a
+ post-synaptic neuron and sharing its spikes with them.
+
+ Description:
+ STDP nodes whose hub parameter is the gid of a stdp_post_hub do not send
+ their weighted spikes to the post-synaptic neuron themselves: they add them
+ to an accumulator of the hub, with one row per thread written by the nodes of
+ that thread only. Every step the hub sums the rows and sends the total as a
+ single SpikeEvent (weight = sum of weight * multiplicity, multiplicity 1)
+ through its one connection to the post-synaptic neuron, which replaces the
+ connections of all its STDP nodes.
+
+ The hub reads the spikes of a step aggregation_delay after it, once the nodes
+ of all threads have written them, so the delay of its connection to the
+ post-synaptic neuron is the dendritic delay minus aggregation_delay. The
+ aggregation_delay must be at least the min delay of the network.
+
+ The post-synaptic neuron may also be connected to the hub instead of to
+ each of its STDP nodes on receptor 1: the hub counts its spikes once, in a
+ buffer by step that the STDP nodes read aggregation_delay later, so the
+ delay of this connection is the feedback delay minus aggregation_delay. A
+ node must not receive post-synaptic spikes both ways.
+
+ The post-synaptic neuron must sum the weights of its inputs (e.g. iaf_*
+ neurons, not parrot_neuron), spike offsets of precise_times nodes and of
+ post-synaptic spikes are lost and the hub must be on the same rank as its
+ STDP nodes.
+
+ Parameters:
+ aggregation_delay  double: time between the spikes of the STDP nodes and the
+ sending of their sum (ms)
+
+ States:
+ n_events           int: summed inputs sent by the hub
+ n_post_spikes      int: post-synaptic spikes received by the hub
+
+ Receives: SpikeEvent
+
+ Sends: SpikeEvent
+
+ SeeAlso: stdp_triplet_node, stdp_longterm_node
+ */
+
+#ifndef STDP_POST_HUB_H
+#define STDP_POST_HUB_H
+
+#include <vector>
+
+#include "nest.h"
+#include "event.h"
+#include "node.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+class STDPPostHub : public Node {
+
+public:
+  STDPPostHub();
+  STDPPostHub(const STDPPostHub &);
+
+  /**
+   * Summed output of the STDP nodes of a hub by spike step and post-synaptic
+   * spikes by delivery step, both modulo the size of their buffers.
+   */
+  struct Accumulator {
+    std::vector<std::vector<double_t> > inputs_;
+    long_t size_;
+    std::vector<double_t> post_spikes_;
+    long_t delay_steps_;
+
+    Accumulator() : inputs_(), size_(0), post_spikes_(), delay_steps_(0) {}
+
+    void add(thread t, long_t step, double_t w) {
+      inputs_[t][step % size_] += w;
+    }
+
+    /**
+     * Post-synaptic spikes STDP nodes handle at the given step.
+     */
+    double_t post_spikes(long_t step) const {
+      const long_t delivered = step - delay_steps_;
+      return delivered < 0 ? 0.0
+                           : post_spikes_[delivered % post_spikes_.size()];
+    }
+  };
+
+  /**
+   * Accumulator of the hub of the given gid, called by STDP nodes on
+   * calibration, throws if the gid is not a local stdp_post_hub.
+   */
+  static Accumulator *accumulator(nest::index gid);
+
+  using Node::handle;
+  using Node::handles_test_event;
+
+  port send_test_event(Node &, rport, synindex, bool);
+  port handles_test_event(SpikeEvent &, rport);
+
+  void handle(SpikeEvent &);
+
+  void get_status(DictionaryDatum &) const;
+  void set_status(const DictionaryDatum &);
+
+private:
+  void init_state_(const Node &proto);
+  void init_buffers_();
+  void calibrate();
+
+  void update(Time const &, const long_t, const long_t);
+
+  struct Parameters_ {
+    double_t aggregation_delay_;
+
+    Parameters_();
+    void get(DictionaryDatum &) const;
+    void set(const DictionaryDatum &);
+  };
+
+  struct State_ {
+    long_t n_events_;
+    long_t n_post_spikes_;
+
+    State_();
+    void get(DictionaryDatum &) const;
+  };
+
+  struct Variables_ {
+    long_t delay_steps_;
+    Accumulator *accumulator_;
+  };
+
+  Parameters_ P_;
+  State_ S_;
+  Variables_ V_;
+};
+
+inline port STDPPostHub::send_test_event(Node &target, rport receptor_type,
+                                         synindex, bool) {
+  SpikeEvent e;
+  e.set_sender(*this);
+  return target.handles_test_event(e, receptor_type);
+}
+
+inline port STDPPostHub::handles_test_event(SpikeEvent &,
+                                            rport receptor_type) {
+  if (receptor_type != 0) {
+    throw UnknownReceptorType(receptor_type, get_name());
+  }
+  return 0;
+}
+
+inline void STDPPostHub::get_status(DictionaryDatum &d) const {
+  P_.get(d);
+  S_.get(d);
+}
+
+inline void STDPPostHub::set_status(const DictionaryDatum &d) {
+  Parameters_ ptmp = P_;
+  ptmp.set(d);
+  P_ = ptmp;
+}
+}
+
+#endif /* STDP_POST_HUB_H */
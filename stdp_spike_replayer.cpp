@@ -0,0 +1,200 @@
+//
+//  stdp_spike_replayer.cpp
+//  NEST
+//
+//
+
+#include "stdp_spike_replayer.h"
+
+#include "stdpnames.h"
+#include "network.h"
+#include "dictutils.h"
+#include "exceptions.h"
+#include "compose.hpp"
+
+using namespace nest;
+
+/* ----------------------------------------------------------- parameters */
+
+stdpmodule::STDPSpikeReplayer::Parameters_::Parameters_()
+    : filename_(), weight_(1.0), receptor_type_(0) {}
+
+void stdpmodule::STDPSpikeReplayer::Parameters_::get(
+    DictionaryDatum &d) const {
+  def<std::string>(d, stdpnames::filename, filename_);
+  def<double_t>(d, names::weight, weight_);
+  def<long_t>(d, names::receptor_type, receptor_type_);
+}
+
+void stdpmodule::STDPSpikeReplayer::Parameters_::set(
+    const DictionaryDatum &d) {
+  updateValue<std::string>(d, stdpnames::filename, filename_);
+  updateValue<double_t>(d, names::weight, weight_);
+  updateValue<long_t>(d, names::receptor_type, receptor_type_);
+
+  if (receptor_type_ < 0) {
+    throw BadProperty("Receptor type must be positive.");
+  }
+}
+
+/* ----------------------------------------------------------- states */
+
+stdpmodule::STDPSpikeReplayer::State_::State_()
+    : position_(0), n_events_(0) {}
+
+void stdpmodule::STDPSpikeReplayer::State_::get(DictionaryDatum &d) const {
+  def<long_t>(d, stdpnames::n_events, n_events_);
+  def<long_t>(d, stdpnames::position, position_);
+}
+
+/* ----------------------------------------------------------- buffers */
+
+stdpmodule::STDPSpikeReplayer::Buffers_::Buffers_() : file_(0) {}
+
+stdpmodule::STDPSpikeReplayer::Buffers_::Buffers_(const Buffers_ &)
+    : file_(0) {}
+
+/* ----------------------------------------------------------- constructors */
+
+stdpmodule::STDPSpikeReplayer::STDPSpikeReplayer()
+    : Node(), P_(), S_(), B_() {}
+
+stdpmodule::STDPSpikeReplayer::STDPSpikeReplayer(const STDPSpikeReplayer &n)
+    : Node(n), P_(n.P_), S_(n.S_), B_(n.B_) {}
+
+stdpmodule::STDPSpikeReplayer::~STDPSpikeReplayer() { delete B_.file_; }
+
+/* ----------------------------------------------------------- initialization */
+
+void stdpmodule::STDPSpikeReplayer::init_state_(const Node &proto) {
+  const STDPSpikeReplayer &pr = downcast<STDPSpikeReplayer>(proto);
+  S_ = pr.S_;
+}
+
+void stdpmodule::STDPSpikeReplayer::init_buffers_() {
+  delete B_.file_;
+  B_.file_ = 0;
+}
+
+void stdpmodule::STDPSpikeReplayer::calibrate() {
+  V_.n_records_ = 0;
+  V_.records_ = 0;
+
+  if (P_.filename_.empty()) {
+    return;
+  }
+
+  if (B_.file_ == 0) {
+    MappedFile *file = new MappedFile(P_.filename_);
+    try {
+      if (file->size() % sizeof(Record) != 0) {
+        throw BadProperty(P_.filename_ + " is not a spike file.");
+      }
+      // instances are calibrated in parallel, one scan checks the targets of
+      // all threads
+      if (get_thread() == 0) {
+        check_records_(reinterpret_cast<const Record *>(file->data()),
+                       file->size() / sizeof(Record));
+      }
+    } catch (...) {
+      delete file;
+      throw;
+    }
+
+    // records are read again from disk as they are replayed
+    file->release(0, file->size());
+    file->advise_sequential();
+    B_.file_ = file;
+  }
+
+  V_.n_records_ = B_.file_->size() / sizeof(Record);
+  V_.records_ = reinterpret_cast<const Record *>(B_.file_->data());
+}
+
+void stdpmodule::STDPSpikeReplayer::check_records_(const Record *records,
+                                                   size_t n_records) {
+  SpikeEvent se;
+  se.set_sender(*this);
+
+  for (size_t i = 0; i < n_records; ++i) {
+    const Record &record = records[i];
+    if (i > 0 and record.time_ < records[i - 1].time_) {
+      throw BadProperty(P_.filename_ + " is not sorted by time.");
+    }
+
+    if (record.gid_ == 0 or record.gid_ >= network()->size()) {
+      throw UnknownNode(record.gid_);
+    }
+
+    // devices and subnets have no proxies, remote neurons are proxies, local
+    // neurons are returned whatever their thread
+    Node *target = network()->get_node(record.gid_, get_thread());
+    if (not target->is_proxy() and not target->has_proxies()) {
+      throw BadProperty("Node " + String::compose("%1", record.gid_) +
+                        " of " + P_.filename_ + " is not a neuron.");
+    }
+    if (not target->is_proxy()) {
+      target->handles_test_event(se, P_.receptor_type_);
+    }
+  }
+}
+
+/* ----------------------------------------------------------- updates */
+
+void stdpmodule::STDPSpikeReplayer::update(Time const &origin,
+                                           const long_t from,
+                                           const long_t to) {
+  assert(to >= 0 && (delay)from < Scheduler::get_min_delay());
+  assert(from < to);
+
+  if (V_.records_ == 0) {
+    return;
+  }
+
+  // a spike of time t is read by its target at ring buffer position
+  // t / h - 1, as for a spike_generator emitting at t - d with delay d.
+  // Positions of this slice may already be read by targets updated before
+  // this device, spikes are therefore replayed one slice ahead. A slice split
+  // over two Simulate calls has its records replayed by the first one.
+  const long_t min_delay = Scheduler::get_min_delay();
+  const size_t start = S_.position_;
+
+  while (S_.position_ < V_.n_records_) {
+    const Record &record = V_.records_[S_.position_];
+    const long_t lag =
+        Time(Time::ms(record.time_)).get_steps() - 1 - origin.get_steps();
+
+    if (lag >= 2 * min_delay) {
+      break;
+    }
+    ++S_.position_;
+
+    if (lag < min_delay) {
+      throw KernelException("Spike of node " +
+                            String::compose("%1", record.gid_) + " at " +
+                            String::compose("%1", record.time_) + " ms of " +
+                            P_.filename_ +
+                            " is due within the min delay, too early to be "
+                            "replayed.");
+    }
+
+    // every thread reads all records, each delivers to its own targets
+    Node *target = network()->get_node(record.gid_, get_thread());
+    if (target->is_proxy() or target->get_thread() != get_thread()) {
+      continue;
+    }
+
+    SpikeEvent se;
+    se.set_sender(*this);
+    se.set_receiver(*target);
+    se.set_weight(P_.weight_);
+    se.set_rport(P_.receptor_type_);
+    se.set_stamp(origin);
+    se.set_delay(lag + 1);
+    se();
+
+    ++S_.n_events_;
+  }
+
+  B_.file_->release(start * sizeof(Record), S_.position_ * sizeof(Record));
+}
@@ -0,0 +1,156 @@
+//
+//  stdp_spike_replayer.h
+//  NEST
+//
+//
+
+/* BeginDocumentation
+ Name: stdp_spike_replayer - Device injecting precomputed spikes from a file.
+
+ Description:
+ stdp_spike_replayer streams spike records from a memory-mapped binary file
+ directly into their target nodes, without spike_generator nor connections.
+ Records are read slice by slice and pages already replayed are dropped, so
+ memory stays bounded whatever the file size.
+
+ The file is a sequence of records sorted by time, each made of
+   double  time  spike arrival time at the target (ms)
+   uint64  gid   target node
+ as written by numpy with dtype [('time', '<f8'), ('gid', '<u8')].
+
+ As with a spike_generator connected with a delay, a spike of time t arrives
+ at its target at time t. Spikes are replayed one min delay ahead of their
+ arrival, a record due within the first min delay after the device reads the
+ file (e.g. of time not above the min delay) cannot be replayed in time and
+ raises an error. nest.Spikes sends such spikes through spike_generator
+ instead. Targets must be neurons or STDP nodes, they are checked once per
+ file, by the instance of thread 0 when it opens the file.
+
+ The device is replicated on each thread, every instance delivering the
+ spikes of its thread only. Each instance reads all records, the file being
+ shared in the page cache and a record of another thread costing a node
+ lookup: sharding the records per thread would take an index of the size of
+ the file, which streaming avoids. All instances thus read the file at the
+ same position.
+
+ Parameters:
+ filename           string: path of the spike file
+ weight             double: weight of the delivered spikes
+ receptor_type      int: receptor of the delivered spikes
+
+ States:
+ n_events           int: spikes delivered by this instance
+ position           int: records of the file read so far (read only)
+
+ Sends: SpikeEvent
+
+ SeeAlso: spike_generator, stdp_triplet_node
+ */
+
+#ifndef STDP_SPIKE_REPLAYER_H
+#define STDP_SPIKE_REPLAYER_H
+
+#include <string>
+
+#include "nest.h"
+#include "event.h"
+#include "node.h"
+
+#include "mapped_file.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+class STDPSpikeReplayer : public Node {
+
+public:
+  STDPSpikeReplayer();
+  STDPSpikeReplayer(const STDPSpikeReplayer &);
+  ~STDPSpikeReplayer();
+
+  bool has_proxies() const { return false; }
+
+  using Node::handle;
+  using Node::handles_test_event;
+
+  void get_status(DictionaryDatum &) const;
+  void set_status(const DictionaryDatum &);
+
+  /**
+   * Layout of a record of the spike file.
+   */
+  struct Record {
+    double time_;
+    unsigned long gid_;
+  };
+
+private:
+  void init_state_(const Node &proto);
+  void init_buffers_();
+  void calibrate();
+
+  void update(Time const &, const long_t, const long_t);
+
+  /**
+   * Check that records are sorted by time and target neurons accepting
+   * spikes of the receptor type, on all threads of this rank.
+   * @throws UnknownNode, BadProperty
+   */
+  void check_records_(const Record *records, size_t n_records);
+
+  struct Parameters_ {
+    std::string filename_;
+    double_t weight_;
+    long_t receptor_type_;
+
+    Parameters_();
+    void get(DictionaryDatum &) const;
+    void set(const DictionaryDatum &);
+  };
+
+  struct State_ {
+    size_t position_;
+    long_t n_events_;
+
+    State_();
+    void get(DictionaryDatum &) const;
+  };
+
+  struct Buffers_ {
+    MappedFile *file_;
+
+    Buffers_();
+    Buffers_(const Buffers_ &);
+  };
+
+  struct Variables_ {
+    size_t n_records_;
+    const Record *records_;
+  };
+
+  Parameters_ P_;
+  State_ S_;
+  Variables_ V_;
+  Buffers_ B_;
+};
+
+inline void STDPSpikeReplayer::get_status(DictionaryDatum &d) const {
+  P_.get(d);
+  S_.get(d);
+}
+
+inline void STDPSpikeReplayer::set_status(const DictionaryDatum &d) {
+  Parameters_ ptmp = P_;
+  ptmp.set(d);
+
+  // a new file is replayed from its beginning
+  if (ptmp.filename_ != P_.filename_) {
+    S_.position_ = 0;
+    delete B_.file_;
+    B_.file_ = 0;
+  }
+  P_ = ptmp;
+}
+}
+
+#endif /* STDP_SPIKE_REPLAYER_H */
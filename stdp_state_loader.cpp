@@ -0,0 +1,188 @@
+//
+//  stdp_state_loader.cpp
+//  NEST
+//
+//
+
+#include "stdp_state_loader.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "stdpnames.h"
+#include "plastic_node.h"
+#include "npy_array.h"
+#include "network.h"
+#include "nestmodule.h"
+#include "nestdatums.h"
+#include "dictutils.h"
+#include "exceptions.h"
+#include "compose.hpp"
+
+using namespace nest;
+
+namespace {
+
+/**
+ * Row-major values given as a vector.
+ */
+class VectorValues {
+public:
+  VectorValues(const std::vector<double_t> &values, size_t columns)
+      : values_(values), columns_(columns) {}
+
+  size_t rows() const { return values_.size() / columns_; }
+  size_t columns() const { return columns_; }
+  double_t get(size_t row, size_t column) const {
+    return values_[row * columns_ + column];
+  }
+
+private:
+  const std::vector<double_t> &values_;
+  size_t columns_;
+};
+
+inline thread current_thread() {
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+}
+
+void stdpmodule::STDPStateLoader::set_states(
+    const TokenArray &targets, const std::vector<Name> &keys,
+    const std::vector<double_t> &values) {
+  if (keys.empty() or values.size() % keys.size() != 0) {
+    throw BadProperty("Values must contain one column per key.");
+  }
+  set_states_(targets, keys, VectorValues(values, keys.size()));
+}
+
+void stdpmodule::STDPStateLoader::set_states(const TokenArray &targets,
+                                             const std::vector<Name> &keys,
+                                             const std::string &filename) {
+  const NpyArray values(filename);
+  set_states_(targets, keys, values);
+}
+
+template <typename ValuesT>
+void stdpmodule::STDPStateLoader::set_states_(const TokenArray &targets,
+                                              const std::vector<Name> &keys,
+                                              const ValuesT &values) {
+  if (values.rows() != targets.size() or values.columns() != keys.size()) {
+    throw BadProperty("Values must have one row per target and one column "
+                      "per key.");
+  }
+
+  if (targets.size() == 0) {
+    return;
+  }
+
+  if (dynamic_cast<ConnectionDatum *>(targets[0].datum()) != 0) {
+    set_connection_states_(targets, keys, values);
+  } else {
+    set_node_states_(targets, keys, values);
+  }
+}
+
+template <typename ValuesT>
+void stdpmodule::STDPStateLoader::set_node_states_(
+    const TokenArray &targets, const std::vector<Name> &keys,
+    const ValuesT &values) {
+  Network &net = nest::NestModule::get_network();
+
+  std::vector<long_t> gids(targets.size());
+  for (size_t i = 0; i < targets.size(); ++i) {
+    gids[i] = getValue<long_t>(targets[i]);
+    if (gids[i] < 1 or gids[i] >= static_cast<long_t>(net.size())) {
+      throw UnknownNode(gids[i]);
+    }
+  }
+
+  // no exception may leave the parallel region, remember the first failure
+  long_t invalid = -1;
+
+#pragma omp parallel
+  {
+    const thread t = current_thread();
+
+    for (size_t i = 0; i < gids.size(); ++i) {
+      Node *node = net.get_node(gids[i]);
+      if (node->is_proxy() or node->get_thread() != t) {
+        continue;
+      }
+
+      PlasticNode *plastic = dynamic_cast<PlasticNode *>(node);
+      for (size_t k = 0; k < keys.size(); ++k) {
+        double *value = plastic == 0 ? 0 : plastic->plastic_value(keys[k]);
+        if (value == 0) {
+#pragma omp critical(stdp_state_loader)
+          {
+            if (invalid < 0) {
+              invalid = i;
+            }
+          }
+          break;
+        }
+        *value = values.get(i, k);
+      }
+    }
+  }
+
+  if (invalid >= 0) {
+    throw BadProperty("Node " + String::compose("%1", gids[invalid]) +
+                      " is not an STDP node with the given states.");
+  }
+}
+
+template <typename ValuesT>
+void stdpmodule::STDPStateLoader::set_connection_states_(
+    const TokenArray &targets, const std::vector<Name> &keys,
+    const ValuesT &values) {
+  Network &net = nest::NestModule::get_network();
+
+  std::vector<ConnectionID> connections(targets.size());
+  for (size_t i = 0; i < targets.size(); ++i) {
+    connections[i] = getValue<ConnectionDatum>(targets[i]);
+  }
+
+  long_t invalid = -1;
+
+#pragma omp parallel
+  {
+    const thread t = current_thread();
+    DictionaryDatum status(new Dictionary);
+
+    for (size_t i = 0; i < connections.size(); ++i) {
+      const ConnectionID &conn = connections[i];
+      if (conn.get_target_thread() != t) {
+        continue;
+      }
+
+      for (size_t k = 0; k < keys.size(); ++k) {
+        (*status)[keys[k]] = values.get(i, k);
+      }
+
+      try {
+        net.set_synapse_status(conn.get_source_gid(),
+                               conn.get_synapse_model_id(), conn.get_port(),
+                               conn.get_target_thread(), status);
+      } catch (...) {
+#pragma omp critical(stdp_state_loader)
+        {
+          if (invalid < 0) {
+            invalid = i;
+          }
+        }
+      }
+    }
+  }
+
+  if (invalid >= 0) {
+    throw BadProperty("Connection " + String::compose("%1", invalid) +
+                      " does not accept the given states.");
+  }
+}
@@ -0,0 +1,70 @@
+//
+//  stdp_state_loader.h
+//  NEST
+//
+//
+
+/* BeginDocumentation
+ Name: stdp_state_loader - Bulk setting of plastic states from arrays.
+
+ Description:
+ SetSTDPStates writes the weight and trace states of many STDP nodes or
+ stdp_triplet_all_in_one_synapse connections at once. Values come from a
+ contiguous array of doubles in row-major order (one row per target, one
+ column per key) or from a .npy file, which is memory-mapped instead of read.
+
+ Rows are written in parallel, each thread writing the targets it owns.
+ Node states are written directly in place, without going through the status
+ dictionary nor the validation of SetStatus. Connections have no such access
+ in the kernel and go through the synapse status dictionaries.
+
+ Parameters:
+ targets            array: node GIDs or connections as given by GetConnections
+ keys               array: state names, e.g. weight, Kplus or Zslow
+ values             double vector or string: values, or path to a .npy file
+ of shape (len(targets), len(keys)), float32 or float64 in C order
+
+ SeeAlso: stdp_triplet_node, stdp_longterm_node,
+ stdp_triplet_all_in_one_synapse, stdp_checkpoint
+ */
+
+#ifndef STDP_STATE_LOADER_H
+#define STDP_STATE_LOADER_H
+
+#include <string>
+#include <vector>
+
+#include "nest.h"
+#include "name.h"
+#include "tokenarray.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+class STDPStateLoader {
+public:
+  static void set_states(const TokenArray &targets,
+                         const std::vector<Name> &keys,
+                         const std::vector<double_t> &values);
+
+  static void set_states(const TokenArray &targets,
+                         const std::vector<Name> &keys,
+                         const std::string &filename);
+
+private:
+  template <typename ValuesT>
+  static void set_states_(const TokenArray &, const std::vector<Name> &,
+                          const ValuesT &);
+
+  template <typename ValuesT>
+  static void set_node_states_(const TokenArray &, const std::vector<Name> &,
+                               const ValuesT &);
+
+  template <typename ValuesT>
+  static void set_connection_states_(const TokenArray &,
+                                     const std::vector<Name> &,
+                                     const ValuesT &);
+};
+}
+
+#endif /* STDP_STATE_LOADER_H */
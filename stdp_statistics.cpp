@@ -0,0 +1,258 @@
+//
+//  stdp_statistics.cpp
+//  NEST
+//
+//
+
+#include "stdp_statistics.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "stdpnames.h"
+#include "network.h"
+#include "nestmodule.h"
+#include "arraydatum.h"
+#include "dictutils.h"
+
+using namespace nest;
+
+/* ----------------------------------------------------------- accumulator */
+
+stdpmodule::WeightStatistics::WeightStatistics()
+    : n_(0), n_updates_(0), n_Wmin_(0), n_Wmax_(0), mean_(0.0), m2_(0.0),
+      min_(std::numeric_limits<double_t>::infinity()),
+      max_(-std::numeric_limits<double_t>::infinity()), hist_min_(0.0),
+      hist_max_(1.0), histogram_() {}
+
+void stdpmodule::WeightStatistics::configure(double_t hist_min,
+                                             double_t hist_max, size_t bins) {
+  hist_min_ = hist_min;
+  hist_max_ = hist_max;
+  histogram_.assign(bins, 0);
+  reset();
+}
+
+void stdpmodule::WeightStatistics::reset() {
+  n_ = 0;
+  n_updates_ = 0;
+  n_Wmin_ = 0;
+  n_Wmax_ = 0;
+  mean_ = 0.0;
+  m2_ = 0.0;
+  min_ = std::numeric_limits<double_t>::infinity();
+  max_ = -std::numeric_limits<double_t>::infinity();
+  std::fill(histogram_.begin(), histogram_.end(), 0);
+}
+
+size_t stdpmodule::WeightStatistics::bin_(double_t w) const {
+  const double_t bins = static_cast<double_t>(histogram_.size());
+  const double_t pos = (w - hist_min_) / (hist_max_ - hist_min_) * bins;
+
+  if (!(pos > 0.0)) {
+    return 0;
+  }
+  if (pos >= bins) {
+    return histogram_.size() - 1;
+  }
+  return static_cast<size_t>(pos);
+}
+
+void stdpmodule::WeightStatistics::observe_(double_t w) {
+  min_ = std::min(min_, w);
+  max_ = std::max(max_, w);
+}
+
+void stdpmodule::WeightStatistics::enter(double_t w, double_t Wmin,
+                                         double_t Wmax) {
+  ++n_;
+  const double_t delta = w - mean_;
+  mean_ += delta / n_;
+  m2_ += delta * (w - mean_);
+  ++histogram_[bin_(w)];
+
+  if (w <= Wmin) {
+    ++n_Wmin_;
+  }
+  if (w >= Wmax) {
+    ++n_Wmax_;
+  }
+
+  observe_(w);
+}
+
+void stdpmodule::WeightStatistics::move(double_t from, double_t to,
+                                        double_t Wmin, double_t Wmax) {
+  ++n_updates_;
+  const double_t mean = mean_ + (to - from) / n_;
+  m2_ += (to - from) * (to - mean + from - mean_);
+  mean_ = mean;
+
+  const size_t from_bin = bin_(from);
+  const size_t to_bin = bin_(to);
+  if (from_bin != to_bin) {
+    --histogram_[from_bin];
+    ++histogram_[to_bin];
+  }
+
+  n_Wmin_ += (to <= Wmin) - (from <= Wmin);
+  n_Wmax_ += (to >= Wmax) - (from >= Wmax);
+
+  observe_(to);
+}
+
+void stdpmodule::WeightStatistics::leave(double_t w, double_t Wmin,
+                                         double_t Wmax) {
+  --n_;
+  if (n_ > 0) {
+    const double_t delta = w - mean_;
+    mean_ -= delta / n_;
+    m2_ -= delta * (w - mean_);
+  } else {
+    // the population is empty, drop the rounding left by the updates
+    mean_ = 0.0;
+    m2_ = 0.0;
+  }
+  --histogram_[bin_(w)];
+
+  if (w <= Wmin) {
+    --n_Wmin_;
+  }
+  if (w >= Wmax) {
+    --n_Wmax_;
+  }
+}
+
+void stdpmodule::WeightStatistics::merge(const WeightStatistics &other) {
+  assert(histogram_.size() == other.histogram_.size());
+
+  if (other.n_ > 0) {
+    // pairwise combination of the moments (Chan et al.)
+    const double_t n = n_ + other.n_;
+    const double_t delta = other.mean_ - mean_;
+    mean_ += delta * other.n_ / n;
+    m2_ += other.m2_ + delta * delta * n_ * other.n_ / n;
+  }
+
+  n_ += other.n_;
+  n_updates_ += other.n_updates_;
+  n_Wmin_ += other.n_Wmin_;
+  n_Wmax_ += other.n_Wmax_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+
+  for (size_t i = 0; i < histogram_.size(); ++i) {
+    histogram_[i] += other.histogram_[i];
+  }
+}
+
+void stdpmodule::WeightStatistics::get(DictionaryDatum &d) const {
+  // moments are updated by differences, clip the rounding noise
+  const double_t variance = n_ > 0 ? std::max(m2_ / n_, 0.0) : 0.0;
+
+  def<long_t>(d, stdpnames::n, n_);
+  def<double_t>(d, stdpnames::mean, mean_);
+  def<double_t>(d, stdpnames::variance, variance);
+  def<double_t>(d, stdpnames::min_observed, min_);
+  def<double_t>(d, stdpnames::max_observed, max_);
+  def<long_t>(d, stdpnames::n_at_Wmin, n_Wmin_);
+  def<long_t>(d, stdpnames::n_at_Wmax, n_Wmax_);
+  def<long_t>(d, stdpnames::n_updates, n_updates_);
+
+  ArrayDatum histogram;
+  histogram.reserve(histogram_.size());
+  for (size_t i = 0; i < histogram_.size(); ++i) {
+    histogram.push_back(new IntegerDatum(histogram_[i]));
+  }
+  (*d)[stdpnames::histogram] = histogram;
+}
+
+/* ----------------------------------------------------------- registry */
+
+bool stdpmodule::STDPStatistics::enabled_ = false;
+nest::long_t stdpmodule::STDPStatistics::epoch_ = 0;
+nest::double_t stdpmodule::STDPStatistics::hist_min_ = 0.0;
+nest::double_t stdpmodule::STDPStatistics::hist_max_ = 100.0;
+nest::long_t stdpmodule::STDPStatistics::bins_ = 20;
+std::vector<std::string> stdpmodule::STDPStatistics::names_;
+std::vector<std::vector<stdpmodule::WeightStatistics> >
+    stdpmodule::STDPStatistics::statistics_;
+std::vector<nest::long_t> stdpmodule::STDPStatistics::n_pruned_;
+
+stdpmodule::STDPStatistics::Model
+stdpmodule::STDPStatistics::register_model(const std::string &name) {
+  const std::vector<std::string>::const_iterator registered =
+      std::find(names_.begin(), names_.end(), name);
+  if (registered != names_.end()) {
+    return registered - names_.begin();
+  }
+
+  // accumulators of the model are sized on the next reset
+  names_.push_back(name);
+  statistics_.resize(names_.size());
+  n_pruned_.push_back(0);
+  return names_.size() - 1;
+}
+
+void stdpmodule::STDPStatistics::set_status(const DictionaryDatum &d) {
+  bool enabled = enabled_;
+  double_t hist_min = hist_min_;
+  double_t hist_max = hist_max_;
+  long_t bins = bins_;
+
+  updateValue<bool>(d, stdpnames::enabled, enabled);
+  updateValue<double_t>(d, stdpnames::histogram_min, hist_min);
+  updateValue<double_t>(d, stdpnames::histogram_max, hist_max);
+  updateValue<long_t>(d, stdpnames::histogram_bins, bins);
+
+  if (!(hist_max > hist_min)) {
+    throw BadProperty("histogram_max must be larger than histogram_min.");
+  }
+
+  if (bins < 1) {
+    throw BadProperty("histogram_bins must be strictly positive.");
+  }
+
+  enabled_ = enabled;
+  hist_min_ = hist_min;
+  hist_max_ = hist_max;
+  bins_ = bins;
+
+  reset();
+}
+
+void stdpmodule::STDPStatistics::get_status(DictionaryDatum &d) {
+  def<bool>(d, stdpnames::enabled, enabled_);
+  def<double_t>(d, stdpnames::histogram_min, hist_min_);
+  def<double_t>(d, stdpnames::histogram_max, hist_max_);
+  def<long_t>(d, stdpnames::histogram_bins, bins_);
+
+  for (size_t m = 0; m < n_models(); ++m) {
+    WeightStatistics merged;
+    merged.configure(hist_min_, hist_max_, bins_);
+
+    for (size_t t = 0; t < statistics_[m].size(); ++t) {
+      merged.merge(statistics_[m][t]);
+    }
+
+    DictionaryDatum model_dict(new Dictionary);
+    merged.get(model_dict);
+    def<long_t>(model_dict, stdpnames::n_pruned, n_pruned_[m]);
+    (*d)[Name(model_name(m))] = model_dict;
+  }
+}
+
+void stdpmodule::STDPStatistics::reset() {
+  // synapses holding an older epoch enter the population again
+  ++epoch_;
+
+  const thread n_threads = nest::NestModule::get_network().get_num_threads();
+
+  for (size_t m = 0; m < n_models(); ++m) {
+    n_pruned_[m] = 0;
+    statistics_[m].resize(n_threads);
+    for (thread t = 0; t < n_threads; ++t) {
+      statistics_[m][t].configure(hist_min_, hist_max_, bins_);
+    }
+  }
+}
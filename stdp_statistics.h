@@ -0,0 +1,238 @@
+//
+//  stdp_statistics.h
+//  NEST
+//
+//
+
+/* BeginDocumentation
+ Name: stdp_statistics - Online statistics of plastic weight distributions.
+
+ Description:
+ Every STDP model of this module can feed its weight updates into per-model,
+ per-thread accumulators. Models, including the ones generated by
+ codegen/stdp_codegen.py, register under their kernel name when the module
+ is initialized and pass the id they get to the statistics, the plasticity
+ schedule and pruning counts. Population moments, histogram and bound counts are
+ maintained incrementally from the weight before and after each update, so
+ reading them costs O(bins) instead of O(synapses). Mean and variance follow
+ Welford's updates, which do not lose the variance to cancellation over long
+ runs as raw sums of squares do. Thread accumulators are merged on request.
+
+ A synapse joins the population the first time it is touched after the
+ statistics were enabled or reset: nodes on calibration (i.e. at the start of
+ each Simulate), connections on their first pre-synaptic spike. Weights
+ changed through SetStatus while statistics are enabled are only accounted
+ for after the next reset. Pruned synapses leave the population.
+
+ Parameters (SetSTDPStatistics):
+ enabled            bool: whether models record their weight updates
+ histogram_bins     int: number of histogram bins
+ histogram_min      double: lower edge of the first bin
+ histogram_max      double: upper edge of the last bin (values out of range
+ are clamped to the first or last bin)
+
+ Statistics (GetSTDPStatistics, one dictionary per model):
+ n                  int: number of synapses in the population
+ mean               double: mean weight
+ variance           double: weight variance
+ min_observed       double: smallest weight observed since the last reset
+ (running extremum, not the minimum of the current population)
+ max_observed       double: largest weight observed since the last reset
+ (running extremum, not the maximum of the current population)
+ histogram          array: synapses per bin
+ n_at_Wmin          int: synapses at their minimum weight
+ n_at_Wmax          int: synapses at their maximum weight
+ n_updates          int: weight updates since the last reset
+ n_pruned           int: synapses pruned since the last reset (counted even
+ when statistics are disabled)
+
+ Notes:
+ Enabling, reconfiguring or resetting the statistics drops all accumulators.
+ Accumulators are sized for the number of threads at that time, they must be
+ reset after changing local_num_threads.
+
+ SeeAlso: stdp_triplet_node, stdp_longterm_node,
+ stdp_triplet_all_in_one_synapse
+ */
+
+#ifndef STDP_STATISTICS_H
+#define STDP_STATISTICS_H
+
+#include <string>
+#include <vector>
+
+#include "nest.h"
+#include "dictdatum.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+/**
+ * Weight distribution accumulator of one model on one thread.
+ */
+class WeightStatistics {
+public:
+  WeightStatistics();
+
+  void configure(double_t hist_min, double_t hist_max, size_t bins);
+  void reset();
+
+  /**
+   * Add a synapse of weight w to the population.
+   */
+  void enter(double_t w, double_t Wmin, double_t Wmax);
+
+  /**
+   * Move a synapse of the population from one weight to another.
+   */
+  void move(double_t from, double_t to, double_t Wmin, double_t Wmax);
+
+  /**
+   * Remove a synapse of weight w from the population.
+   */
+  void leave(double_t w, double_t Wmin, double_t Wmax);
+
+  void merge(const WeightStatistics &);
+  void get(DictionaryDatum &) const;
+
+private:
+  size_t bin_(double_t) const;
+  void observe_(double_t);
+
+  long_t n_;
+  long_t n_updates_;
+  long_t n_Wmin_;
+  long_t n_Wmax_;
+
+  double_t mean_;
+  // sum of squared deviations from the mean
+  double_t m2_;
+  double_t min_;
+  double_t max_;
+
+  double_t hist_min_;
+  double_t hist_max_;
+  std::vector<long_t> histogram_;
+};
+
+/**
+ * Registry of the accumulators of all models and threads.
+ */
+class STDPStatistics {
+public:
+  typedef size_t Model;
+
+  static bool enabled() { return enabled_; }
+
+  /**
+   * Register a model by its kernel name and return its id, the same id for
+   * a name registered again.
+   */
+  static Model register_model(const std::string &name);
+
+  static size_t n_models() { return names_.size(); }
+
+  /**
+   * Name of a model as registered in the kernel.
+   */
+  static const std::string &model_name(Model m) { return names_[m]; }
+
+  /**
+   * Record the update of a synapse weight. The epoch is stored by the synapse
+   * and tells whether it is already part of the current population.
+   */
+  static void record(Model m, thread t, long_t &epoch, double_t from,
+                     double_t to, double_t Wmin, double_t Wmax);
+
+  /**
+   * Add a synapse to the current population unless it already belongs to it.
+   */
+  static void enter(Model m, thread t, long_t &epoch, double_t w,
+                    double_t Wmin, double_t Wmax);
+
+  /**
+   * Remove a pruned synapse from the population and count it.
+   */
+  static void prune(Model m, thread t, long_t &epoch, double_t w,
+                    double_t Wmin, double_t Wmax);
+
+  static void set_status(const DictionaryDatum &);
+  static void get_status(DictionaryDatum &);
+  static void reset();
+
+private:
+  static WeightStatistics *get_(Model, thread);
+
+  static bool enabled_;
+  static long_t epoch_;
+  static double_t hist_min_;
+  static double_t hist_max_;
+  static long_t bins_;
+  static std::vector<std::string> names_;
+  static std::vector<std::vector<WeightStatistics> > statistics_;
+  static std::vector<long_t> n_pruned_;
+};
+
+inline WeightStatistics *STDPStatistics::get_(Model m, thread t) {
+  if (static_cast<size_t>(t) >= statistics_[m].size()) {
+    return 0; // threads changed since last reset
+  }
+  return &statistics_[m][t];
+}
+
+inline void STDPStatistics::record(Model m, thread t, long_t &epoch,
+                                   double_t from, double_t to, double_t Wmin,
+                                   double_t Wmax) {
+  if (!enabled_) {
+    return;
+  }
+
+  WeightStatistics *stats = get_(m, t);
+  if (stats == 0) {
+    return;
+  }
+
+  if (epoch != epoch_) {
+    epoch = epoch_;
+    stats->enter(to, Wmin, Wmax);
+  } else {
+    stats->move(from, to, Wmin, Wmax);
+  }
+}
+
+inline void STDPStatistics::enter(Model m, thread t, long_t &epoch,
+                                  double_t w, double_t Wmin, double_t Wmax) {
+  if (!enabled_ or epoch == epoch_) {
+    return;
+  }
+
+  WeightStatistics *stats = get_(m, t);
+  if (stats == 0) {
+    return;
+  }
+
+  epoch = epoch_;
+  stats->enter(w, Wmin, Wmax);
+}
+
+inline void STDPStatistics::prune(Model m, thread t, long_t &epoch,
+                                  double_t w, double_t Wmin, double_t Wmax) {
+// pruning is rare, a shared counter is cheap enough
+#pragma omp atomic
+  ++n_pruned_[m];
+
+  if (!enabled_ or epoch != epoch_) {
+    return;
+  }
+
+  WeightStatistics *stats = get_(m, t);
+  if (stats == 0) {
+    return;
+  }
+
+  epoch = -1;
+  stats->leave(w, Wmin, Wmax);
+}
+}
+
+#endif /* STDP_STATISTICS_H */
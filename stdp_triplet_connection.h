@@ -39,6 +39,11 @@
  Aminus             double: weight of pair depression rule (A_minus_2 of [1])
  Aminus_triplet     double: weight of triplet depression rule (A_minus_3 of [1])
 
+ prune_threshold    double: weight at or below which the synapse is depressed
+ (pruning is disabled by default)
+ prune_time         double: time the synapse must stay depressed before it is
+ pruned (ms)
+
  States:
  weight				double: synaptic weight
  Kplus              double: pre-synaptic trace (e.g. amount of glutamate
@@ -50,6 +55,39 @@
  concentration...) (o_1 of [1])
  Kminus_triplet		double: triplet post-synaptic trace (e.g. number of
  secondary messengers...) (o_2 of [1])
+ active             bool: false once pruned, the connection then neither
+ updates nor transmits (set it back to true to revive it)
+ t_depressed        double: time since which the weight is at or below the
+ pruning threshold, -1 when above (ms)
+ last_offset        double: offset of the last pre-synaptic spike (ms)
+
+ Notes about pruning:
+ Pruning is checked on pre-synaptic spikes. Connections cannot be removed from
+ the kernel, a pruned connection returns on its spikes without reading the
+ post-synaptic history. The history it skipped is marked as read in one pass
+ on its first spike once revived, until then its target keeps its spikes
+ archived, as for a connection whose source is silent.
+
+ Notes about plasticity gating:
+ Outside the learning windows of stdp_plasticity, spikes do not read the
+ post-synaptic history, only pre-synaptic traces follow them. Post-synaptic
+ traces catch up with the history they skipped on the first spike inside a
+ window, until then their status holds their value at the last spike read
+ and the target keeps its spikes archived.
+
+ Notes about precise spike timing:
+ Offsets of pre-synaptic spikes are taken into account, the rule then runs on
+ the exact spike times of precise neurons or parrot_neuron_ps. Post-synaptic
+ spike times are the ones archived by the target.
+
+ Notes about deferred plasticity:
+ With a stdp_deferred_plasticity device, spikes are delivered with the
+ current weight and updates are applied at the end of the slice, grouped by
+ post-synaptic target, with the same resulting weights.
+
+ Notes about snapshots:
+ With a stdp_weight_snapshot device, the weight is written to the snapshot
+ of its thread after each update.
 
  Transmits: SpikeEvent
 
@@ -60,7 +98,8 @@
 
  FirstVersion: Octo 2015
  Author: Alexander Seeholzer, Teo Stocco
- SeeAlso: synapsedict, stdp_synapse, static_synapse
+ SeeAlso: synapsedict, stdp_synapse, static_synapse, stdp_plasticity,
+ stdp_deferred_plasticity, stdp_weight_snapshot
  */
 
 #ifndef stdp_triplet_connection_h
@@ -68,9 +107,15 @@
 
 #include <cassert>
 #include <cmath>
+#include <limits>
 
 #include "connection.h"
 #include "stdpnames.h"
+#include "stdp_statistics.h"
+#include "stdp_plasticity.h"
+#include "stdp_deferred_plasticity.h"
+#include "stdp_weight_snapshot.h"
+#include "stdp_triplet_rule.h"
 
 namespace stdpmodule {
 using namespace nest;
@@ -137,7 +182,59 @@ public:
 
   void set_weight(double_t w) { weight_ = w; }
 
+  /**
+   * Register the model under its kernel name, for statistics, plasticity
+   * schedules and pruning counts.
+   */
+  static void register_stdp_model(const std::string &name) {
+    stdp_model_ = STDPStatistics::register_model(name);
+  }
+
 private:
+  /**
+   * Update traces and weight for a pre-synaptic spike at t_spike, preceded by
+   * one at t_last_prespike (ms).
+   */
+  void update_(thread t, Node *target, nest::index source,
+               double_t t_last_prespike, double_t t_spike);
+
+  /**
+   * Update traces and weight from the post-synaptic history, for a spike
+   * that is not gated off.
+   */
+  void update_plastic_(thread t, Node *target, double_t t_last_prespike,
+                       double_t t_spike);
+
+  /**
+   * Read the post-synaptic history left unread since t_unread_ up to t (ms).
+   */
+  void read_history_(Node *target, double_t t);
+
+  /**
+   * Apply a deferred update.
+   */
+  static void apply_(const STDPDeferredPlasticity::Update &update, thread t) {
+    static_cast<STDPTripletConnection *>(update.connection_)
+        ->update_(t, update.target_, update.source_, update.t_last_prespike_,
+                  update.t_spike_);
+  }
+
+  triplet_rule::Traces traces_() {
+    return triplet_rule::Traces(Kplus_, Kplus_triplet_, Kminus_,
+                                Kminus_triplet_);
+  }
+
+  /**
+   * Track since when the weight is at or below the pruning threshold.
+   */
+  void depressed_(double_t t) {
+    if (weight_ > prune_threshold_) {
+      t_depressed_ = -1.0;
+    } else if (t_depressed_ < 0.0) {
+      t_depressed_ = t;
+    }
+  }
+
   double_t weight_;
   double_t Wmax_;
   double_t Wmin_;
@@ -157,9 +254,29 @@ private:
   double_t Kplus_triplet_;
   double_t Kminus_;
   double_t Kminus_triplet_;
+
+  double_t prune_threshold_;
+  double_t prune_time_;
+  double_t t_depressed_;
+  bool active_;
+  // whether post-synaptic traces follow the unread history, i.e. it was left
+  // unread while gated off rather than pruned
+  bool gated_;
+  // time since which the post-synaptic history is unread, -1 when read
+  double_t t_unread_;
+
+  double_t last_offset_;
+  long_t statistics_epoch_;
+  long_t snapshot_slot_;
+
+  static STDPStatistics::Model stdp_model_;
 };
 }
 
+template <typename targetidentifierT>
+stdpmodule::STDPStatistics::Model
+    stdpmodule::STDPTripletConnection<targetidentifierT>::stdp_model_ = 0;
+
 // Default constructor
 template <typename targetidentifierT>
 stdpmodule::STDPTripletConnection<targetidentifierT>::STDPTripletConnection()
@@ -167,7 +284,11 @@ stdpmodule::STDPTripletConnection<targetidentifierT>::STDPTripletConnection()
       tau_minus_(33.7), tau_minus_triplet_(125), Aplus_(0.1), Aminus_(0.1),
       Aplus_triplet_(0.1), Aminus_triplet_(0.1), Kplus_(0.0),
       Kplus_triplet_(0.0), Kminus_(0.0), Kminus_triplet_(0.0), Wmax_(100.0),
-      Wmin_(0.0), nearest_spike_(false) {}
+      Wmin_(0.0), nearest_spike_(false),
+      prune_threshold_(-std::numeric_limits<double_t>::infinity()),
+      prune_time_(0.0), t_depressed_(-1.0), active_(true), gated_(false),
+      t_unread_(-1.0), last_offset_(0.0), statistics_epoch_(-1),
+      snapshot_slot_(-1) {}
 
 // Copy constructor.
 template <typename targetidentifierT>
@@ -180,26 +301,114 @@ stdpmodule::STDPTripletConnection<targetidentifierT>::STDPTripletConnection(
       Aminus_triplet_(rhs.Aminus_triplet_), Kplus_(rhs.Kplus_),
       Kplus_triplet_(rhs.Kplus_triplet_), Kminus_(rhs.Kminus_),
       Kminus_triplet_(rhs.Kminus_triplet_), Wmax_(rhs.Wmax_), Wmin_(rhs.Wmin_),
-      nearest_spike_(rhs.nearest_spike_) {}
+      nearest_spike_(rhs.nearest_spike_),
+      prune_threshold_(rhs.prune_threshold_), prune_time_(rhs.prune_time_),
+      t_depressed_(rhs.t_depressed_), active_(rhs.active_),
+      gated_(rhs.gated_), t_unread_(rhs.t_unread_),
+      last_offset_(rhs.last_offset_), statistics_epoch_(-1),
+      snapshot_slot_(-1) {}
 
 // Send an event to the receiver of this connection.
 template <typename targetidentifierT>
 inline void stdpmodule::STDPTripletConnection<targetidentifierT>::send(
     Event &e, thread t, double_t t_lastspike, const CommonSynapseProperties &) {
 
-  double_t t_spike = e.get_stamp().get_ms();
-  double_t dendritic_delay = get_delay();
+  // exact spike times, offsets are zero for spikes on the grid
+  double_t t_spike = e.get_stamp().get_ms() - e.get_offset();
+  double_t t_last_prespike = t_lastspike - last_offset_;
   Node *target = get_target(t);
+  last_offset_ = e.get_offset();
+
+  // deferred updates are applied at the end of the slice, pruned connections
+  // return from update_ at once
+  if (active_ and STDPDeferredPlasticity::deferred(t)) {
+    STDPDeferredPlasticity::Update update = {
+        &STDPTripletConnection::apply_, this, target, e.get_sender_gid(),
+        t_last_prespike, t_spike};
+    STDPDeferredPlasticity::defer(t, update);
+  } else {
+    update_(t, target, e.get_sender_gid(), t_last_prespike, t_spike);
+    if (!active_) {
+      return;
+    }
+  }
+
+  // send event
+  e.set_receiver(*target);
+  e.set_weight(weight_);
+  e.set_delay(get_delay_steps());
+  e.set_rport(get_rport());
+  e();
+}
+
+// Update the connection for a pre-synaptic spike.
+template <typename targetidentifierT>
+void stdpmodule::STDPTripletConnection<targetidentifierT>::update_(
+    thread t, Node *target, nest::index source, double_t t_last_prespike,
+    double_t t_spike) {
+
+  // pruned connections leave the history unread from their last spike
+  if (!active_) {
+    if (t_unread_ < 0.0 or gated_) {
+      read_history_(target, t_last_prespike);
+      t_unread_ = t_last_prespike;
+      gated_ = false;
+    }
+    return;
+  }
+
+  const double_t ceiling = triplet_rule::ceiling(nearest_spike_);
+
+  // connections gated off up to the spike do not read the history either,
+  // only their pre-synaptic traces follow the spike
+  double_t until;
+  if (!STDPPlasticity::plastic(stdp_model_, t_last_prespike, until) and
+      until > t_spike) {
+    if (t_unread_ < 0.0 or !gated_) {
+      read_history_(target, t_last_prespike);
+      t_unread_ = t_last_prespike;
+      gated_ = true;
+    }
+
+    const double_t delta = t_spike - t_last_prespike;
+    triplet_rule::decay(traces_(), std::exp(-delta / tau_plus_),
+                        std::exp(-delta / tau_plus_triplet_), 1.0, 1.0);
+    triplet_rule::on_pre(traces_(), Aminus_, Aminus_triplet_, ceiling);
+  } else {
+    update_plastic_(t, target, t_last_prespike, t_spike);
+  }
+
+  if (t_depressed_ >= 0.0 and t_spike - t_depressed_ >= prune_time_) {
+    active_ = false;
+    t_depressed_ = -1.0;
+    STDPStatistics::prune(stdp_model_, t, statistics_epoch_, weight_, Wmin_,
+                          Wmax_);
+  }
+
+  STDPWeightSnapshot::record(t, snapshot_slot_, source, target->get_gid(),
+                             weight_);
+}
+
+// Apply the rule to the post-synaptic spikes since the last pre-synaptic
+// spike and to the pre-synaptic spike.
+template <typename targetidentifierT>
+void stdpmodule::STDPTripletConnection<targetidentifierT>::update_plastic_(
+    thread t, Node *target, double_t t_last_prespike, double_t t_spike) {
+
+  read_history_(target, t_last_prespike);
 
   // get spike history in relevant range (t1, t2] from post-synaptic neuron
   // (without the added dentritic delay)
+  double_t dendritic_delay = get_delay();
   std::deque<histentry>::iterator start;
   std::deque<histentry>::iterator finish;
-  target->get_history(t_lastspike - dendritic_delay, t_spike - dendritic_delay,
-                      &start, &finish);
+  target->get_history(t_last_prespike - dendritic_delay,
+                      t_spike - dendritic_delay, &start, &finish);
+
+  const double_t ceiling = triplet_rule::ceiling(nearest_spike_);
 
   // go through all post-synaptic spikes since the last pre-synaptic spike
-  double_t t_last_postspike = t_lastspike;
+  double_t t_last_postspike = t_last_prespike;
   while (start != finish) {
 
     // deal with dendritic delay
@@ -213,25 +422,19 @@ inline void stdpmodule::STDPTripletConnection<targetidentifierT>::send(
     t_last_postspike = t_adjusted;
     ++start;
 
-    if (delta > 0) {
-
-      // model variables each delta update
-      Kplus_ *= std::exp(-delta / tau_plus_);
-      Kplus_triplet_ *= std::exp(-delta / tau_plus_triplet_);
-      Kminus_ *= std::exp(-delta / tau_minus_);
-      Kminus_triplet_ *= std::exp(-delta / tau_minus_triplet_);
-
-      // potentiate: t = t^post
-      weight_ += Kplus_ * (Aplus_ + Aplus_triplet_ * Kminus_triplet_);
-      weight_ = std::min(std::max(weight_, Wmin_), Wmax_);
-    }
-
-    Kminus_ += +1;
-    Kminus_triplet_ += 1;
-
-    if (nearest_spike_) {
-      Kminus_ = std::min(Kminus_, 1.0);
-      Kminus_triplet_ = std::min(Kminus_triplet_, 1.0);
+    // model variables each delta update
+    triplet_rule::decay_over(traces_(), delta, tau_plus_, tau_plus_triplet_,
+                             tau_minus_, tau_minus_triplet_);
+
+    // potentiate: t = t^post
+    const double_t change =
+        triplet_rule::on_post(traces_(), Aplus_, Aplus_triplet_, ceiling);
+    if (delta > 0 and STDPPlasticity::plastic(stdp_model_, t_adjusted)) {
+      const double_t weight = weight_;
+      weight_ = triplet_rule::clamp(weight_ + change, Wmin_, Wmax_);
+      STDPStatistics::record(stdp_model_, t, statistics_epoch_, weight,
+                             weight_, Wmin_, Wmax_);
+      depressed_(t_adjusted);
     }
   }
 
@@ -241,29 +444,56 @@ inline void stdpmodule::STDPTripletConnection<targetidentifierT>::send(
   assert(remaing_delta_ >= 0);
 
   // model variables remaining delta update
-  Kplus_ *= std::exp(-remaing_delta_ / tau_plus_);
-  Kplus_triplet_ *= std::exp(-remaing_delta_ / tau_plus_triplet_);
-  Kminus_ *= std::exp(-remaing_delta_ / tau_minus_);
-  Kminus_triplet_ *= std::exp(-remaing_delta_ / tau_minus_triplet_);
+  triplet_rule::decay_over(traces_(), remaing_delta_, tau_plus_,
+                           tau_plus_triplet_, tau_minus_, tau_minus_triplet_);
 
   // depress: t = t^pre
-  weight_ -= Kminus_ * (Aminus_ + Aminus_triplet_ * Kplus_triplet_);
-  weight_ = std::min(std::max(weight_, Wmin_), Wmax_);
+  const double_t change =
+      triplet_rule::on_pre(traces_(), Aminus_, Aminus_triplet_, ceiling);
+  if (STDPPlasticity::plastic(stdp_model_, t_spike)) {
+    const double_t weight = weight_;
+    weight_ = triplet_rule::clamp(weight_ + change, Wmin_, Wmax_);
+    STDPStatistics::record(stdp_model_, t, statistics_epoch_, weight,
+                           weight_, Wmin_, Wmax_);
+    depressed_(t_spike);
+  }
+}
 
-  Kplus_ += 1;
-  Kplus_triplet_ += 1;
+// Read the history left unread up to t (ms), gated connections catch their
+// post-synaptic traces up with the spikes they skipped.
+template <typename targetidentifierT>
+void stdpmodule::STDPTripletConnection<targetidentifierT>::read_history_(
+    Node *target, double_t t) {
+  if (t_unread_ < 0.0) {
+    return;
+  }
 
-  if (nearest_spike_) {
-    Kplus_ = std::min(Kplus_, 1.0);
-    Kplus_triplet_ = std::min(Kplus_triplet_, 1.0);
+  double_t dendritic_delay = get_delay();
+  std::deque<histentry>::iterator start;
+  std::deque<histentry>::iterator finish;
+  target->get_history(t_unread_ - dendritic_delay, t - dendritic_delay,
+                      &start, &finish);
+
+  if (gated_) {
+    const double_t ceiling = triplet_rule::ceiling(nearest_spike_);
+    double_t t_last_postspike = t_unread_;
+    for (; start != finish; ++start) {
+      const double_t t_adjusted = start->t_ + dendritic_delay;
+      const double_t delta = t_adjusted - t_last_postspike;
+      t_last_postspike = t_adjusted;
+
+      triplet_rule::decay(traces_(), 1.0, 1.0,
+                          std::exp(-delta / tau_minus_),
+                          std::exp(-delta / tau_minus_triplet_));
+      triplet_rule::on_post(traces_(), Aplus_, Aplus_triplet_, ceiling);
+    }
+
+    const double_t delta = t - t_last_postspike;
+    triplet_rule::decay(traces_(), 1.0, 1.0, std::exp(-delta / tau_minus_),
+                        std::exp(-delta / tau_minus_triplet_));
   }
 
-  // send event
-  e.set_receiver(*target);
-  e.set_weight(weight_);
-  e.set_delay(get_delay_steps());
-  e.set_rport(get_rport());
-  e();
+  t_unread_ = -1.0;
 }
 
 // Get parameters
@@ -273,7 +503,7 @@ void stdpmodule::STDPTripletConnection<targetidentifierT>::get_status(
   ConnectionBase::get_status(d);
   def<double_t>(d, names::weight, weight_);
   def<double_t>(d, stdpnames::Wmax, Wmax_);
-  def<bool>(d, stdpnames::Wmin, Wmin_);
+  def<double_t>(d, stdpnames::Wmin, Wmin_);
   def<bool>(d, stdpnames::nearest_spike, nearest_spike_);
 
   def<double_t>(d, stdpnames::tau_plus, tau_plus_);
@@ -291,6 +521,12 @@ void stdpmodule::STDPTripletConnection<targetidentifierT>::get_status(
   def<double_t>(d, stdpnames::Kminus, Kminus_);
   def<double_t>(d, stdpnames::Kminus_triplet, Kminus_triplet_);
 
+  def<double_t>(d, stdpnames::prune_threshold, prune_threshold_);
+  def<double_t>(d, stdpnames::prune_time, prune_time_);
+  def<bool>(d, stdpnames::active, active_);
+  def<double_t>(d, stdpnames::t_depressed, t_depressed_);
+  def<double_t>(d, stdpnames::last_offset, last_offset_);
+
   def<long_t>(d, names::size_of, sizeof(*this));
 }
 
@@ -319,6 +555,16 @@ void stdpmodule::STDPTripletConnection<targetidentifierT>::set_status(
   updateValue<double_t>(d, stdpnames::Kminus, Kminus_);
   updateValue<double_t>(d, stdpnames::Kminus_triplet, Kminus_triplet_);
 
+  updateValue<double_t>(d, stdpnames::prune_threshold, prune_threshold_);
+  updateValue<double_t>(d, stdpnames::prune_time, prune_time_);
+  updateValue<bool>(d, stdpnames::active, active_);
+  updateValue<double_t>(d, stdpnames::t_depressed, t_depressed_);
+  updateValue<double_t>(d, stdpnames::last_offset, last_offset_);
+
+  if (!(prune_time_ >= 0)) {
+    throw BadProperty("Parameter prune_time must be positive.");
+  }
+
   if (!(Kplus_ >= 0)) {
     throw BadProperty("State Kplus must be positive.");
   }
@@ -336,7 +582,7 @@ void stdpmodule::STDPTripletConnection<targetidentifierT>::set_status(
   }
 
   if (!(Wmax_ >= Wmin_)) {
-    throw BadProperty("State Kminus_triplet must be positive.");
+    throw BadProperty("Parameter Wmax must be larger than or equal to Wmin.");
   }
 }
 
@@ -0,0 +1,391 @@
+//
+//  stdp_triplet_ensemble_node.cpp
+//  NEST
+//
+//
+
+#include "stdp_triplet_ensemble_node.h"
+
+#include <algorithm>
+
+#include "stdpnames.h"
+#include "network.h"
+#include "arraydatum.h"
+#include "doubledatum.h"
+#include "dictutils.h"
+#include "exceptions.h"
+
+using namespace nest;
+
+namespace {
+
+using nest::double_t;
+
+/**
+ * Read an array of the dictionary, a single number being an array of one
+ * value, return whether it was given.
+ */
+bool update_array(const DictionaryDatum &d, const Name &name,
+                  std::vector<double_t> &values) {
+  if (!d->known(name)) {
+    return false;
+  }
+
+  const Token &token = d->lookup(name);
+  if (dynamic_cast<ArrayDatum *>(token.datum()) == 0) {
+    values.assign(1, getValue<double_t>(token));
+    return true;
+  }
+
+  const TokenArray array = getValue<TokenArray>(token);
+  if (array.size() == 0) {
+    throw BadProperty("Array " + name.toString() + " must not be empty.");
+  }
+  values.resize(array.size());
+  for (size_t i = 0; i < array.size(); ++i) {
+    values[i] = getValue<double_t>(array[i]);
+  }
+  return true;
+}
+
+void def_array(DictionaryDatum &d, const Name &name,
+               const std::vector<double_t> &values) {
+  ArrayDatum array;
+  array.reserve(values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    array.push_back(new DoubleDatum(values[i]));
+  }
+  (*d)[name] = array;
+}
+
+/**
+ * Repeat an array of a single value for all members, throw if it is of
+ * another size than the ensemble.
+ */
+void fit_array(const Name &name, std::vector<double_t> &values, size_t size) {
+  if (values.size() == 1) {
+    values.assign(size, values[0]);
+  } else if (values.size() != size) {
+    throw BadProperty("Array " + name.toString() +
+                      " must have one value or one per member.");
+  }
+}
+}
+
+/* ----------------------------------------------------------- parameters */
+
+stdpmodule::STDPTripletEnsemble::Parameters_::Parameters_()
+    : Wmax_(1, 100.0), Wmin_(1, 0.0), nearest_spike_(false),
+      tau_plus_(1, 16.8), tau_plus_triplet_(1, 101.0), tau_minus_(1, 33.7),
+      tau_minus_triplet_(1, 125), Aplus_(1, 0.1), Aminus_(1, 7e-3),
+      Aplus_triplet_(1, 6.2e-3), Aminus_triplet_(1, 2.3e-4),
+      precise_times_(false), member_(0) {}
+
+void stdpmodule::STDPTripletEnsemble::Parameters_::get(
+    DictionaryDatum &d) const {
+  def_array(d, stdpnames::Wmax, Wmax_);
+  def_array(d, stdpnames::Wmin, Wmin_);
+  def<bool>(d, stdpnames::nearest_spike, nearest_spike_);
+
+  def_array(d, stdpnames::tau_plus, tau_plus_);
+  def_array(d, stdpnames::tau_plus_triplet, tau_plus_triplet_);
+  def_array(d, stdpnames::tau_minus, tau_minus_);
+  def_array(d, stdpnames::tau_minus_triplet, tau_minus_triplet_);
+
+  def_array(d, stdpnames::Aplus, Aplus_);
+  def_array(d, stdpnames::Aminus, Aminus_);
+  def_array(d, stdpnames::Aplus_triplet, Aplus_triplet_);
+  def_array(d, stdpnames::Aminus_triplet, Aminus_triplet_);
+
+  def<bool>(d, names::precise_times, precise_times_);
+  def<long_t>(d, stdpnames::member, member_);
+}
+
+void stdpmodule::STDPTripletEnsemble::Parameters_::set(
+    const DictionaryDatum &d) {
+  std::vector<double_t> *arrays[] = {
+      &Wmax_,      &Wmin_,         &tau_plus_,  &tau_plus_triplet_,
+      &tau_minus_, &tau_minus_triplet_, &Aplus_, &Aminus_,
+      &Aplus_triplet_, &Aminus_triplet_};
+  const Name keys[] = {
+      stdpnames::Wmax,      stdpnames::Wmin,          stdpnames::tau_plus,
+      stdpnames::tau_plus_triplet, stdpnames::tau_minus,
+      stdpnames::tau_minus_triplet, stdpnames::Aplus, stdpnames::Aminus,
+      stdpnames::Aplus_triplet, stdpnames::Aminus_triplet};
+  const size_t n_arrays = sizeof(arrays) / sizeof(arrays[0]);
+
+  // the ensemble takes the size of the longest array given
+  size_t size = 0;
+  for (size_t i = 0; i < n_arrays; ++i) {
+    if (update_array(d, keys[i], *arrays[i])) {
+      size = std::max(size, arrays[i]->size());
+    }
+  }
+  if (size == 0) {
+    size = this->size();
+  }
+  for (size_t i = 0; i < n_arrays; ++i) {
+    fit_array(keys[i], *arrays[i], size);
+  }
+
+  updateValue<bool>(d, stdpnames::nearest_spike, nearest_spike_);
+  updateValue<bool>(d, names::precise_times, precise_times_);
+  updateValue<long_t>(d, stdpnames::member, member_);
+
+  for (size_t k = 0; k < size; ++k) {
+    if (!(Wmax_[k] >= Wmin_[k])) {
+      throw BadProperty("Parameter Wmax must be larger than or equal to Wmin.");
+    }
+  }
+
+  if (member_ < 0 or member_ >= static_cast<long_t>(size)) {
+    throw BadProperty("Parameter member must be the index of a member.");
+  }
+}
+
+/* ----------------------------------------------------------- states */
+
+stdpmodule::STDPTripletEnsemble::State_::State_()
+    : weight_(1, 5.0), Kplus_(1, 0.0), Kplus_triplet_(1, 0.0),
+      Kminus_(1, 0.0), Kminus_triplet_(1, 0.0), t_traces_(0.0) {}
+
+void stdpmodule::STDPTripletEnsemble::State_::get(DictionaryDatum &d) const {
+  def_array(d, names::weight, weight_);
+  def_array(d, stdpnames::Kplus, Kplus_);
+  def_array(d, stdpnames::Kplus_triplet, Kplus_triplet_);
+  def_array(d, stdpnames::Kminus, Kminus_);
+  def_array(d, stdpnames::Kminus_triplet, Kminus_triplet_);
+  def<long_t>(d, stdpnames::n_members, weight_.size());
+}
+
+void stdpmodule::STDPTripletEnsemble::State_::set(const DictionaryDatum &d,
+                                                  const Parameters_ &p) {
+  std::vector<double_t> *arrays[] = {&weight_, &Kplus_, &Kplus_triplet_,
+                                     &Kminus_, &Kminus_triplet_};
+  const Name keys[] = {names::weight, stdpnames::Kplus,
+                        stdpnames::Kplus_triplet, stdpnames::Kminus,
+                        stdpnames::Kminus_triplet};
+
+  for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); ++i) {
+    update_array(d, keys[i], *arrays[i]);
+    fit_array(keys[i], *arrays[i], p.size());
+
+    // traces are positive
+    for (size_t k = 0; k < p.size(); ++k) {
+      if (i > 0 and !((*arrays[i])[k] >= 0)) {
+        throw BadProperty("State " + keys[i].toString() +
+                          " must be positive.");
+      }
+    }
+  }
+}
+
+void stdpmodule::STDPTripletEnsemble::State_::decay(double_t t,
+                                                    const Parameters_ &p) {
+  const double_t elapsed = t - t_traces_;
+  if (!(elapsed > 0)) {
+    return;
+  }
+
+  const size_t n = weight_.size();
+  for (size_t k = 0; k < n; ++k) {
+    triplet_rule::decay_over(traces(k), elapsed, p.tau_plus_[k],
+                             p.tau_plus_triplet_[k], p.tau_minus_[k],
+                             p.tau_minus_triplet_[k]);
+  }
+  t_traces_ = t;
+}
+
+size_t stdpmodule::STDPTripletEnsemble::plastic_state_size() const {
+  return 5 * S_.weight_.size();
+}
+
+void stdpmodule::STDPTripletEnsemble::write_plastic_state(
+    double *values) const {
+  State_ s = S_;
+  s.decay(network()->get_time().get_ms(), P_);
+
+  const std::vector<double_t> *arrays[] = {&s.weight_, &s.Kplus_,
+                                           &s.Kplus_triplet_, &s.Kminus_,
+                                           &s.Kminus_triplet_};
+  const size_t n = s.weight_.size();
+  for (size_t i = 0; i < 5; ++i) {
+    std::copy(arrays[i]->begin(), arrays[i]->end(), values + i * n);
+  }
+}
+
+void stdpmodule::STDPTripletEnsemble::read_plastic_state(
+    const double *values) {
+  std::vector<double_t> *arrays[] = {&S_.weight_, &S_.Kplus_,
+                                     &S_.Kplus_triplet_, &S_.Kminus_,
+                                     &S_.Kminus_triplet_};
+  const size_t n = S_.weight_.size();
+  for (size_t i = 0; i < 5; ++i) {
+    std::copy(values + i * n, values + (i + 1) * n, arrays[i]->begin());
+  }
+
+  // traces were written at their time, which becomes the restore time
+  S_.t_traces_ = network()->get_time().get_ms();
+}
+
+double *stdpmodule::STDPTripletEnsemble::plastic_value(const Name &name) {
+  S_.decay(network()->get_time().get_ms(), P_);
+
+  const size_t k = P_.member_;
+  if (name == names::weight) {
+    return &S_.weight_[k];
+  }
+  if (name == stdpnames::Kplus) {
+    return &S_.Kplus_[k];
+  }
+  if (name == stdpnames::Kplus_triplet) {
+    return &S_.Kplus_triplet_[k];
+  }
+  if (name == stdpnames::Kminus) {
+    return &S_.Kminus_[k];
+  }
+  if (name == stdpnames::Kminus_triplet) {
+    return &S_.Kminus_triplet_[k];
+  }
+  return 0;
+}
+
+size_t stdpmodule::STDPTripletEnsemble::memory_size() const {
+  // ten parameter and five state arrays
+  return sizeof(STDPTripletEnsemble) +
+         15 * S_.weight_.capacity() * sizeof(double_t) +
+         B_.pre_spikes_.memory_size() + B_.post_spikes_.memory_size();
+}
+
+/* ----------------------------------------------------------- constructors */
+
+stdpmodule::STDPTripletEnsemble::STDPTripletEnsemble()
+    : Node(), P_(), S_(), B_() {
+  V_.ceiling_ = triplet_rule::ceiling(false);
+}
+
+stdpmodule::STDPTripletEnsemble::STDPTripletEnsemble(
+    const STDPTripletEnsemble &n)
+    : Node(n), P_(n.P_), S_(n.S_), B_() {
+  V_.ceiling_ = triplet_rule::ceiling(false);
+}
+
+/* ----------------------------------------------------------- initialization */
+
+void stdpmodule::STDPTripletEnsemble::init_buffers_() {
+  B_.pre_spikes_.release();
+  B_.post_spikes_.release();
+}
+
+void stdpmodule::STDPTripletEnsemble::calibrate() {
+  V_.ceiling_ = triplet_rule::ceiling(P_.nearest_spike_);
+
+  if (B_.pre_spikes_.size() == 0) {
+    B_.pre_spikes_.clear();
+    B_.post_spikes_.clear();
+  }
+}
+
+/* ----------------------------------------------------------- updates */
+
+void stdpmodule::STDPTripletEnsemble::update(Time const &origin,
+                                             const long_t from,
+                                             const long_t to) {
+  assert(to >= 0 && (delay)from < Scheduler::get_min_delay());
+  assert(from < to);
+
+  typedef PreciseSpikeRingBuffer::Spike Spike;
+
+  const size_t n = S_.weight_.size();
+  double_t *weight = &S_.weight_[0];
+  const double_t *Wmin = &P_.Wmin_[0];
+  const double_t *Wmax = &P_.Wmax_[0];
+
+  for (long_t lag = from; lag < to; ++lag) {
+
+    std::vector<Spike> &pre_spikes = B_.pre_spikes_.get_spikes(lag);
+    std::vector<Spike> &post_spikes = B_.post_spikes_.get_spikes(lag);
+    if (pre_spikes.empty() and post_spikes.empty()) {
+      continue;
+    }
+
+    std::sort(pre_spikes.begin(), pre_spikes.end(), Spike::earlier);
+    std::sort(post_spikes.begin(), post_spikes.end(), Spike::earlier);
+
+    // go through the spikes of the step in time order, pre before post at
+    // equal times, all members at once
+    const double_t end =
+        Time(Time::step(origin.get_steps() + lag + 1)).get_ms();
+
+    std::vector<Spike>::const_iterator pre = pre_spikes.begin();
+    std::vector<Spike>::const_iterator post = post_spikes.begin();
+    while (pre != pre_spikes.end() or post != post_spikes.end()) {
+
+      if (post == post_spikes.end() or
+          (pre != pre_spikes.end() and pre->offset_ >= post->offset_)) {
+
+        S_.decay(end - pre->offset_, P_);
+
+        // depress: t = t^pre
+        const double_t *Aminus = &P_.Aminus_[0];
+        const double_t *Aminus_triplet = &P_.Aminus_triplet_[0];
+        for (size_t k = 0; k < n; ++k) {
+          const double_t change = triplet_rule::on_pre(
+              S_.traces(k), Aminus[k], Aminus_triplet[k], V_.ceiling_);
+          weight[k] = triplet_rule::clamp(weight[k] + change, Wmin[k], Wmax[k]);
+        }
+
+        send_(lag, pre->multiplicity_, pre->offset_);
+        ++pre;
+
+      } else {
+
+        S_.decay(end - post->offset_, P_);
+
+        // potentiate: t = t^post
+        const double_t *Aplus = &P_.Aplus_[0];
+        const double_t *Aplus_triplet = &P_.Aplus_triplet_[0];
+        for (size_t k = 0; k < n; ++k) {
+          const double_t change = triplet_rule::on_post(
+              S_.traces(k), Aplus[k], Aplus_triplet[k], V_.ceiling_);
+          weight[k] = triplet_rule::clamp(weight[k] + change, Wmin[k], Wmax[k]);
+        }
+        ++post;
+      }
+    }
+
+    pre_spikes.clear();
+    post_spikes.clear();
+  }
+}
+
+void stdpmodule::STDPTripletEnsemble::send_(long_t lag, long_t multiplicity,
+                                            double_t offset) {
+  SpikeEvent se;
+  se.set_multiplicity(multiplicity);
+  se.set_offset(offset);
+  se.set_weight(S_.weight_[P_.member_]);
+  network()->send(*this, se, lag);
+}
+
+void stdpmodule::STDPTripletEnsemble::handle(SpikeEvent &e) {
+
+  assert(e.get_delay() > 0);
+
+  // spikes on the grid are handled at the end of their step
+  const long_t steps = e.get_rel_delivery_steps(network()->get_slice_origin());
+  const double_t offset = P_.precise_times_ ? e.get_offset() : 0.0;
+
+  switch (e.get_rport()) {
+  case 0: // PRE
+    B_.pre_spikes_.add_spike(steps, offset, e.get_multiplicity());
+    break;
+
+  case 1: // POST
+    B_.post_spikes_.add_spike(steps, offset, e.get_multiplicity());
+    break;
+
+  default:
+    break;
+  }
+}
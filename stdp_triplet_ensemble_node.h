@@ -0,0 +1,230 @@
+//
+//  stdp_triplet_ensemble_node.h
+//  NEST
+//
+//
+
+/* BeginDocumentation
+ Name: stdp_triplet_ensemble_node - stdp_triplet_node running an ensemble of
+ rule parameter sets on the same spikes.
+
+ Description:
+ stdp_triplet_ensemble_node receives pre and post-synaptic spikes as
+ stdp_triplet_node does, but advances one weight and one set of traces per
+ member of an ensemble of parameter sets, all under the same spikes. It is
+ meant for parameter sweeps, e.g. fitting the triplet rule to pairing data
+ with one node instead of one stdp_triplet_node per candidate.
+
+ Rule parameters and states are arrays with one value per member. The size
+ of the ensemble is that of the longest parameter array given, arrays of a
+ single value are repeated for all members and any other size is an error.
+ Parameters and states are kept as one array per variable (structure of
+ arrays), each spike updating all members in a single loop over the kernels
+ of stdp_triplet_rule.h.
+
+ Traces are decayed exactly on spikes only, the node forwards pre-synaptic
+ spikes with the weight of the member given by the member parameter.
+ Plasticity gating, statistics, pruning, modulation, hubs and the rate-based
+ mode of stdp_triplet_node are not available.
+
+ Parameters:
+ Wmax               double array: maximum allowed weight
+ Wmin               double array: minimum allowed weight
+ tau_plus           double array: time constant of short presynaptic trace
+ tau_plus_triplet   double array: time constant of long presynaptic trace
+ tau_minus          double array: time constant of short postsynaptic trace
+ tau_minus_triplet  double array: time constant of long postsynaptic trace
+ Aplus              double array: weight of pair potentiation rule
+ Aplus_triplet      double array: weight of triplet potentiation rule
+ Aminus             double array: weight of pair depression rule
+ Aminus_triplet     double array: weight of triplet depression rule
+ nearest_spike      bool: states saturate at 1 only taking into account
+ neighboring spikes (all members)
+ precise_times      bool: use the offsets of precise spikes (e.g. from *_ps
+ neurons) and forward them
+ member             int: member whose weight is forwarded to the
+ post-synaptic neuron
+
+ States:
+ weight             double array: synaptic weight of each member
+ Kplus              double array: pre-synaptic trace of each member
+ Kplus_triplet      double array: triplet pre-synaptic trace of each member
+ Kminus             double array: post-synaptic trace of each member
+ Kminus_triplet     double array: triplet post-synaptic trace of each member
+ n_members          int: size of the ensemble (read only)
+
+ Receives: SpikeEvent
+
+ Sends: SpikeEvent
+
+ SeeAlso: stdp_triplet_node
+ */
+
+#ifndef STDP_TRIPLET_ENSEMBLE_NODE_H
+#define STDP_TRIPLET_ENSEMBLE_NODE_H
+
+#include <vector>
+
+#include "nest.h"
+#include "event.h"
+#include "node.h"
+
+#include "plastic_node.h"
+#include "spike_ring_buffer.h"
+#include "stdp_triplet_rule.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+class STDPTripletEnsemble : public Node, public PlasticNode {
+
+public:
+  STDPTripletEnsemble();
+  STDPTripletEnsemble(const STDPTripletEnsemble &);
+
+  using Node::handle;
+  using Node::handles_test_event;
+
+  port send_test_event(Node &, rport, synindex, bool);
+  port handles_test_event(SpikeEvent &, rport);
+
+  void get_status(DictionaryDatum &) const;
+  void set_status(const DictionaryDatum &);
+
+  void handle(SpikeEvent &);
+
+  bool is_off_grid() const { return P_.precise_times_; }
+
+  /**
+   * Weights and traces of all members, the plastic value of a name is that
+   * of the forwarded member.
+   */
+  unsigned int plastic_state_version() const { return 1; }
+  size_t plastic_state_size() const;
+  void write_plastic_state(double *) const;
+  void read_plastic_state(const double *);
+  double *plastic_value(const Name &);
+  size_t memory_size() const;
+
+private:
+  void init_state_(const Node &proto) {}
+  void init_buffers_();
+  void calibrate();
+
+  void update(Time const &, const long_t, const long_t);
+
+  /**
+   * Forward pre-synaptic spikes with the weight of the forwarded member.
+   */
+  void send_(long_t lag, long_t multiplicity, double_t offset);
+
+  struct Parameters_ {
+    std::vector<double_t> Wmax_;
+    std::vector<double_t> Wmin_;
+    bool nearest_spike_;
+
+    std::vector<double_t> tau_plus_;
+    std::vector<double_t> tau_plus_triplet_;
+    std::vector<double_t> tau_minus_;
+    std::vector<double_t> tau_minus_triplet_;
+
+    std::vector<double_t> Aplus_;
+    std::vector<double_t> Aminus_;
+    std::vector<double_t> Aplus_triplet_;
+    std::vector<double_t> Aminus_triplet_;
+
+    bool precise_times_;
+    long_t member_;
+
+    Parameters_();
+    void get(DictionaryDatum &) const;
+    void set(const DictionaryDatum &);
+
+    size_t size() const { return Wmax_.size(); }
+  };
+
+  struct State_ {
+    std::vector<double_t> weight_;
+
+    std::vector<double_t> Kplus_;
+    std::vector<double_t> Kplus_triplet_;
+    std::vector<double_t> Kminus_;
+    std::vector<double_t> Kminus_triplet_;
+
+    // time the traces were decayed to (ms)
+    double_t t_traces_;
+
+    State_();
+    void get(DictionaryDatum &) const;
+
+    /**
+     * Set the states, of the size of the ensemble of the given parameters.
+     */
+    void set(const DictionaryDatum &, const Parameters_ &);
+
+    /**
+     * Decay the traces of all members up to time t (ms).
+     */
+    void decay(double_t t, const Parameters_ &);
+
+    triplet_rule::Traces traces(size_t k) {
+      return triplet_rule::Traces(Kplus_[k], Kplus_triplet_[k], Kminus_[k],
+                                  Kminus_triplet_[k]);
+    }
+  };
+
+  struct Buffers_ {
+    PreciseSpikeRingBuffer pre_spikes_;
+    PreciseSpikeRingBuffer post_spikes_;
+  };
+
+  struct Variables_ {
+    // ceiling of the traces, see triplet_rule::ceiling
+    double_t ceiling_;
+  };
+
+  Parameters_ P_;
+  State_ S_;
+  Variables_ V_;
+  Buffers_ B_;
+};
+
+inline port STDPTripletEnsemble::send_test_event(Node &target,
+                                                 rport receptor_type, synindex,
+                                                 bool) {
+  SpikeEvent e;
+  e.set_sender(*this);
+  return target.handles_test_event(e, receptor_type);
+}
+
+inline port STDPTripletEnsemble::handles_test_event(SpikeEvent &,
+                                                    rport receptor_type) {
+  // Allow connections to port 0 (pre-synaptic) and port 1 (post-synaptic)
+  if (receptor_type != 0 and receptor_type != 1) {
+    throw UnknownReceptorType(receptor_type, get_name());
+  }
+  return receptor_type;
+}
+
+inline void STDPTripletEnsemble::get_status(DictionaryDatum &d) const {
+  // traces are decayed on spikes only
+  State_ s = S_;
+  s.decay(network()->get_time().get_ms(), P_);
+
+  P_.get(d);
+  s.get(d);
+}
+
+inline void STDPTripletEnsemble::set_status(const DictionaryDatum &d) {
+  Parameters_ ptmp = P_;
+  ptmp.set(d);
+  State_ stmp = S_;
+  stmp.decay(network()->get_time().get_ms(), P_);
+  stmp.set(d, ptmp);
+
+  P_ = ptmp;
+  S_ = stmp;
+}
+}
+
+#endif // STDP_TRIPLET_ENSEMBLE_NODE_H
@@ -6,7 +6,12 @@
 
 #include "stdp_triplet_node.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "stdpnames.h"
+#include "stdp_statistics.h"
+#include "stdp_plasticity.h"
 #include "network.h"
 #include "namedatum.h"
 #include "universal_data_logger_impl.h"
@@ -17,6 +22,8 @@ using namespace nest;
 
 nest::RecordablesMap<stdpmodule::STDPTripletNeuron>
     stdpmodule::STDPTripletNeuron::recordablesMap_;
+stdpmodule::STDPStatistics::Model
+    stdpmodule::STDPTripletNeuron::stdp_model_ = 0;
 
 // Override the create() method with one call to RecordablesMap::insert_()
 // for each quantity to be recorded.
@@ -38,7 +45,11 @@ stdpmodule::STDPTripletNeuron::Parameters_::Parameters_()
     : tau_plus_(16.8), tau_plus_triplet_(101.0), tau_minus_(33.7),
       tau_minus_triplet_(125), Aplus_(0.1), Aminus_(7e-3),
       Aplus_triplet_(6.2e-3), Aminus_triplet_(2.3e-4), Wmax_(100.0), Wmin_(0.0),
-      nearest_spike_(false) {}
+      nearest_spike_(false),
+      prune_threshold_(-std::numeric_limits<double_t>::infinity()),
+      prune_time_(0.0), subsampling_(1), precise_times_(false),
+      rate_based_(false), rate_interval_(100.0), rate_tau_(1000.0),
+      region_(-1), tau_c_(1000.0), hub_(0) {}
 
 void stdpmodule::STDPTripletNeuron::Parameters_::get(DictionaryDatum &d) const {
   def<double_t>(d, stdpnames::Wmax, Wmax_);
@@ -54,6 +65,17 @@ void stdpmodule::STDPTripletNeuron::Parameters_::get(DictionaryDatum &d) const {
   def<double_t>(d, stdpnames::Aminus, Aminus_);
   def<double_t>(d, stdpnames::Aplus_triplet, Aplus_triplet_);
   def<double_t>(d, stdpnames::Aminus_triplet, Aminus_triplet_);
+
+  def<double_t>(d, stdpnames::prune_threshold, prune_threshold_);
+  def<double_t>(d, stdpnames::prune_time, prune_time_);
+  def<long_t>(d, stdpnames::plasticity_subsampling, subsampling_);
+  def<bool>(d, names::precise_times, precise_times_);
+  def<bool>(d, stdpnames::rate_based, rate_based_);
+  def<double_t>(d, stdpnames::rate_interval, rate_interval_);
+  def<double_t>(d, stdpnames::rate_tau, rate_tau_);
+  def<long_t>(d, stdpnames::region, region_);
+  def<double_t>(d, stdpnames::tau_c, tau_c_);
+  def<long_t>(d, stdpnames::hub, hub_);
 }
 
 void stdpmodule::STDPTripletNeuron::Parameters_::set(const DictionaryDatum &d) {
@@ -71,8 +93,55 @@ void stdpmodule::STDPTripletNeuron::Parameters_::set(const DictionaryDatum &d) {
   updateValue<double_t>(d, stdpnames::Aplus_triplet, Aplus_triplet_);
   updateValue<double_t>(d, stdpnames::Aminus_triplet, Aminus_triplet_);
 
+  updateValue<double_t>(d, stdpnames::prune_threshold, prune_threshold_);
+  updateValue<double_t>(d, stdpnames::prune_time, prune_time_);
+  updateValue<long_t>(d, stdpnames::plasticity_subsampling, subsampling_);
+  updateValue<bool>(d, names::precise_times, precise_times_);
+  updateValue<bool>(d, stdpnames::rate_based, rate_based_);
+  updateValue<double_t>(d, stdpnames::rate_interval, rate_interval_);
+  updateValue<double_t>(d, stdpnames::rate_tau, rate_tau_);
+  updateValue<long_t>(d, stdpnames::region, region_);
+  updateValue<double_t>(d, stdpnames::tau_c, tau_c_);
+  updateValue<long_t>(d, stdpnames::hub, hub_);
+
+  if (!(prune_time_ >= 0)) {
+    throw BadProperty("Parameter prune_time must be positive.");
+  }
+
+  if (subsampling_ < 1) {
+    throw BadProperty("Parameter plasticity_subsampling must be at least 1.");
+  }
+
   if (!(Wmax_ >= Wmin_)) {
-    throw BadProperty("State Kminus_triplet must be positive.");
+    throw BadProperty("Parameter Wmax must be larger than or equal to Wmin.");
+  }
+
+  if (!(rate_interval_ > 0)) {
+    throw BadProperty("Parameter rate_interval must be strictly positive.");
+  }
+
+  if (!(rate_tau_ > 0)) {
+    throw BadProperty("Parameter rate_tau must be strictly positive.");
+  }
+
+  if (rate_based_ and precise_times_) {
+    throw BadProperty("Parameters rate_based and precise_times are exclusive.");
+  }
+
+  if (region_ < -1) {
+    throw BadProperty("Parameter region must be positive or -1.");
+  }
+
+  if (!(tau_c_ > 0)) {
+    throw BadProperty("Parameter tau_c must be strictly positive.");
+  }
+
+  if (rate_based_ and region_ >= 0) {
+    throw BadProperty("Parameters rate_based and region are exclusive.");
+  }
+
+  if (hub_ < 0) {
+    throw BadProperty("Parameter hub must be a gid or 0.");
   }
 }
 
@@ -80,7 +149,9 @@ void stdpmodule::STDPTripletNeuron::Parameters_::set(const DictionaryDatum &d) {
 
 stdpmodule::STDPTripletNeuron::State_::State_()
     : weight_(5.0), Kplus_(0.0), Kplus_triplet_(0.0), Kminus_(0.0),
-      Kminus_triplet_(0.0) {}
+      Kminus_triplet_(0.0), t_depressed_(-1), t_traces_(-1), active_(true),
+      rate_pre_(0.0), rate_post_(0.0), rate_covariance_(0.0), n_pre_(0.0),
+      n_post_(0.0), eligibility_(0.0), modulator_(0.0), t_modulated_(0.0) {}
 
 void stdpmodule::STDPTripletNeuron::State_::get(DictionaryDatum &d) const {
   def<double_t>(d, names::weight, weight_);
@@ -88,6 +159,12 @@ void stdpmodule::STDPTripletNeuron::State_::get(DictionaryDatum &d) const {
   def<double_t>(d, stdpnames::Kplus_triplet, Kplus_triplet_);
   def<double_t>(d, stdpnames::Kminus, Kminus_);
   def<double_t>(d, stdpnames::Kminus_triplet, Kminus_triplet_);
+  def<bool>(d, stdpnames::active, active_);
+  def<double_t>(d, stdpnames::rate_pre, 1000.0 * rate_pre_);
+  def<double_t>(d, stdpnames::rate_post, 1000.0 * rate_post_);
+  def<double_t>(d, stdpnames::rate_covariance, rate_covariance_);
+  def<double_t>(d, stdpnames::eligibility, eligibility_);
+  def<double_t>(d, stdpnames::modulator, modulator_);
 }
 
 void stdpmodule::STDPTripletNeuron::State_::set(const DictionaryDatum &d) {
@@ -96,6 +173,17 @@ void stdpmodule::STDPTripletNeuron::State_::set(const DictionaryDatum &d) {
   updateValue<double_t>(d, stdpnames::Kplus_triplet, Kplus_triplet_);
   updateValue<double_t>(d, stdpnames::Kminus, Kminus_);
   updateValue<double_t>(d, stdpnames::Kminus_triplet, Kminus_triplet_);
+  updateValue<bool>(d, stdpnames::active, active_);
+
+  double_t rate_pre = 1000.0 * rate_pre_;
+  double_t rate_post = 1000.0 * rate_post_;
+  updateValue<double_t>(d, stdpnames::rate_pre, rate_pre);
+  updateValue<double_t>(d, stdpnames::rate_post, rate_post);
+  updateValue<double_t>(d, stdpnames::rate_covariance, rate_covariance_);
+  rate_pre_ = rate_pre / 1000.0;
+  rate_post_ = rate_post / 1000.0;
+  updateValue<double_t>(d, stdpnames::eligibility, eligibility_);
+  updateValue<double_t>(d, stdpnames::modulator, modulator_);
 
   if (!(Kplus_ >= 0)) {
     throw BadProperty("State Kplus must be positive.");
@@ -114,30 +202,180 @@ void stdpmodule::STDPTripletNeuron::State_::set(const DictionaryDatum &d) {
   }
 }
 
+void stdpmodule::STDPTripletNeuron::State_::decay(long_t step,
+                                                  const Parameters_ &p) {
+  if (step <= t_traces_) {
+    return;
+  }
+
+  decay_by(Time(Time::step(step - t_traces_)).get_ms(), p);
+  t_traces_ = step;
+}
+
+void stdpmodule::STDPTripletNeuron::State_::decay_by(double_t elapsed,
+                                                     const Parameters_ &p) {
+  if (elapsed == 0.0) {
+    return;
+  }
+
+  triplet_rule::decay_over(traces(), elapsed, p.tau_plus_, p.tau_plus_triplet_,
+                           p.tau_minus_, p.tau_minus_triplet_);
+}
+
+void stdpmodule::STDPTripletNeuron::State_::modulate(
+    double_t t, const Parameters_ &p, const STDPModulation::Region &region,
+    thread th) {
+  // pruned nodes do not catch up, see skip_modulation
+  if (!active_) {
+    return;
+  }
+
+  // the weight integrates the signal over learning windows only
+  while (t_modulated_ < t) {
+    double_t until;
+    const bool plastic =
+        STDPPlasticity::plastic(stdp_model_, t_modulated_, until);
+    until = std::min(until, t);
+
+    const double_t change = region.integrate(th, t_modulated_, until, p.tau_c_,
+                                             eligibility_, modulator_);
+    if (plastic) {
+      weight_ = triplet_rule::clamp(weight_ + change, p.Wmin_, p.Wmax_);
+    }
+    t_modulated_ = until;
+  }
+}
+
+void stdpmodule::STDPTripletNeuron::State_::skip_modulation(
+    double_t t, const Parameters_ &p, const STDPModulation::Region *region) {
+  const double_t elapsed = t - t_modulated_;
+  if (elapsed > 0) {
+    eligibility_ *= std::exp(-elapsed / p.tau_c_);
+    if (region != 0) {
+      modulator_ *= std::exp(-elapsed / region->tau_d_);
+    }
+  }
+  t_modulated_ = t;
+}
+
+double *stdpmodule::STDPTripletNeuron::plastic_value(const Name &name) {
+  S_.decay(network()->get_time().get_steps() - 1, P_);
+  if (V_.region_ != 0) {
+    S_.modulate(network()->get_time().get_ms(), P_, *V_.region_, get_thread());
+  }
+
+  if (name == names::weight) {
+    return &S_.weight_;
+  }
+  if (name == stdpnames::Kplus) {
+    return &S_.Kplus_;
+  }
+  if (name == stdpnames::Kplus_triplet) {
+    return &S_.Kplus_triplet_;
+  }
+  if (name == stdpnames::Kminus) {
+    return &S_.Kminus_;
+  }
+  if (name == stdpnames::Kminus_triplet) {
+    return &S_.Kminus_triplet_;
+  }
+  return 0;
+}
+
+void stdpmodule::STDPTripletNeuron::write_plastic_state(double *values) const {
+  const Time now = network()->get_time();
+  State_ s = S_;
+  s.decay(now.get_steps() - 1, P_);
+  if (!s.active_) {
+    s.skip_modulation(now.get_ms(), P_, V_.region_);
+  } else if (V_.region_ != 0) {
+    s.modulate(now.get_ms(), P_, *V_.region_, get_thread());
+  }
+
+  values[0] = s.weight_;
+  values[1] = s.Kplus_;
+  values[2] = s.Kplus_triplet_;
+  values[3] = s.Kminus_;
+  values[4] = s.Kminus_triplet_;
+  values[5] = s.active_;
+  // steps at or below the pruning threshold, -1 when above
+  values[6] = s.t_depressed_ < 0 ? -1.0 : now.get_steps() - s.t_depressed_;
+  values[7] = s.rate_pre_;
+  values[8] = s.rate_post_;
+  values[9] = s.rate_covariance_;
+  values[10] = s.n_pre_;
+  values[11] = s.n_post_;
+  values[12] = s.eligibility_;
+  values[13] = s.modulator_;
+}
+
+void stdpmodule::STDPTripletNeuron::read_plastic_state(const double *values) {
+  const Time now = network()->get_time();
+
+  S_.weight_ = values[0];
+  S_.Kplus_ = values[1];
+  S_.Kplus_triplet_ = values[2];
+  S_.Kminus_ = values[3];
+  S_.Kminus_triplet_ = values[4];
+  // buffers of revived nodes are drawn again on calibration
+  S_.active_ = values[5] != 0.0;
+  S_.t_depressed_ = values[6] < 0.0
+                        ? -1
+                        : now.get_steps() - static_cast<long_t>(values[6]);
+  S_.rate_pre_ = values[7];
+  S_.rate_post_ = values[8];
+  S_.rate_covariance_ = values[9];
+  S_.n_pre_ = values[10];
+  S_.n_post_ = values[11];
+  S_.eligibility_ = values[12];
+  S_.modulator_ = values[13];
+
+  // states were written at their time, which becomes the restore time
+  S_.t_traces_ = now.get_steps() - 1;
+  S_.t_modulated_ = now.get_ms();
+}
+
+size_t stdpmodule::STDPTripletNeuron::memory_size() const {
+  return sizeof(STDPTripletNeuron) + B_.n_pre_spikes_.memory_size() +
+         B_.n_post_spikes_.memory_size() + B_.pre_spikes_.memory_size() +
+         B_.post_spikes_.memory_size() +
+         V_.decays_.memory_size();
+}
+
 /* ----------------------------------------------------------- buffers */
 
 stdpmodule::STDPTripletNeuron::Buffers_::Buffers_(STDPTripletNeuron &n)
-    : logger_(n) {}
+    : logger_(n), t_recorded_(0) {}
 
 stdpmodule::STDPTripletNeuron::Buffers_::Buffers_(const Buffers_ &,
                                                   STDPTripletNeuron &n)
-    : logger_(n) {}
+    : logger_(n), t_recorded_(0) {}
 
 /* ----------------------------------------------------------- constructors */
 
 stdpmodule::STDPTripletNeuron::STDPTripletNeuron()
     : Archiving_Node(), P_(), S_(), B_(*this) {
   recordablesMap_.create();
+  V_.statistics_epoch_ = -1;
+  V_.region_ = 0;
+  V_.hub_ = 0;
 }
 
 stdpmodule::STDPTripletNeuron::STDPTripletNeuron(const STDPTripletNeuron &n)
-    : Archiving_Node(n), P_(n.P_), S_(n.S_), B_(n.B_, *this) {}
+    : Archiving_Node(n), P_(n.P_), S_(n.S_), B_(n.B_, *this) {
+  V_.statistics_epoch_ = -1;
+  V_.region_ = 0;
+  V_.hub_ = 0;
+}
 
 /* ----------------------------------------------------------- initialization */
 
 void stdpmodule::STDPTripletNeuron::init_buffers_() {
-  B_.n_pre_spikes_.clear();
-  B_.n_post_spikes_.clear();
+  // buffers of the spike timing in use are drawn again on calibration
+  B_.n_pre_spikes_.release();
+  B_.n_post_spikes_.release();
+  B_.pre_spikes_.release();
+  B_.post_spikes_.release();
   B_.logger_.reset();
   Archiving_Node::clear_history();
 }
@@ -147,11 +385,55 @@ void stdpmodule::STDPTripletNeuron::calibrate() {
 
   const double negative_delta = -Time::get_resolution().get_ms();
 
-  // precompute decays
-  V_.Kplus_decay_ = std::exp(negative_delta / P_.tau_plus_);
-  V_.Kplus_triplet_decay_ = std::exp(negative_delta / P_.tau_plus_triplet_);
-  V_.Kminus_decay_ = std::exp(negative_delta / P_.tau_minus_);
-  V_.Kminus_triplet_decay_ = std::exp(negative_delta / P_.tau_minus_triplet_);
+  // precompute decays over up to one subsampling bin
+  V_.subsampling_ = P_.subsampling_;
+  V_.decays_.assign(get_thread(), 4 * (V_.subsampling_ + 1));
+  for (long_t n = 0; n <= V_.subsampling_; ++n) {
+    V_.decays_[4 * n] = std::exp(n * negative_delta / P_.tau_plus_);
+    V_.decays_[4 * n + 1] = std::exp(n * negative_delta / P_.tau_plus_triplet_);
+    V_.decays_[4 * n + 2] = std::exp(n * negative_delta / P_.tau_minus_);
+    V_.decays_[4 * n + 3] =
+        std::exp(n * negative_delta / P_.tau_minus_triplet_);
+  }
+  V_.ceiling_ = triplet_rule::ceiling(P_.nearest_spike_);
+
+  V_.prune_steps_ = Time(Time::ms(P_.prune_time_)).get_steps();
+
+  V_.rate_steps_ =
+      std::max(Time(Time::ms(P_.rate_interval_)).get_steps(), (long_t)1);
+  V_.rate_decay_ =
+      std::exp(-Time(Time::step(V_.rate_steps_)).get_ms() / P_.rate_tau_);
+
+  V_.region_ = P_.region_ < 0 ? 0 : STDPModulation::region(
+                                        P_.region_, network()->get_num_threads());
+  V_.hub_ = P_.hub_ == 0 ? 0 : STDPPostHub::accumulator(P_.hub_);
+
+  // pruned nodes keep no buffers, revived ones get them back, only the
+  // buffers of the spike timing in use are kept
+  if (!S_.active_ or P_.precise_times_) {
+    B_.n_pre_spikes_.release();
+    B_.n_post_spikes_.release();
+  } else if (B_.n_pre_spikes_.size() == 0) {
+    B_.n_pre_spikes_.clear(get_thread());
+    B_.n_post_spikes_.clear(get_thread());
+  }
+
+  if (!S_.active_ or !P_.precise_times_) {
+    B_.pre_spikes_.release();
+    B_.post_spikes_.release();
+  } else if (B_.pre_spikes_.size() == 0) {
+    B_.pre_spikes_.clear();
+    B_.post_spikes_.clear();
+  }
+
+  if (!S_.active_) {
+    return;
+  }
+
+  depressed_(network()->get_time().get_steps());
+
+  STDPStatistics::enter(stdp_model_, get_thread(), V_.statistics_epoch_,
+                        S_.weight_, P_.Wmin_, P_.Wmax_);
 }
 
 /* ----------------------------------------------------------- updates */
@@ -161,62 +443,385 @@ void stdpmodule::STDPTripletNeuron::update(Time const &origin,
   assert(to >= 0 && (delay)from < Scheduler::get_min_delay());
   assert(from < to);
 
+  if (!S_.active_) {
+    return;
+  }
+
+  if (V_.hub_ != 0) {
+    receive_(origin, from, to);
+  }
+
+  // the rate-based mode gates its drift itself, the spike-based modes run the
+  // slice in segments of constant plasticity
+  if (P_.rate_based_) {
+    update_rates_(origin, from, to);
+  } else {
+    for (long_t lag = from; lag < to;) {
+      long_t until;
+      const bool plastic = STDPPlasticity::plastic_steps(
+          stdp_model_, origin.get_steps() + lag, origin.get_steps() + to,
+          until);
+
+      if (P_.precise_times_) {
+        update_precise_(origin, lag, until - origin.get_steps(), plastic);
+      } else if (plastic) {
+        update_plastic_(origin, lag, until - origin.get_steps());
+      } else {
+        update_gated_(origin, lag, until - origin.get_steps());
+      }
+      lag = until - origin.get_steps();
+    }
+  }
+
+  // modulated weights catch up on spikes, and at slice boundaries before the
+  // pulses they need are dropped
+  if (V_.region_ != 0) {
+    const double_t t = Time(Time::step(origin.get_steps() + to)).get_ms();
+    if (t - S_.t_modulated_ >= V_.region_->history_ / 2) {
+      modulate_(origin.get_steps() + to - 1, t);
+    }
+  }
+
+  // pruning happens at slice boundaries only
+  if (S_.t_depressed_ >= 0 and
+      origin.get_steps() + to - S_.t_depressed_ >= V_.prune_steps_) {
+    prune_();
+  }
+}
+
+void stdpmodule::STDPTripletNeuron::update_plastic_(Time const &origin,
+                                                    const long_t from,
+                                                    const long_t to) {
+  decay_to_(origin.get_steps() + from - 1);
+
   for (long_t lag = from; lag < to; ++lag) {
 
+    const long_t step = origin.get_steps() + lag;
     const double_t current_pre_spikes_n = B_.n_pre_spikes_.get_value(lag);
     const double_t current_post_spikes_n = B_.n_post_spikes_.get_value(lag);
 
-    // model states decay
-    S_.Kplus_ *= V_.Kplus_decay_;
-    S_.Kplus_triplet_ *= V_.Kplus_triplet_decay_;
-    S_.Kminus_ *= V_.Kminus_decay_;
-    S_.Kminus_triplet_ *= V_.Kminus_triplet_decay_;
+    // model states decay, on spikes and at the end of subsampling bins
+    if (current_pre_spikes_n > 0 or current_post_spikes_n > 0 or
+        (step + 1) % V_.subsampling_ == 0) {
+      decay_to_(step);
+    }
 
     if (current_pre_spikes_n > 0) {
 
       // depress: t = t^pre
-      S_.weight_ -=
-          S_.Kminus_ * (P_.Aminus_ + P_.Aminus_triplet_ * S_.Kplus_triplet_);
-      S_.weight_ = std::min(std::max(S_.weight_, P_.Wmin_), P_.Wmax_);
+      change_(step, 0.0, triplet_rule::on_pre(S_.traces(), P_.Aminus_,
+                                              P_.Aminus_triplet_, V_.ceiling_));
+
+      send_(step, lag, current_pre_spikes_n, 0.0);
+    }
+
+    if (current_post_spikes_n > 0) {
+
+      // potentiate: t = t^post
+      change_(step, 0.0, triplet_rule::on_post(S_.traces(), P_.Aplus_,
+                                               P_.Aplus_triplet_, V_.ceiling_));
+    }
+
+    record_(step);
+  }
+}
 
-      S_.Kplus_ += 1.0;
-      S_.Kplus_triplet_ += 1.0;
+void stdpmodule::STDPTripletNeuron::update_precise_(Time const &origin,
+                                                    const long_t from,
+                                                    const long_t to,
+                                                    bool plastic) {
+  typedef PreciseSpikeRingBuffer::Spike Spike;
 
-      if (P_.nearest_spike_) {
-        S_.Kplus_ = std::min(S_.Kplus_, 1.0);
-        S_.Kplus_triplet_ = std::min(S_.Kplus_triplet_, 1.0);
+  for (long_t lag = from; lag < to; ++lag) {
+
+    const long_t step = origin.get_steps() + lag;
+    std::vector<Spike> &pre_spikes = B_.pre_spikes_.get_spikes(lag);
+    std::vector<Spike> &post_spikes = B_.post_spikes_.get_spikes(lag);
+
+    if (pre_spikes.empty() and post_spikes.empty()) {
+      if (plastic and (step + 1) % V_.subsampling_ == 0) {
+        decay_to_(step);
       }
+      record_(step);
+      continue;
+    }
+
+    std::sort(pre_spikes.begin(), pre_spikes.end(), Spike::earlier);
+    std::sort(post_spikes.begin(), post_spikes.end(), Spike::earlier);
+
+    // go through the spikes of the step in time order, pre before post at
+    // equal times, traces decaying between their exact times
+    decay_to_(step - 1);
+    double_t offset = Time::get_resolution().get_ms();
+
+    std::vector<Spike>::const_iterator pre = pre_spikes.begin();
+    std::vector<Spike>::const_iterator post = post_spikes.begin();
+    while (pre != pre_spikes.end() or post != post_spikes.end()) {
+
+      if (post == post_spikes.end() or
+          (pre != pre_spikes.end() and pre->offset_ >= post->offset_)) {
+
+        S_.decay_by(offset - pre->offset_, P_);
+        offset = pre->offset_;
+
+        // depress: t = t^pre
+        const double_t change = triplet_rule::on_pre(
+            S_.traces(), P_.Aminus_, P_.Aminus_triplet_, V_.ceiling_);
+        if (plastic) {
+          change_(step, offset, change);
+        }
+
+        send_(step, lag, pre->multiplicity_, pre->offset_);
+        ++pre;
+
+      } else {
+
+        S_.decay_by(offset - post->offset_, P_);
+        offset = post->offset_;
+
+        // potentiate: t = t^post
+        const double_t change = triplet_rule::on_post(
+            S_.traces(), P_.Aplus_, P_.Aplus_triplet_, V_.ceiling_);
+        if (plastic) {
+          change_(step, offset, change);
+        }
+        ++post;
+      }
+    }
+
+    // traces are kept at the end of the step
+    S_.decay_by(offset, P_);
+    S_.t_traces_ = step;
+
+    pre_spikes.clear();
+    post_spikes.clear();
+
+    record_(step);
+  }
+}
+
+void stdpmodule::STDPTripletNeuron::update_rates_(Time const &origin,
+                                                  const long_t from,
+                                                  const long_t to) {
+  for (long_t lag = from; lag < to; ++lag) {
+
+    const long_t step = origin.get_steps() + lag;
+    const double_t current_pre_spikes_n = B_.n_pre_spikes_.get_value(lag);
+    const double_t current_post_spikes_n = B_.n_post_spikes_.get_value(lag);
+
+    S_.n_pre_ += current_pre_spikes_n;
+    S_.n_post_ += current_post_spikes_n;
+
+    if (current_pre_spikes_n > 0) {
+      send_(step, lag, current_pre_spikes_n, 0.0);
+    }
+
+    if ((step + 1) % V_.rate_steps_ == 0) {
+      drift_(step);
+    }
+
+    record_(step);
+  }
+}
+
+void stdpmodule::STDPTripletNeuron::drift_(long_t step) {
+  const double_t interval = Time(Time::step(V_.rate_steps_)).get_ms();
+  const double_t pre = S_.n_pre_ / interval;
+  const double_t post = S_.n_post_ / interval;
+  S_.n_pre_ = 0.0;
+  S_.n_post_ = 0.0;
+
+  const double_t decay = V_.rate_decay_;
+  S_.rate_pre_ = decay * S_.rate_pre_ + (1.0 - decay) * pre;
+  S_.rate_post_ = decay * S_.rate_post_ + (1.0 - decay) * post;
+  S_.rate_covariance_ =
+      decay * S_.rate_covariance_ +
+      (1.0 - decay) * (pre - S_.rate_pre_) * (post - S_.rate_post_) * interval;
+
+  if (!STDPPlasticity::plastic(stdp_model_,
+                               Time(Time::step(step + 1)).get_ms())) {
+    return;
+  }
+
+  // expected drift of the all-to-all rule under Poisson statistics
+  const double_t x = S_.rate_pre_;
+  const double_t y = S_.rate_post_;
+  const double_t drift =
+      x * y * (P_.Aplus_ * P_.tau_plus_ - P_.Aminus_ * P_.tau_minus_ +
+               P_.Aplus_triplet_ * P_.tau_plus_ * P_.tau_minus_triplet_ * y -
+               P_.Aminus_triplet_ * P_.tau_minus_ * P_.tau_plus_triplet_ * x) +
+      (P_.Aplus_ - P_.Aminus_) * S_.rate_covariance_ / 2.0;
+
+  const double_t weight = S_.weight_;
+  S_.weight_ += drift * interval;
+  S_.weight_ = triplet_rule::clamp(S_.weight_, P_.Wmin_, P_.Wmax_);
+  STDPStatistics::record(stdp_model_, get_thread(), V_.statistics_epoch_,
+                         weight, S_.weight_, P_.Wmin_, P_.Wmax_);
+  depressed_(step);
+}
+
+void stdpmodule::STDPTripletNeuron::change_(long_t step, double_t offset,
+                                            double_t change) {
+  if (V_.region_ != 0) {
+    modulate_(step, Time(Time::step(step + 1)).get_ms() - offset);
+    S_.eligibility_ += change;
+    return;
+  }
+
+  const double_t weight = S_.weight_;
+  S_.weight_ = triplet_rule::clamp(S_.weight_ + change, P_.Wmin_, P_.Wmax_);
+  STDPStatistics::record(stdp_model_, get_thread(), V_.statistics_epoch_,
+                         weight, S_.weight_, P_.Wmin_, P_.Wmax_);
+  depressed_(step);
+}
+
+void stdpmodule::STDPTripletNeuron::modulate_(long_t step, double_t t) {
+  const double_t weight = S_.weight_;
+  S_.modulate(t, P_, *V_.region_, get_thread());
+  STDPStatistics::record(stdp_model_, get_thread(), V_.statistics_epoch_,
+                         weight, S_.weight_, P_.Wmin_, P_.Wmax_);
+  depressed_(step);
+}
 
-      SpikeEvent se;
-      se.set_multiplicity(current_pre_spikes_n);
-      se.set_weight(S_.weight_);
-      network()->send(*this, se, lag);
+void stdpmodule::STDPTripletNeuron::decay_to_(long_t step) {
+  const long_t n = step - S_.t_traces_;
+
+  if (n <= 0) {
+    return;
+  }
+
+  if (n > V_.subsampling_) {
+    S_.decay(step, P_);
+    return;
+  }
+
+  triplet_rule::decay(S_.traces(), V_.decays_[4 * n], V_.decays_[4 * n + 1],
+                      V_.decays_[4 * n + 2], V_.decays_[4 * n + 3]);
+  S_.t_traces_ = step;
+}
+
+void stdpmodule::STDPTripletNeuron::record_(long_t step) {
+  B_.t_recorded_ = step;
+  B_.logger_.record_data(step);
+}
+
+double_t stdpmodule::STDPTripletNeuron::recorded_trace_(double_t trace,
+                                                        double_t tau) const {
+  const long_t n = B_.t_recorded_ - S_.t_traces_;
+  if (n <= 0) {
+    return trace;
+  }
+  return trace * std::exp(-Time(Time::step(n)).get_ms() / tau);
+}
+
+void stdpmodule::STDPTripletNeuron::update_gated_(Time const &origin,
+                                                  const long_t from,
+                                                  const long_t to) {
+  for (long_t lag = from; lag < to; ++lag) {
+
+    const double_t current_pre_spikes_n = B_.n_pre_spikes_.get_value(lag);
+    const double_t current_post_spikes_n = B_.n_post_spikes_.get_value(lag);
+
+    // traces follow spikes, weight is left as is
+    if (current_pre_spikes_n > 0) {
+      S_.decay(origin.get_steps() + lag, P_);
+      triplet_rule::on_pre(S_.traces(), P_.Aminus_, P_.Aminus_triplet_,
+                           V_.ceiling_);
+
+      send_(origin.get_steps() + lag, lag, current_pre_spikes_n, 0.0);
     }
 
     if (current_post_spikes_n > 0) {
+      S_.decay(origin.get_steps() + lag, P_);
+      triplet_rule::on_post(S_.traces(), P_.Aplus_, P_.Aplus_triplet_,
+                            V_.ceiling_);
+    }
 
-      // potentiate: t = t^post
-      S_.weight_ +=
-          S_.Kplus_ * (P_.Aplus_ + P_.Aplus_triplet_ * S_.Kminus_triplet_);
-      S_.weight_ = std::min(std::max(S_.weight_, P_.Wmin_), P_.Wmax_);
+    record_(origin.get_steps() + lag);
+  }
+}
 
-      S_.Kminus_ += 1.0;
-      S_.Kminus_triplet_ += 1.0;
+void stdpmodule::STDPTripletNeuron::receive_(Time const &origin,
+                                             const long_t from,
+                                             const long_t to) {
+  for (long_t lag = from; lag < to; ++lag) {
+    const double_t n = V_.hub_->post_spikes(origin.get_steps() + lag);
+    if (n == 0.0) {
+      continue;
+    }
 
-      if (P_.nearest_spike_) {
-        S_.Kminus_ = std::min(S_.Kminus_, 1.0);
-        S_.Kminus_triplet_ = std::min(S_.Kminus_triplet_, 1.0);
-      }
+    if (P_.precise_times_) {
+      B_.post_spikes_.add_spike(lag, 0.0, n);
+    } else {
+      B_.n_post_spikes_.add_value(lag, n);
     }
+  }
+}
 
-    B_.logger_.record_data(origin.get_steps() + lag);
+void stdpmodule::STDPTripletNeuron::send_(long_t step, long_t lag,
+                                          long_t multiplicity,
+                                          double_t offset) {
+  if (V_.hub_ != 0) {
+    V_.hub_->add(get_thread(), step, S_.weight_ * multiplicity);
+    return;
   }
+
+  SpikeEvent se;
+  se.set_multiplicity(multiplicity);
+  se.set_offset(offset);
+  se.set_weight(S_.weight_);
+  network()->send(*this, se, lag);
+}
+
+void stdpmodule::STDPTripletNeuron::depressed_(long_t step) {
+  if (S_.weight_ > P_.prune_threshold_) {
+    S_.t_depressed_ = -1;
+  } else if (S_.t_depressed_ < 0) {
+    S_.t_depressed_ = step;
+  }
+}
+
+void stdpmodule::STDPTripletNeuron::prune_() {
+  S_.active_ = false;
+  S_.t_depressed_ = -1;
+
+  STDPStatistics::prune(stdp_model_, get_thread(), V_.statistics_epoch_,
+                        S_.weight_, P_.Wmin_, P_.Wmax_);
+
+  B_.n_pre_spikes_.release();
+  B_.n_post_spikes_.release();
+  B_.pre_spikes_.release();
+  B_.post_spikes_.release();
+  Archiving_Node::clear_history();
 }
 
 void stdpmodule::STDPTripletNeuron::handle(SpikeEvent &e) {
 
   assert(e.get_delay() > 0);
 
+  if (!S_.active_) {
+    return;
+  }
+
+  if (P_.precise_times_) {
+    const long_t steps =
+        e.get_rel_delivery_steps(network()->get_slice_origin());
+
+    switch (e.get_rport()) {
+    case 0: // PRE
+      B_.pre_spikes_.add_spike(steps, e.get_offset(), e.get_multiplicity());
+      break;
+
+    case 1: // POST
+      B_.post_spikes_.add_spike(steps, e.get_offset(), e.get_multiplicity());
+      break;
+
+    default:
+      break;
+    }
+    return;
+  }
+
   switch (e.get_rport()) {
   case 0: // PRE
     B_.n_pre_spikes_.add_value(
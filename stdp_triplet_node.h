@@ -37,6 +37,28 @@ neareat_spike		bool: states saturate at 1 only taking into account
  Aminus             double: weight of pair depression rule (A_minus_2 of [1])
  Aminus_triplet     double: weight of triplet depression rule (A_minus_3 of [1])
 
+ prune_threshold    double: weight at or below which the synapse is depressed
+ (pruning is disabled by default)
+ prune_time         double: time the synapse must stay depressed before it is
+ pruned (ms)
+ plasticity_subsampling  int: traces are brought up to date every
+ plasticity_subsampling steps and on spikes only, with their exact decay
+ (recorded traces are decayed to each recorded step)
+ precise_times      bool: use the offsets of precise spikes (e.g. from *_ps
+ neurons) and forward them, traces then decay between exact spike times
+ rate_based         bool: apply the expected drift of the rule from rate
+ estimates instead of the spike-pair rule (exclusive with precise_times)
+ rate_interval      double: update grid of the rate-based mode (ms)
+ rate_tau           double: time constant of the rate and covariance
+ estimates (ms)
+ region             int: neuromodulator region gating the weight (see
+ stdp_modulation), -1 (default) for unmodulated plasticity
+ tau_c              double: time constant of the eligibility trace (ms)
+ hub                int: gid of a stdp_post_hub summing the output of the
+ node with that of the other nodes of its post-synaptic neuron and sharing
+ the spikes of that neuron, 0 (default) to send and receive spikes through
+ the node's own connections
+
  Notes about delay:
  This model does not have any delay parameter as both axonal and dendritic
  delays are repectively taken into account by pre-synpatic and post-synaptic
@@ -53,6 +75,34 @@ neareat_spike		bool: states saturate at 1 only taking into account
  concentration...) (o_1 of [1])
  Kminus_triplet		double: triplet post-synaptic trace (e.g. number of
  secondary messengers...) (o_2 of [1])
+ active             bool: false once pruned, the node then ignores its input,
+ stops updating and releases its buffers (set it back to true to revive it)
+ rate_pre           double: pre-synaptic rate estimate (Hz)
+ rate_post          double: post-synaptic rate estimate (Hz)
+ rate_covariance    double: covariance of pre- and post-synaptic spike counts
+ over rate_interval divided by it, i.e. the integral of the cross-covariance
+ function for correlations shorter than rate_interval (1/ms)
+ eligibility        double: eligibility trace of the modulated mode
+ modulator          double: level of the neuromodulator signal of the region
+
+ Notes about the rate-based mode:
+ Pre-synaptic spikes are still forwarded, but traces are not maintained. Every
+ rate_interval the weight follows the expected drift of the all-to-all rule
+ under Poisson statistics [3],
+ rate_pre * rate_post * (Aplus * tau_plus - Aminus * tau_minus
+ + Aplus_triplet * tau_plus * tau_minus_triplet * rate_post
+ - Aminus_triplet * tau_minus * tau_plus_triplet * rate_pre)
+ + (Aplus - Aminus) * rate_covariance / 2,
+ the covariance term assuming symmetric correlations much shorter than the
+ time constants. See benchmarks/rate_error.py for its error against the
+ exact rule.
+
+ Notes about the modulated mode:
+ With a region, changes of the rule feed the eligibility trace instead of the
+ weight, and the weight follows eligibility * (modulator - baseline) of the
+ region. Eligibility, modulator and weight are caught up lazily, on spikes,
+ when read and at least every history / 2 of the region, the recorded weight
+ only changes then. The modulated mode excludes the rate-based one.
 
  Receives: SpikeEvent, DataLoggingRequest
 
@@ -63,28 +113,41 @@ neareat_spike		bool: states saturate at 1 only taking into account
  of Spike Timing-Dependent Plasticity.  The Journal of Neuroscience
  26(38):9673-9682; doi:10.1523/JNEUROSCI.1425-06.2006
  [2] stdp_triplet_connection.h
+ [3] J.-P. Pfister & W. Gerstner (2006), Eq. (4) and following
+ [4] E. M. Izhikevich (2007) Solving the Distal Reward Problem through
+ Linkage of STDP and Dopamine Signaling. Cerebral Cortex 17(10):2443-2452;
+ doi:10.1093/cercor/bhl152
 
  FirstVersion: Octo 2015
  Author: Alexander Seeholzer, Teo Stocco
- SeeAlso: synapsedict, stdp_synapse, static_synapse
+ SeeAlso: synapsedict, stdp_synapse, static_synapse, stdp_plasticity,
+ stdp_modulation, stdp_modulator, stdp_post_hub
  */
 
 #ifndef STDP_TRIPLET_NEURON_H
 #define STDP_TRIPLET_NEURON_H
 
+#include <vector>
+
 #include "nest.h"
 #include "event.h"
 #include "archiving_node.h"
-#include "ring_buffer.h"
 #include "namedatum.h"
 #include "universal_data_logger.h"
 
+#include "plastic_node.h"
+#include "spike_ring_buffer.h"
+#include "stdp_statistics.h"
+#include "stdp_modulation.h"
+#include "stdp_post_hub.h"
+#include "stdp_triplet_rule.h"
+
 namespace stdpmodule {
 using namespace nest;
 
 class Network;
 
-class STDPTripletNeuron : public Archiving_Node {
+class STDPTripletNeuron : public Archiving_Node, public PlasticNode {
 
 public:
   STDPTripletNeuron();
@@ -103,12 +166,85 @@ public:
   void handle(SpikeEvent &);
   void handle(DataLoggingRequest &);
 
+  bool is_off_grid() const { return P_.precise_times_; }
+
+  unsigned int plastic_state_version() const { return 1; }
+  size_t plastic_state_size() const { return 14; }
+  void write_plastic_state(double *) const;
+  void read_plastic_state(const double *);
+  double *plastic_value(const Name &);
+  size_t memory_size() const;
+
+  /**
+   * Register the model under its kernel name, for statistics, plasticity
+   * schedules and pruning counts.
+   */
+  static void register_stdp_model(const std::string &name) {
+    stdp_model_ = STDPStatistics::register_model(name);
+  }
+
 private:
   void init_state_(const Node &proto) {}
   void init_buffers_();
   void calibrate();
 
   void update(Time const &, const long_t, const long_t);
+  void update_plastic_(Time const &, const long_t, const long_t);
+  void update_gated_(Time const &, const long_t, const long_t);
+  void update_precise_(Time const &, const long_t, const long_t, bool);
+  void update_rates_(Time const &, const long_t, const long_t);
+
+  /**
+   * Update the rate estimates from the spikes of the last interval and apply
+   * the expected drift of the rule over it.
+   */
+  void drift_(long_t step);
+
+  /**
+   * Apply a change of the rule at the given step and offset (ms), to the
+   * weight or to the eligibility trace when modulated.
+   */
+  void change_(long_t step, double_t offset, double_t change);
+
+  /**
+   * Catch the modulated weight up to time t (ms).
+   */
+  void modulate_(long_t step, double_t t);
+
+  /**
+   * Decay the traces up to the given step from the table of decays.
+   */
+  void decay_to_(long_t step);
+
+  /**
+   * Record the given step, traces are read decayed to it (see
+   * recorded_trace_).
+   */
+  void record_(long_t step);
+
+  /**
+   * Value of a trace decaying with tau (ms) at the recorded step, traces are
+   * only brought up to date at the end of subsampling bins and on spikes.
+   */
+  double_t recorded_trace_(double_t trace, double_t tau) const;
+
+  /**
+   * Add the post-synaptic spikes shared by the hub to the buffers of the
+   * slice.
+   */
+  void receive_(Time const &, const long_t, const long_t);
+
+  /**
+   * Forward pre-synaptic spikes of the given step with the weight, to the
+   * post-synaptic neuron or to the accumulator of the hub.
+   */
+  void send_(long_t step, long_t lag, long_t multiplicity, double_t offset);
+
+  /**
+   * Track since when the weight is at or below the pruning threshold.
+   */
+  void depressed_(long_t step);
+  void prune_();
 
   friend class RecordablesMap<STDPTripletNeuron>;
   friend class UniversalDataLogger<STDPTripletNeuron>;
@@ -128,6 +264,21 @@ private:
     double_t Aplus_triplet_;
     double_t Aminus_triplet_;
 
+    double_t prune_threshold_;
+    double_t prune_time_;
+
+    long_t subsampling_;
+    bool precise_times_;
+
+    bool rate_based_;
+    double_t rate_interval_;
+    double_t rate_tau_;
+
+    long_t region_;
+    double_t tau_c_;
+
+    long_t hub_;
+
     Parameters_();
     void get(DictionaryDatum &) const;
     void set(const DictionaryDatum &);
@@ -141,33 +292,107 @@ private:
     double_t Kminus_;
     double_t Kminus_triplet_;
 
+    long_t t_depressed_;
+    long_t t_traces_;
+    bool active_;
+
+    // rate estimates (1/ms) and spike counts of the current interval
+    double_t rate_pre_;
+    double_t rate_post_;
+    double_t rate_covariance_;
+    double_t n_pre_;
+    double_t n_post_;
+
+    // eligibility and level of the modulator signal at t_modulated_ (ms)
+    double_t eligibility_;
+    double_t modulator_;
+    double_t t_modulated_;
+
     State_();
     void get(DictionaryDatum &) const;
     void set(const DictionaryDatum &);
+
+    /**
+     * Decay the traces up to the given step, once they lag behind.
+     */
+    void decay(long_t step, const Parameters_ &);
+
+    /**
+     * Decay the traces over the given time (ms).
+     */
+    void decay_by(double_t elapsed, const Parameters_ &);
+
+    triplet_rule::Traces traces() {
+      return triplet_rule::Traces(Kplus_, Kplus_triplet_, Kminus_,
+                                  Kminus_triplet_);
+    }
+
+    /**
+     * Catch eligibility, modulator and weight up to time t (ms) from the
+     * pulses of the given thread, the weight only changing while plastic and
+     * active.
+     */
+    void modulate(double_t t, const Parameters_ &,
+                  const STDPModulation::Region &, thread);
+
+    /**
+     * Move t_modulated_ to time t (ms) without the pulses in between, which
+     * may be trimmed already, eligibility and modulator only decaying.
+     */
+    void skip_modulation(double_t t, const Parameters_ &,
+                         const STDPModulation::Region *);
   };
 
   struct Buffers_ {
-    RingBuffer n_pre_spikes_;
-    RingBuffer n_post_spikes_;
+    SpikeRingBuffer n_pre_spikes_;
+    SpikeRingBuffer n_post_spikes_;
+    PreciseSpikeRingBuffer pre_spikes_;
+    PreciseSpikeRingBuffer post_spikes_;
     UniversalDataLogger<STDPTripletNeuron> logger_;
+    // step being recorded
+    long_t t_recorded_;
 
     Buffers_(STDPTripletNeuron &);
     Buffers_(const Buffers_ &, STDPTripletNeuron &);
   };
 
   struct Variables_ {
-    double_t Kplus_decay_;
-    double_t Kplus_triplet_decay_;
-    double_t Kminus_decay_;
-    double_t Kminus_triplet_decay_;
+    long_t subsampling_;
+    // decays of Kplus, Kplus_triplet, Kminus and Kminus_triplet over 0 to
+    // subsampling steps
+    ArenaArray decays_;
+    // ceiling of the traces, see triplet_rule::ceiling
+    double_t ceiling_;
+
+    long_t prune_steps_;
+    long_t statistics_epoch_;
+
+    long_t rate_steps_;
+    // decay of the rate estimates over one interval
+    double_t rate_decay_;
+
+    // region of the modulated mode, 0 when unmodulated
+    STDPModulation::Region *region_;
+
+    // accumulator of the hub, 0 when spikes are sent to the post-synaptic
+    // neuron
+    STDPPostHub::Accumulator *hub_;
   };
 
   // Access functions for UniversalDataLogger
   double_t get_weight_() const { return S_.weight_; }
-  double_t get_Kplus_() const { return S_.Kplus_; }
-  double_t get_Kplus_triplet_() const { return S_.Kplus_triplet_; }
-  double_t get_Kminus_() const { return S_.Kminus_; }
-  double_t get_Kminus_triplet_() const { return S_.Kminus_triplet_; }
+  double_t get_Kplus_() const {
+    return recorded_trace_(S_.Kplus_, P_.tau_plus_);
+  }
+  double_t get_Kplus_triplet_() const {
+    return recorded_trace_(S_.Kplus_triplet_, P_.tau_plus_triplet_);
+  }
+  double_t get_Kminus_() const {
+    return recorded_trace_(S_.Kminus_, P_.tau_minus_);
+  }
+  double_t get_Kminus_triplet_() const {
+    return recorded_trace_(S_.Kminus_triplet_, P_.tau_minus_triplet_);
+  }
 
   Parameters_ P_;
   State_ S_;
@@ -175,6 +400,7 @@ private:
   Buffers_ B_;
 
   static RecordablesMap<STDPTripletNeuron> recordablesMap_;
+  static STDPStatistics::Model stdp_model_;
 };
 
 inline port STDPTripletNeuron::send_test_event(Node &target,
@@ -203,15 +429,38 @@ inline port STDPTripletNeuron::handles_test_event(DataLoggingRequest &dlr,
 }
 
 inline void STDPTripletNeuron::get_status(DictionaryDatum &d) const {
+  // traces are not decayed while not plastic
+  State_ s = S_;
+  s.decay(network()->get_time().get_steps() - 1, P_);
+  if (V_.region_ != 0) {
+    s.modulate(network()->get_time().get_ms(), P_, *V_.region_, get_thread());
+  }
+
   P_.get(d);
-  S_.get(d);
+  s.get(d);
   Archiving_Node::get_status(d);
   (*d)[names::recordables] = recordablesMap_.get_list();
 }
 
 inline void STDPTripletNeuron::set_status(const DictionaryDatum &d) {
+  S_.decay(network()->get_time().get_steps() - 1, P_);
+  if (V_.region_ != 0) {
+    S_.modulate(network()->get_time().get_ms(), P_, *V_.region_, get_thread());
+  }
+  const long_t region = P_.region_;
+  const bool active = S_.active_;
   P_.set(d);
   S_.set(d);
+
+  // a revived node did not catch up while pruned
+  if (!active and S_.active_) {
+    S_.skip_modulation(network()->get_time().get_ms(), P_, V_.region_);
+  }
+
+  // the new region is looked up at calibration
+  if (P_.region_ != region) {
+    V_.region_ = 0;
+  }
   Archiving_Node::set_status(d);
 }
 }
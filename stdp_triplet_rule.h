@@ -0,0 +1,107 @@
+//
+//  stdp_triplet_rule.h
+//  NEST
+//
+//
+
+#ifndef STDP_TRIPLET_RULE_H
+#define STDP_TRIPLET_RULE_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace stdpmodule {
+
+/**
+ * Kernels of the triplet rule (Pfister & Gerstner 2006), shared by
+ * stdp_triplet_node and stdp_triplet_all_in_one_synapse. They only depend on
+ * the four traces and the parameters of a synapse, wherever the model stores
+ * them, so that both models run the same code and the kernels can be timed
+ * without the simulation kernel.
+ */
+namespace triplet_rule {
+
+typedef double double_t;
+
+/**
+ * Traces of a synapse, referred to in place.
+ */
+struct Traces {
+  double_t &Kplus_;
+  double_t &Kplus_triplet_;
+  double_t &Kminus_;
+  double_t &Kminus_triplet_;
+
+  Traces(double_t &Kplus, double_t &Kplus_triplet, double_t &Kminus,
+         double_t &Kminus_triplet)
+      : Kplus_(Kplus), Kplus_triplet_(Kplus_triplet), Kminus_(Kminus),
+        Kminus_triplet_(Kminus_triplet) {}
+};
+
+/**
+ * Ceiling of the traces: 1 if only the nearest spike counts, none otherwise.
+ */
+inline double_t ceiling(bool nearest_spike) {
+  return nearest_spike ? 1.0 : std::numeric_limits<double_t>::infinity();
+}
+
+/**
+ * Decay of the traces by one factor each, e.g. taken from a table.
+ */
+inline void decay(Traces k, double_t plus, double_t plus_triplet,
+                  double_t minus, double_t minus_triplet) {
+  k.Kplus_ *= plus;
+  k.Kplus_triplet_ *= plus_triplet;
+  k.Kminus_ *= minus;
+  k.Kminus_triplet_ *= minus_triplet;
+}
+
+/**
+ * Decay of the traces over an interval (ms).
+ */
+inline void decay_over(Traces k, double_t interval, double_t tau_plus,
+                       double_t tau_plus_triplet, double_t tau_minus,
+                       double_t tau_minus_triplet) {
+  decay(k, std::exp(-interval / tau_plus),
+        std::exp(-interval / tau_plus_triplet),
+        std::exp(-interval / tau_minus),
+        std::exp(-interval / tau_minus_triplet));
+}
+
+/**
+ * Pre-synaptic spike: returns the weight change (depression) and increments
+ * the pre-synaptic traces up to the ceiling.
+ */
+inline double_t on_pre(Traces k, double_t Aminus, double_t Aminus_triplet,
+                       double_t ceiling) {
+  const double_t change =
+      -k.Kminus_ * (Aminus + Aminus_triplet * k.Kplus_triplet_);
+  k.Kplus_ = std::min(k.Kplus_ + 1.0, ceiling);
+  k.Kplus_triplet_ = std::min(k.Kplus_triplet_ + 1.0, ceiling);
+  return change;
+}
+
+/**
+ * Post-synaptic spike: returns the weight change (potentiation) and
+ * increments the post-synaptic traces up to the ceiling.
+ */
+inline double_t on_post(Traces k, double_t Aplus, double_t Aplus_triplet,
+                        double_t ceiling) {
+  const double_t change =
+      k.Kplus_ * (Aplus + Aplus_triplet * k.Kminus_triplet_);
+  k.Kminus_ = std::min(k.Kminus_ + 1.0, ceiling);
+  k.Kminus_triplet_ = std::min(k.Kminus_triplet_ + 1.0, ceiling);
+  return change;
+}
+
+/**
+ * Weight kept within its bounds.
+ */
+inline double_t clamp(double_t w, double_t Wmin, double_t Wmax) {
+  return std::min(std::max(w, Wmin), Wmax);
+}
+}
+}
+
+#endif /* STDP_TRIPLET_RULE_H */
@@ -0,0 +1,344 @@
+//
+//  stdp_weight_snapshot.cpp
+//  NEST
+//
+//
+
+#include "stdp_weight_snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "stdpnames.h"
+#include "plastic_node.h"
+#include "network.h"
+#include "nestmodule.h"
+#include "communicator.h"
+#include "dictutils.h"
+#include "exceptions.h"
+#include "sliexceptions.h"
+
+using namespace nest;
+
+namespace {
+
+const char magic[8] = {'S', 'T', 'D', 'P', 'S', 'N', 'A', 'P'};
+const unsigned int version = 1;
+
+// slot index of connections beyond the capacity
+const long_t dropped = 0xffffffffL;
+
+struct Header {
+  char magic_[8];
+  unsigned int version_;
+  unsigned int rank_;
+  unsigned int n_threads_;
+  unsigned int padding_;
+  unsigned long capacity_;
+  unsigned long reserved_[4];
+};
+
+struct SectionHeader {
+  unsigned long sequence_;
+  double time_;
+  unsigned long n_;
+  unsigned long active_;
+  unsigned long n_dropped_;
+  unsigned long reserved_[3];
+};
+
+struct Key {
+  unsigned long source_;
+  unsigned long target_;
+};
+
+size_t section_size(size_t capacity) {
+  return sizeof(SectionHeader) + capacity * (sizeof(Key) + 2 * sizeof(double));
+}
+}
+
+std::vector<stdpmodule::STDPWeightSnapshot::Section_>
+    stdpmodule::STDPWeightSnapshot::sections_;
+char *stdpmodule::STDPWeightSnapshot::data_ = 0;
+size_t stdpmodule::STDPWeightSnapshot::size_ = 0;
+std::string stdpmodule::STDPWeightSnapshot::filename_;
+size_t stdpmodule::STDPWeightSnapshot::capacity_ = 0;
+
+/* ----------------------------------------------------------- parameters */
+
+stdpmodule::STDPWeightSnapshot::Parameters_::Parameters_()
+    : prefix_("/dev/shm/stdp_weights"), interval_(100.0), capacity_(100000) {}
+
+void stdpmodule::STDPWeightSnapshot::Parameters_::get(
+    DictionaryDatum &d) const {
+  def<std::string>(d, stdpnames::prefix, prefix_);
+  def<double_t>(d, stdpnames::interval, interval_);
+  def<long_t>(d, stdpnames::capacity, capacity_);
+}
+
+void stdpmodule::STDPWeightSnapshot::Parameters_::set(
+    const DictionaryDatum &d) {
+  updateValue<std::string>(d, stdpnames::prefix, prefix_);
+  updateValue<double_t>(d, stdpnames::interval, interval_);
+  updateValue<long_t>(d, stdpnames::capacity, capacity_);
+
+  if (prefix_.empty()) {
+    throw BadProperty("Parameter prefix must not be empty.");
+  }
+
+  if (!(interval_ > 0)) {
+    throw BadProperty("Parameter interval must be strictly positive.");
+  }
+
+  if (capacity_ <= 0 or capacity_ >= dropped) {
+    throw BadProperty("Parameter capacity must be strictly positive and "
+                      "below 2^32 - 1.");
+  }
+}
+
+/* ----------------------------------------------------------- states */
+
+stdpmodule::STDPWeightSnapshot::State_::State_() : n_snapshots_(0) {}
+
+void stdpmodule::STDPWeightSnapshot::State_::get(DictionaryDatum &d) const {
+  def<long_t>(d, stdpnames::n_snapshots, n_snapshots_);
+}
+
+stdpmodule::STDPWeightSnapshot::Section_::Section_()
+    : owner_(0), epoch_(0), n_dropped_(0), scanned_(1), weights_(), nodes_() {}
+
+/* ----------------------------------------------------------- constructors */
+
+stdpmodule::STDPWeightSnapshot::STDPWeightSnapshot() : Node(), P_(), S_() {
+  B_.next_ = 0;
+}
+
+stdpmodule::STDPWeightSnapshot::STDPWeightSnapshot(
+    const STDPWeightSnapshot &n)
+    : Node(n), P_(n.P_), S_(n.S_) {
+  B_.next_ = 0;
+}
+
+stdpmodule::STDPWeightSnapshot::~STDPWeightSnapshot() {
+  const size_t t = get_thread();
+  if (t >= sections_.size() or sections_[t].owner_ != this) {
+    return;
+  }
+
+  sections_[t].owner_ = 0;
+  for (size_t i = 0; i < sections_.size(); ++i) {
+    if (sections_[i].owner_ != 0) {
+      return;
+    }
+  }
+  unmap_();
+}
+
+void stdpmodule::STDPWeightSnapshot::get_status(DictionaryDatum &d) const {
+  P_.get(d);
+  S_.get(d);
+
+  const size_t t = get_thread();
+  const bool owner = t < sections_.size() and sections_[t].owner_ == this;
+  def<long_t>(d, stdpnames::n_synapses,
+              owner ? sections_[t].weights_.size() : 0);
+  def<long_t>(d, stdpnames::n_dropped, owner ? sections_[t].n_dropped_ : 0);
+}
+
+void stdpmodule::STDPWeightSnapshot::set_status(const DictionaryDatum &d) {
+  Parameters_ ptmp = P_;
+  ptmp.set(d);
+  P_ = ptmp;
+}
+
+/* ----------------------------------------------------------- shared memory */
+
+void stdpmodule::STDPWeightSnapshot::map_(const std::string &filename,
+                                          size_t capacity, thread n_threads) {
+  unmap_();
+
+  const int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    throw IOError();
+  }
+
+  const size_t size = sizeof(Header) + n_threads * section_size(capacity);
+  if (ftruncate(fd, size) != 0) {
+    close(fd);
+    throw IOError();
+  }
+
+  void *mapped = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    throw IOError();
+  }
+
+  data_ = static_cast<char *>(mapped);
+  size_ = size;
+  filename_ = filename;
+  capacity_ = capacity;
+
+  // the file is zero-filled, readers wait for the magic
+  Header *header = reinterpret_cast<Header *>(data_);
+  header->version_ = version;
+  header->rank_ = Communicator::get_rank();
+  header->n_threads_ = n_threads;
+  header->capacity_ = capacity;
+  __sync_synchronize();
+  std::memcpy(header->magic_, magic, sizeof(magic));
+
+  // slots given before are stale
+  sections_.resize(n_threads);
+  for (size_t t = 0; t < sections_.size(); ++t) {
+    Section_ &section = sections_[t];
+    ++section.epoch_;
+    section.n_dropped_ = 0;
+    section.scanned_ = 1;
+    section.weights_.clear();
+    section.nodes_.clear();
+  }
+}
+
+void stdpmodule::STDPWeightSnapshot::unmap_() {
+  if (data_ != 0) {
+    munmap(data_, size_);
+  }
+  data_ = 0;
+  size_ = 0;
+}
+
+long_t stdpmodule::STDPWeightSnapshot::assign_(thread t,
+                                              nest::index source,
+                                              nest::index target) {
+  Section_ &section = sections_[t];
+  const size_t i = section.weights_.size();
+  if (i >= capacity_) {
+    ++section.n_dropped_;
+    return section.epoch_ << 32 | dropped;
+  }
+
+  // keys of a slot are read once the slot is published
+  Key *keys = reinterpret_cast<Key *>(data_ + sizeof(Header) +
+                                      t * section_size(capacity_) +
+                                      sizeof(SectionHeader));
+  keys[i].source_ = source;
+  keys[i].target_ = target;
+  section.weights_.push_back(0.0);
+
+  return section.epoch_ << 32 | i;
+}
+
+void stdpmodule::STDPWeightSnapshot::scan_(thread t) {
+  Network &net = nest::NestModule::get_network();
+  Section_ &section = sections_[t];
+
+  // nodes are only ever added, those of lower gids are known
+  for (nest::index gid = section.scanned_; gid < net.size(); ++gid) {
+    if (!net.is_local_gid(gid)) {
+      continue;
+    }
+
+    Node *node = net.get_node(gid, t);
+    if (node->is_proxy() or node->get_thread() != t) {
+      continue;
+    }
+
+    PlasticNode *plastic = dynamic_cast<PlasticNode *>(node);
+    const double_t *weight =
+        plastic == 0 ? 0 : plastic->plastic_value(names::weight);
+    if (weight == 0) {
+      continue;
+    }
+
+    const size_t i = assign_(t, gid, 0) & dropped;
+    if (i < section.weights_.size()) {
+      section.nodes_.push_back(std::make_pair(i, weight));
+    }
+  }
+  section.scanned_ = net.size();
+}
+
+void stdpmodule::STDPWeightSnapshot::publish_(thread t, double_t time) {
+  Section_ &section = sections_[t];
+  for (size_t i = 0; i < section.nodes_.size(); ++i) {
+    section.weights_[section.nodes_[i].first] = *section.nodes_[i].second;
+  }
+
+  char *base = data_ + sizeof(Header) + t * section_size(capacity_);
+  volatile SectionHeader *header = reinterpret_cast<SectionHeader *>(base);
+  double *buffers = reinterpret_cast<double *>(base + sizeof(SectionHeader) +
+                                               capacity_ * sizeof(Key));
+
+  // readers copy the active buffer, the other one is free
+  const unsigned long buffer = 1 - header->active_;
+  if (!section.weights_.empty()) {
+    std::memcpy(buffers + buffer * capacity_, &section.weights_[0],
+                section.weights_.size() * sizeof(double));
+  }
+
+  __sync_synchronize();
+  ++header->sequence_;
+  __sync_synchronize();
+  header->active_ = buffer;
+  header->n_ = section.weights_.size();
+  header->time_ = time;
+  header->n_dropped_ = section.n_dropped_;
+  __sync_synchronize();
+  ++header->sequence_;
+}
+
+/* ----------------------------------------------------------- initialization */
+
+void stdpmodule::STDPWeightSnapshot::init_state_(const Node &proto) {
+  const STDPWeightSnapshot &pr = downcast<STDPWeightSnapshot>(proto);
+  S_ = pr.S_;
+}
+
+void stdpmodule::STDPWeightSnapshot::init_buffers_() { B_.next_ = 0; }
+
+void stdpmodule::STDPWeightSnapshot::calibrate() {
+  V_.interval_steps_ =
+      std::max(Time(Time::ms(P_.interval_)).get_steps(), (long_t)1);
+
+  std::ostringstream filename;
+  filename << P_.prefix_ << "." << Communicator::get_rank() << ".weights";
+
+// instances are calibrated in parallel
+#pragma omp critical(stdp_weight_snapshot)
+  {
+    const thread n_threads = network()->get_num_threads();
+    if (data_ == 0 or filename.str() != filename_ or
+        capacity_ != static_cast<size_t>(P_.capacity_) or
+        sections_.size() != static_cast<size_t>(n_threads)) {
+      map_(filename.str(), P_.capacity_, n_threads);
+    }
+
+    sections_[get_thread()].owner_ = this;
+    scan_(get_thread());
+  }
+}
+
+/* ----------------------------------------------------------- updates */
+
+void stdpmodule::STDPWeightSnapshot::update(Time const &origin,
+                                            const long_t from,
+                                            const long_t to) {
+  assert(to >= 0 && (delay)from < Scheduler::get_min_delay());
+  assert(from < to);
+
+  // all instances publish at the end of the same slices
+  const long_t now = origin.get_steps() + to;
+  if (sections_[get_thread()].owner_ != this or now < B_.next_) {
+    return;
+  }
+
+  publish_(get_thread(), Time(Time::step(now)).get_ms());
+  ++S_.n_snapshots_;
+  B_.next_ = (now / V_.interval_steps_ + 1) * V_.interval_steps_;
+}
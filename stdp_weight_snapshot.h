@@ -0,0 +1,176 @@
+//
+//  stdp_weight_snapshot.h
+//  NEST
+//
+//
+
+/* BeginDocumentation
+ Name: stdp_weight_snapshot - Device publishing STDP weights to shared
+ memory during a simulation.
+
+ Description:
+ Every interval, at the end of a min delay slice, each thread copies the
+ weights of its STDP nodes (all models of this module, read in place) and of
+ its stdp_triplet_all_in_one_synapse connections (written through on each of
+ their updates) into a shared memory file <prefix>.<rank>.weights. Another
+ process, e.g. a dashboard, reads it concurrently without pausing the
+ simulation (see ReadSTDPSnapshot in pynest).
+
+ Each thread owns a section of the file with two weight buffers: it writes
+ the inactive one, then flips them under a sequence number which is odd
+ while the flip is in progress. A reader copies the active buffer and
+ retries when the sequence number changed meanwhile. Threads publish the
+ same simulation times, sections of equal time form a consistent snapshot.
+
+ A synapse enters the snapshot once: nodes at the next calibration (i.e. at
+ the start of each Simulate), connections on their first pre-synaptic spike
+ after it, in which case weights set through SetStatus show after their next
+ update. Pruned connections keep their last weight.
+
+ The device is replicated on each thread, only one should be created. The
+ file is created when it is first calibrated and reset when the prefix, the
+ capacity or the number of threads change.
+
+ File layout:
+ header             magic, version, rank, number of threads, capacity
+ section            one per thread: sequence number, time of the snapshot,
+ number of synapses, active buffer, synapses dropped, then capacity keys
+ (source and target gids, target 0 for STDP nodes) and two buffers of
+ capacity weights
+
+ Parameters:
+ prefix             string: path of the file without rank and extension
+ interval           double: time between two snapshots (ms)
+ capacity           int: synapses per thread, further ones are dropped
+
+ States:
+ n_snapshots        int: snapshots published by this instance
+ n_synapses         int: synapses in the section of this instance
+ n_dropped          int: synapses of this thread beyond the capacity
+
+ SeeAlso: stdp_triplet_node, stdp_longterm_node,
+ stdp_triplet_all_in_one_synapse, stdp_statistics
+ */
+
+#ifndef STDP_WEIGHT_SNAPSHOT_H
+#define STDP_WEIGHT_SNAPSHOT_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "nest.h"
+#include "node.h"
+
+namespace stdpmodule {
+using namespace nest;
+
+class STDPWeightSnapshot : public Node {
+
+public:
+  STDPWeightSnapshot();
+  STDPWeightSnapshot(const STDPWeightSnapshot &);
+  ~STDPWeightSnapshot();
+
+  bool has_proxies() const { return false; }
+
+  /**
+   * Record the weight of a connection of a thread. The slot is stored by the
+   * connection, -1 until it enters the snapshot.
+   */
+  static void record(thread t, long_t &slot, nest::index source,
+                     nest::index target, double_t w);
+
+  void get_status(DictionaryDatum &) const;
+  void set_status(const DictionaryDatum &);
+
+private:
+  void init_state_(const Node &proto);
+  void init_buffers_();
+  void calibrate();
+
+  void update(Time const &, const long_t, const long_t);
+
+  /**
+   * Weights of the synapses of one thread.
+   */
+  struct Section_ {
+    const STDPWeightSnapshot *owner_;
+    // slots of connections carry the epoch they were given in
+    long_t epoch_;
+    long_t n_dropped_;
+    // nodes of lower gids were already scanned
+    nest::index scanned_;
+    std::vector<double_t> weights_;
+    std::vector<std::pair<size_t, const double_t *> > nodes_;
+
+    Section_();
+  };
+
+  static long_t assign_(thread, nest::index source, nest::index target);
+  static void map_(const std::string &filename, size_t capacity,
+                   thread n_threads);
+  static void unmap_();
+  static void scan_(thread);
+  static void publish_(thread, double_t time);
+
+  struct Parameters_ {
+    std::string prefix_;
+    double_t interval_;
+    long_t capacity_;
+
+    Parameters_();
+    void get(DictionaryDatum &) const;
+    void set(const DictionaryDatum &);
+  };
+
+  struct State_ {
+    long_t n_snapshots_;
+
+    State_();
+    void get(DictionaryDatum &) const;
+  };
+
+  struct Buffers_ {
+    // step of the next snapshot
+    long_t next_;
+  };
+
+  struct Variables_ {
+    long_t interval_steps_;
+  };
+
+  Parameters_ P_;
+  State_ S_;
+  Variables_ V_;
+  Buffers_ B_;
+
+  static std::vector<Section_> sections_;
+  static char *data_;
+  static size_t size_;
+  static std::string filename_;
+  static size_t capacity_;
+};
+
+inline void STDPWeightSnapshot::record(thread t, long_t &slot,
+                                       nest::index source, nest::index target,
+                                       double_t w) {
+  if (static_cast<size_t>(t) >= sections_.size() or
+      sections_[t].owner_ == 0) {
+    return;
+  }
+
+  Section_ &section = sections_[t];
+  if (slot >> 32 != section.epoch_) {
+    slot = assign_(t, source, target);
+  }
+
+  // slots of dropped connections are out of range
+  const size_t i = slot & 0xffffffffL;
+  if (i < section.weights_.size()) {
+    section.weights_[i] = w;
+  }
+}
+}
+
+#endif /* STDP_WEIGHT_SNAPSHOT_H */
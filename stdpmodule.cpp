@@ -22,6 +22,11 @@
 
 // include necessary NEST headers
 #include "config.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "network.h"
 #include "model.h"
 #include "dynamicloader.h"
@@ -39,7 +44,25 @@
 #include "stdpmodule.h"
 #include "stdp_triplet_connection.h"
 #include "stdp_triplet_node.h"
+#include "stdp_triplet_ensemble_node.h"
 #include "stdp_longterm_node.h"
+#include "stdp_spike_replayer.h"
+#include "stdp_modulator.h"
+#include "stdp_deferred_plasticity.h"
+#include "stdp_weight_snapshot.h"
+#include "stdp_post_hub.h"
+#include "stdp_statistics.h"
+#include "stdp_plasticity.h"
+#include "stdp_memory.h"
+#include "stdp_checkpoint.h"
+#include "stdp_state_loader.h"
+#include "spike_arena.h"
+
+// models generated by codegen/stdp_codegen.py
+// generated includes begin
+#include "stdp_pair_node.h"
+#include "stdp_pair_connection.h"
+// generated includes end
 
 // -- Interface to dynamic module loader ---------------------------------------
 
@@ -85,10 +108,31 @@ void stdpmodule::STDPModule::init(SLIInterpreter *i) {
    The first argument is always a reference to the network.
    */
 
+  // arenas of node buffers, for the threads set now or by OMP_NUM_THREADS
+  size_t n_threads = nest::NestModule::get_network().get_num_threads();
+#ifdef _OPENMP
+  n_threads = std::max(n_threads, static_cast<size_t>(omp_get_max_threads()));
+#endif
+  SpikeArena::reserve(n_threads);
+
   nest::register_model<STDPTripletNeuron>(nest::NestModule::get_network(),
                                           "stdp_triplet_node");
+  STDPTripletNeuron::register_stdp_model("stdp_triplet_node");
   nest::register_model<STDPLongNeuron>(nest::NestModule::get_network(),
                                        "stdp_longterm_node");
+  STDPLongNeuron::register_stdp_model("stdp_longterm_node");
+  nest::register_model<STDPSpikeReplayer>(nest::NestModule::get_network(),
+                                          "stdp_spike_replayer");
+  nest::register_model<STDPModulator>(nest::NestModule::get_network(),
+                                      "stdp_modulator");
+  nest::register_model<STDPDeferredPlasticity>(nest::NestModule::get_network(),
+                                               "stdp_deferred_plasticity");
+  nest::register_model<STDPWeightSnapshot>(nest::NestModule::get_network(),
+                                           "stdp_weight_snapshot");
+  nest::register_model<STDPPostHub>(nest::NestModule::get_network(),
+                                    "stdp_post_hub");
+  nest::register_model<STDPTripletEnsemble>(nest::NestModule::get_network(),
+                                            "stdp_triplet_ensemble_node");
 
   /* Register a synapse type.
    Give synapse type as template argument and the name as second argument.
@@ -106,4 +150,150 @@ void stdpmodule::STDPModule::init(SLIInterpreter *i) {
   nest::register_connection_model<
       STDPTripletConnection<nest::TargetIdentifierPtrRport> >(
       nest::NestModule::get_network(), "stdp_triplet_all_in_one_synapse");
+  STDPTripletConnection<nest::TargetIdentifierPtrRport>::register_stdp_model(
+      "stdp_triplet_all_in_one_synapse");
+
+  /* Register the models generated from rule descriptions by
+   codegen/stdp_codegen.py.
+   */
+
+  // generated models begin
+  nest::register_model<STDPPairNeuron>(
+      nest::NestModule::get_network(), "stdp_pair_node");
+  STDPPairNeuron::register_stdp_model("stdp_pair_node");
+  nest::register_connection_model<
+      STDPPairConnection<nest::TargetIdentifierPtrRport> >(
+      nest::NestModule::get_network(), "stdp_pair_synapse");
+  STDPPairConnection<nest::TargetIdentifierPtrRport>::register_stdp_model(
+      "stdp_pair_synapse");
+  // generated models end
+
+  /* Register the SLI functions of the module.
+   */
+
+  i->createcommand("SetSTDPStatistics_D", &setstdpstatistics_dfunction);
+  i->createcommand("GetSTDPStatistics", &getstdpstatisticsfunction);
+  i->createcommand("ResetSTDPStatistics", &resetstdpstatisticsfunction);
+  i->createcommand("SetSTDPPlasticity_D", &setstdpplasticity_dfunction);
+  i->createcommand("GetSTDPPlasticity", &getstdpplasticityfunction);
+  i->createcommand("GetSTDPMemory", &getstdpmemoryfunction);
+  i->createcommand("STDPCheckpoint_s", &stdpcheckpoint_sfunction);
+  i->createcommand("STDPRestore_s", &stdprestore_sfunction);
+  i->createcommand("SetSTDPStates_a_a_s", &setstdpstates_a_a_sfunction);
+  i->createcommand("SetSTDPStates_a_a_Vd", &setstdpstates_a_a_vdfunction);
+}
+
+// -- SLI functions ------------------------------------------------------------
+
+static std::vector<Name> get_names(const TokenArray &keys) {
+  std::vector<Name> names(keys.size());
+  for (size_t k = 0; k < keys.size(); ++k) {
+    names[k] = Name(getValue<std::string>(keys[k]));
+  }
+  return names;
+}
+
+void stdpmodule::STDPModule::SetSTDPStatistics_DFunction::execute(
+    SLIInterpreter *i) const {
+  i->assert_stack_load(1);
+
+  const DictionaryDatum params = getValue<DictionaryDatum>(i->OStack.pick(0));
+  STDPStatistics::set_status(params);
+
+  i->OStack.pop();
+  i->EStack.pop();
+}
+
+void stdpmodule::STDPModule::GetSTDPStatisticsFunction::execute(
+    SLIInterpreter *i) const {
+  DictionaryDatum statistics(new Dictionary);
+  STDPStatistics::get_status(statistics);
+
+  i->OStack.push(statistics);
+  i->EStack.pop();
+}
+
+void stdpmodule::STDPModule::ResetSTDPStatisticsFunction::execute(
+    SLIInterpreter *i) const {
+  STDPStatistics::reset();
+  i->EStack.pop();
+}
+
+void stdpmodule::STDPModule::SetSTDPPlasticity_DFunction::execute(
+    SLIInterpreter *i) const {
+  i->assert_stack_load(1);
+
+  const DictionaryDatum params = getValue<DictionaryDatum>(i->OStack.pick(0));
+  STDPPlasticity::set_status(params);
+
+  i->OStack.pop();
+  i->EStack.pop();
+}
+
+void stdpmodule::STDPModule::GetSTDPPlasticityFunction::execute(
+    SLIInterpreter *i) const {
+  DictionaryDatum plasticity(new Dictionary);
+  STDPPlasticity::get_status(plasticity);
+
+  i->OStack.push(plasticity);
+  i->EStack.pop();
+}
+
+void stdpmodule::STDPModule::GetSTDPMemoryFunction::execute(
+    SLIInterpreter *i) const {
+  i->OStack.push(STDPMemory::report());
+  i->EStack.pop();
+}
+
+void stdpmodule::STDPModule::STDPCheckpoint_sFunction::execute(
+    SLIInterpreter *i) const {
+  i->assert_stack_load(1);
+
+  const std::string prefix = getValue<std::string>(i->OStack.pick(0));
+  DictionaryDatum result = STDPCheckpoint::save(prefix);
+
+  i->OStack.pop();
+  i->OStack.push(result);
+  i->EStack.pop();
+}
+
+void stdpmodule::STDPModule::STDPRestore_sFunction::execute(
+    SLIInterpreter *i) const {
+  i->assert_stack_load(1);
+
+  const std::string prefix = getValue<std::string>(i->OStack.pick(0));
+  DictionaryDatum result = STDPCheckpoint::restore(prefix);
+
+  i->OStack.pop();
+  i->OStack.push(result);
+  i->EStack.pop();
+}
+
+void stdpmodule::STDPModule::SetSTDPStates_a_a_sFunction::execute(
+    SLIInterpreter *i) const {
+  i->assert_stack_load(3);
+
+  const TokenArray targets = getValue<TokenArray>(i->OStack.pick(2));
+  const TokenArray keys = getValue<TokenArray>(i->OStack.pick(1));
+  const std::string filename = getValue<std::string>(i->OStack.pick(0));
+
+  STDPStateLoader::set_states(targets, get_names(keys), filename);
+
+  i->OStack.pop(3);
+  i->EStack.pop();
+}
+
+void stdpmodule::STDPModule::SetSTDPStates_a_a_VdFunction::execute(
+    SLIInterpreter *i) const {
+  i->assert_stack_load(3);
+
+  const TokenArray targets = getValue<TokenArray>(i->OStack.pick(2));
+  const TokenArray keys = getValue<TokenArray>(i->OStack.pick(1));
+  const DoubleVectorDatum values =
+      getValue<DoubleVectorDatum>(i->OStack.pick(0));
+
+  STDPStateLoader::set_states(targets, get_names(keys), *values);
+
+  i->OStack.pop(3);
+  i->EStack.pop();
 }
@@ -65,6 +65,104 @@ public:
    * module, in particular, set up type tries for functions you have defined.
    */
   const std::string commandstring(void) const;
+
+public:
+  // SLI functions ------------------------------------------------
+
+  /**
+   * Configure and enable the weight statistics.
+   * @param dict statistics settings, see stdp_statistics.h
+   */
+  class SetSTDPStatistics_DFunction : public SLIFunction {
+  public:
+    void execute(SLIInterpreter *) const;
+  } setstdpstatistics_dfunction;
+
+  /**
+   * Merge the weight statistics of all threads.
+   * @return dict settings and one statistics dictionary per model
+   */
+  class GetSTDPStatisticsFunction : public SLIFunction {
+  public:
+    void execute(SLIInterpreter *) const;
+  } getstdpstatisticsfunction;
+
+  /**
+   * Drop the weight statistics accumulated so far.
+   */
+  class ResetSTDPStatisticsFunction : public SLIFunction {
+  public:
+    void execute(SLIInterpreter *) const;
+  } resetstdpstatisticsfunction;
+
+  /**
+   * Set the global plasticity toggle and the schedules of the models.
+   * @param dict plasticity settings, see stdp_plasticity.h
+   */
+  class SetSTDPPlasticity_DFunction : public SLIFunction {
+  public:
+    void execute(SLIInterpreter *) const;
+  } setstdpplasticity_dfunction;
+
+  /**
+   * Get the global plasticity toggle and the schedules of the models.
+   * @return dict plasticity settings
+   */
+  class GetSTDPPlasticityFunction : public SLIFunction {
+  public:
+    void execute(SLIInterpreter *) const;
+  } getstdpplasticityfunction;
+
+  /**
+   * Report the memory used by the STDP models on this rank.
+   * @return dict usage per model, history, total and sizes
+   */
+  class GetSTDPMemoryFunction : public SLIFunction {
+  public:
+    void execute(SLIInterpreter *) const;
+  } getstdpmemoryfunction;
+
+  /**
+   * Write the plasticity state of this rank to <prefix>.<rank>.stdp.
+   * @param string file prefix
+   * @return dict records written and simulation time
+   */
+  class STDPCheckpoint_sFunction : public SLIFunction {
+  public:
+    void execute(SLIInterpreter *) const;
+  } stdpcheckpoint_sfunction;
+
+  /**
+   * Restore the plasticity state of this rank from <prefix>.<rank>.stdp.
+   * @param string file prefix
+   * @return dict records restored and checkpoint simulation time
+   */
+  class STDPRestore_sFunction : public SLIFunction {
+  public:
+    void execute(SLIInterpreter *) const;
+  } stdprestore_sfunction;
+
+  /**
+   * Set plastic states of nodes or connections from a .npy file.
+   * @param array targets, node GIDs or connections
+   * @param array state keys
+   * @param string path to the .npy file
+   */
+  class SetSTDPStates_a_a_sFunction : public SLIFunction {
+  public:
+    void execute(SLIInterpreter *) const;
+  } setstdpstates_a_a_sfunction;
+
+  /**
+   * Set plastic states of nodes or connections from a row-major array.
+   * @param array targets, node GIDs or connections
+   * @param array state keys
+   * @param doublevector values
+   */
+  class SetSTDPStates_a_a_VdFunction : public SLIFunction {
+  public:
+    void execute(SLIInterpreter *) const;
+  } setstdpstates_a_a_vdfunction;
 };
 } // namespace stdpmodule
 
@@ -50,6 +50,78 @@ const Name Kminus("Kminus");
 const Name Kminus_triplet("Kminus_triplet");
 
 const Name nearest_spike("nearest_spike");
+
+const Name enabled("enabled");
+const Name histogram("histogram");
+const Name histogram_bins("histogram_bins");
+const Name histogram_min("histogram_min");
+const Name histogram_max("histogram_max");
+const Name n("n");
+const Name mean("mean");
+const Name variance("variance");
+const Name min_observed("min_observed");
+const Name max_observed("max_observed");
+const Name n_at_Wmin("n_at_Wmin");
+const Name n_at_Wmax("n_at_Wmax");
+const Name n_updates("n_updates");
+
+const Name n_nodes("n_nodes");
+const Name n_connections("n_connections");
+const Name time("time");
+
+const Name filename("filename");
+const Name n_events("n_events");
+const Name position("position");
+const Name n_dropped("n_dropped");
+
+const Name prune_threshold("prune_threshold");
+const Name prune_time("prune_time");
+const Name active("active");
+const Name t_depressed("t_depressed");
+const Name last_offset("last_offset");
+const Name n_pruned("n_pruned");
+
+const Name plastic("plastic");
+const Name plasticity_subsampling("plasticity_subsampling");
+
+const Name bytes("bytes");
+const Name bytes_per_instance("bytes_per_instance");
+const Name history("history");
+const Name n_entries("n_entries");
+const Name sizes("sizes");
+const Name histentry("histentry");
+const Name spike_slot("spike_slot");
+const Name precise_spike("precise_spike");
+const Name arena("arena");
+const Name bytes_used("bytes_used");
+const Name n_blocks("n_blocks");
+
+const Name rate_based("rate_based");
+const Name rate_interval("rate_interval");
+const Name rate_tau("rate_tau");
+const Name rate_pre("rate_pre");
+const Name rate_post("rate_post");
+const Name rate_covariance("rate_covariance");
+
+const Name region("region");
+const Name tau_c("tau_c");
+const Name tau_d("tau_d");
+const Name baseline("baseline");
+const Name eligibility("eligibility");
+const Name modulator("modulator");
+
+const Name prefix("prefix");
+const Name interval("interval");
+const Name capacity("capacity");
+const Name n_snapshots("n_snapshots");
+const Name n_synapses("n_synapses");
+
+const Name hub("hub");
+const Name aggregation_delay("aggregation_delay");
+const Name n_post_spikes("n_post_spikes");
+
+const Name member("member");
+const Name n_members("n_members");
 }
 
 #endif /* stdpnames_h */
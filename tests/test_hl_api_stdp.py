@@ -0,0 +1,235 @@
+import nest
+import glob
+import os
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "pynest"))
+from hl_api_stdp import HelloSTDP
+
+@nest.check_stack
+class STDPApiTestCase(unittest.TestCase):
+    """Check the functions added to nest by HelloSTDP."""
+
+    @classmethod
+    def setUpClass(self):
+        HelloSTDP()
+
+    def setUp(self):
+        nest.set_verbosity('M_WARNING')
+        nest.ResetKernel()
+
+        self.neurons = nest.Create("parrot_neuron", 2)
+        self.detector = nest.Create("spike_detector")
+
+    def recorded(self):
+        """Return the spikes of the detector as sorted (gid, time) pairs."""
+        events = nest.GetStatus(self.detector, "events")[0]
+        return sorted(zip(events["senders"], [round(t, 6) for t in events["times"]]))
+
+    def expected(self, spikes):
+        """Return given spikes of each neuron index as sorted (gid, time) pairs."""
+        return sorted((self.neurons[i], t) for i, times in spikes.items() for t in times)
+
+    def test_spikesDeliveredAtTheirTimes(self):
+        """Check that spikes of nest.Spikes reach their neurons at their times."""
+
+        nest.Connect(self.neurons, self.detector)
+        spikes = { 0: [2.0, 3.5, 7.2, 7.3], 1: [5.0, 9.9] }
+        for i, times in spikes.items():
+            nest.Spikes(self.neurons[i:i + 1], times)
+        nest.STDPSimulate(12.0)
+
+        self.assertEqual(self.recorded(), self.expected(spikes))
+
+    def test_spikesWithinMinDelayDelivered(self):
+        """Check that spikes due before the replayer can read ahead are delivered."""
+
+        nest.Connect(self.neurons, self.detector, syn_spec = { "delay": 5.0 })
+        spikes = { 0: [0.2, 1.0, 4.9, 5.0], 1: [5.1, 9.8, 12.0] }
+        for i, times in spikes.items():
+            nest.Spikes(self.neurons[i:i + 1], times)
+        nest.STDPSimulate(15.0)
+
+        self.assertEqual(self.recorded(), self.expected(spikes))
+
+    def test_spikesAcrossSimulateCalls(self):
+        """Check that spikes given between and across simulations are all delivered once."""
+
+        nest.Connect(self.neurons, self.detector, syn_spec = { "delay": 2.0 })
+        spikes = { 0: [3.0, 8.0], 1: [2.7, 4.0, 6.3] }
+        nest.Spikes(self.neurons[:1], spikes[0])
+        nest.STDPSimulate(2.5)
+        nest.Spikes(self.neurons[1:], spikes[1])
+        nest.STDPSimulate(2.6)
+        nest.Spikes(self.neurons[:1], [5.5, 8.0])
+        nest.STDPSimulate(10.0)
+
+        spikes[0] += [5.5, 8.0]
+        self.assertEqual(self.recorded(), self.expected(spikes))
+
+    def test_spikesReuseDevicesAndRemoveFiles(self):
+        """Check that one replayer and one generator per neuron serve all simulations, files removed."""
+
+        nest.Connect(self.neurons, self.detector, syn_spec = { "delay": 2.0 })
+        files = set(glob.glob(os.path.join(tempfile.gettempdir(), "*.spikes")))
+        size = nest.GetKernelStatus("network_size")
+        spikes = { 0: [], 1: [] }
+        for start in [0.0, 10.0, 20.0]:
+            for i in spikes:
+                times = [start + 1.0 + i, start + 8.0 + i]
+                nest.Spikes(self.neurons[i:i + 1], times)
+                spikes[i] += times
+            nest.STDPSimulate(10.0)
+            self.assertEqual(set(glob.glob(os.path.join(tempfile.gettempdir(), "*.spikes"))), files)
+
+        # a replayer and a generator per neuron
+        self.assertEqual(nest.GetKernelStatus("network_size"), size + 1 + len(self.neurons))
+        self.assertEqual(self.recorded(), self.expected(spikes))
+
+    def test_resetKernelDropsPendingSpikes(self):
+        """Check that nest.ResetKernel drops spikes not yet delivered."""
+
+        nest.Spikes(self.neurons, [3.0, 20.0])
+        nest.STDPSimulate(1.0)
+        nest.ResetKernel()
+
+        self.neurons = nest.Create("parrot_neuron", 2)
+        self.detector = nest.Create("spike_detector")
+        nest.Connect(self.neurons, self.detector)
+        nest.STDPSimulate(25.0)
+        self.assertEqual(self.recorded(), [])
+
+        nest.Spikes(self.neurons[:1], [30.0])
+        nest.STDPSimulate(10.0)
+        self.assertEqual(self.recorded(), self.expected({ 0: [30.0] }))
+
+    def test_invalidSpikesThrowExceptions(self):
+        """Check that spikes in the past or to invalid nodes are errors."""
+
+        nest.Connect(self.neurons, self.detector)
+        nest.STDPSimulate(5.0)
+        self.assertRaisesRegexp(nest.NESTError, "later than", nest.Spikes, self.neurons, [4.0])
+        self.assertRaisesRegexp(nest.NESTError, "later than", nest.Spikes, self.neurons, [5.1])
+
+        nest.Spikes((1000,), [20.0])
+        self.assertRaisesRegexp(nest.NESTError, "UnknownNode", nest.STDPSimulate, 20.0)
+
+        nest.ResetKernel()
+        self.detector = nest.Create("spike_detector")
+        nest.Spikes(self.detector, [20.0])
+        self.assertRaisesRegexp(nest.NESTError, "not a neuron", nest.STDPSimulate, 20.0)
+
+    def test_defaultConnectSharesOneNodePerPost(self):
+        """Check that all_to_all shares one synapse node per post neuron, round-robin placed without spares."""
+
+        size = nest.GetKernelStatus("network_size")
+        synapses = nest.Connect(self.neurons, self.neurons, model = "stdp_triplet_node")
+
+        self.assertEqual(len(synapses), 2)
+        self.assertEqual(nest.GetKernelStatus("network_size"), size + 2)
+        for synapse, post in zip(synapses, self.neurons):
+            self.assertEqual(sorted(nest.GetStatus(nest.GetConnections(target = (synapse,)), "source")),
+                             sorted(self.neurons + (post,))) # pre-synaptic neurons and post-synaptic feedback
+            self.assertEqual(nest.GetStatus(nest.GetConnections((synapse,)), "target"), (post,))
+
+    def test_perPairConnectCreatesOneNodePerPair(self):
+        """Check that per_pair creates one synapse node per pre/post pair."""
+
+        size = nest.GetKernelStatus("network_size")
+        synapses = nest.Connect(self.neurons, self.neurons, model = "stdp_triplet_node", per_pair = True)
+
+        self.assertEqual(len(synapses), 4)
+        self.assertEqual(nest.GetKernelStatus("network_size"), size + 4)
+        self.assertEqual([nest.GetStatus(nest.GetConnections((synapse,)), "target")[0] for synapse in synapses],
+                         [self.neurons[0], self.neurons[0], self.neurons[1], self.neurons[1]])
+
+    def test_placedNodesOnPostVirtualProcess(self):
+        """Check that placed synapse nodes share the virtual process of their post neuron, spares inactive."""
+
+        nest.ResetKernel() # threads are set before nodes are created
+        try:
+            nest.SetKernelStatus({ "local_num_threads": 2 })
+        except nest.NESTError:
+            self.skipTest("NEST is built without threads")
+
+        pre = nest.Create("parrot_neuron", 4)
+        post = nest.Create("parrot_neuron", 1) # skewed fan-in onto one virtual process
+        size = nest.GetKernelStatus("network_size")
+        synapses = nest.Connect(pre, post, model = "stdp_triplet_node", placement = "post", per_pair = True)
+
+        self.assertEqual(nest.GetStatus(synapses, "vp"), nest.GetStatus(post, "vp") * len(pre))
+        self.assertEqual(nest.GetStatus(synapses, "active"), (True,) * len(pre))
+
+        spares = [gid for gid in range(size, nest.GetKernelStatus("network_size")) if gid not in synapses]
+        self.assertEqual(len(spares), len(pre))
+        self.assertEqual(nest.GetStatus(spares, "active"), (False,) * len(spares))
+
+    def test_freezeNodes(self):
+        """Check that nest.FreezeSTDP replaces active STDP nodes by static connections."""
+
+        pre = nest.Create("parrot_neuron", 2)
+        post = nest.Create("parrot_neuron", 2)
+        synapses = nest.Connect(pre, post, "one_to_one", syn_spec = { "axonal_delay": 1.0, "dendritic_delay": 2.0 },
+                                model = "stdp_triplet_node", syn_post_spec = { "receptor_type": 1 })
+        nest.SetStatus(synapses[:1], { "weight": 4.5 })
+        nest.SetStatus(synapses[1:], { "active": False }) # pruned
+        nest.FreezeSTDP(synapses)
+
+        static = nest.GetConnections(pre, post, synapse_model = "static_synapse")
+        self.assertEqual(nest.GetStatus(static, ["source", "target", "weight", "delay", "receptor"]),
+                         ((pre[0], post[0], 4.5, 3.0, 1),))
+        self.assertEqual(nest.GetStatus(synapses, "active"), (False, False))
+
+    def test_freezeNodesOfHub(self):
+        """Check that nest.FreezeSTDP connects nodes of a stdp_post_hub to the neuron of the hub."""
+
+        pre = nest.Create("parrot_neuron", 2)
+        post = nest.Create("iaf_psc_alpha")
+        hub = nest.Create("stdp_post_hub", params = { "aggregation_delay": 1.0 })
+        synapses = nest.Create("stdp_triplet_node", 2, params = { "hub": hub[0] })
+        nest.Connect(pre, synapses, "one_to_one", { "delay": 0.5 })
+        nest.SetStatus(synapses, [{ "weight": 2.0 }, { "weight": 3.0 }])
+
+        # nodes would be lost without the connection of their hub
+        self.assertRaisesRegexp(nest.NESTError, "no connection", nest.FreezeSTDP, synapses)
+
+        nest.Connect(hub, post, syn_spec = { "delay": 1.5 })
+        nest.FreezeSTDP(synapses)
+
+        static = nest.GetConnections(pre, post, synapse_model = "static_synapse")
+        self.assertEqual(sorted(nest.GetStatus(static, ["source", "target", "weight", "delay"])),
+                         [(pre[0], post[0], 2.0, 3.0), (pre[1], post[0], 3.0, 3.0)])
+        self.assertEqual(nest.GetStatus(synapses, "active"), (False, False))
+
+    def test_freezeConnections(self):
+        """Check that nest.FreezeSTDP replaces active STDP connections by static connections."""
+
+        pre = nest.Create("parrot_neuron", 2)
+        post = nest.Create("parrot_neuron", 2)
+        nest.Connect(pre, post, "one_to_one", {
+            "model": "stdp_triplet_all_in_one_synapse",
+            "delay": 1.5,
+            "receptor_type": 1,
+        })
+        synapses = nest.GetConnections(pre, synapse_model = "stdp_triplet_all_in_one_synapse")
+        nest.SetStatus(synapses[:1], { "weight": 2.5 })
+        nest.SetStatus(synapses[1:], { "active": False }) # pruned
+        nest.FreezeSTDP(synapses)
+
+        static = nest.GetConnections(pre, post, synapse_model = "static_synapse")
+        self.assertEqual(nest.GetStatus(static, ["source", "target", "weight", "delay", "receptor"]),
+                         ((pre[0], post[0], 2.5, 1.5, 1),))
+        self.assertEqual(nest.GetStatus(synapses, "active"), (False, False))
+
+def suite():
+    suite1 = unittest.TestLoader().loadTestsFromTestCase(STDPApiTestCase)
+    return unittest.TestSuite([suite1])
+
+def run():
+    runner = unittest.TextTestRunner(verbosity = 2)
+    return runner.run(suite()).wasSuccessful()
+
+if __name__ == "__main__":
+    sys.exit(0 if run() else 1)
@@ -0,0 +1,162 @@
+import nest
+import os
+import subprocess
+import sys
+import unittest
+from math import exp
+
+@nest.check_stack
+class STDPPairModelsTestCase(unittest.TestCase):
+    """Check models generated from codegen/rules/stdp_pair.json."""
+
+    @classmethod
+    def setUpClass(self):
+        nest.Install("stdpmodule")
+
+    def setUp(self):
+        nest.set_verbosity('M_WARNING')
+        nest.ResetKernel()
+
+        # settings
+        self.dendritic_delay = 1.0
+        self.tau_plus = 16.8
+        self.tau_minus = 33.7
+        self.syn_spec = {
+            "weight": 5.0,
+            "Wmin": 0.0,
+            "Wmax": 100.0,
+            "Aplus": 0.1,
+            "Aminus": 0.1,
+        }
+
+        self.pre_neuron = nest.Create("parrot_neuron")
+        self.post_neuron = nest.Create("parrot_neuron")
+
+    def generateSpikes(self, neuron, times):
+        """Trigger spike to given neuron at specified times."""
+        delay = 1.0
+        gen = nest.Create("spike_generator", 1, { "spike_times": [t - delay for t in times] })
+        nest.Connect(gen, neuron, syn_spec = { "delay": delay })
+
+    def pairing(self, dendritic_delay):
+        """Expected weight after a pre-post pairing followed by a post-pre one."""
+        weight = self.syn_spec["weight"]
+        Kplus = 1.0 # pre at 2.0
+        weight += self.syn_spec["Aplus"] * Kplus * exp(- (2.0 + dendritic_delay) / self.tau_plus) # post at 4.0
+        Kminus = 1.0
+        weight -= self.syn_spec["Aminus"] * Kminus * exp(- (3.0 - dendritic_delay) / self.tau_minus) # pre at 7.0
+        return weight
+
+    def assertAlmostEqualDetailed(self, expected, given, message):
+        """Improve assetAlmostEqual with detailed message."""
+        messageWithValues = "%s (expected: `%s` was: `%s`" % (message, str(expected), str(given))
+        self.assertAlmostEqual(given, expected, msg = messageWithValues)
+
+    def test_generatedFilesUpToDate(self):
+        """Check that generated models match their rules."""
+        root = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+        rules = os.path.join(root, "codegen", "rules")
+        command = [sys.executable, os.path.join(root, "codegen", "stdp_codegen.py"), "--check"]
+        command += sorted(os.path.join(rules, rule) for rule in os.listdir(rules) if rule.endswith(".json"))
+        self.assertEqual(0, subprocess.call(command, cwd = root), "generated files should be regenerated")
+
+    def test_badPropertiesSetupsThrowExceptions(self):
+        """Check that exceptions are thrown when setting bad parameters."""
+        bad_syn_spec = self.syn_spec.copy()
+        bad_syn_spec.update({ "Wmin": 200.0 })
+        self.assertRaisesRegexp(nest.NESTError, "BadProperty", nest.Create, "stdp_pair_node", params = bad_syn_spec)
+
+    def test_synapseWeightChangeWhenPairing(self):
+        """Check the pair rule of stdp_pair_synapse."""
+        syn_spec = self.syn_spec.copy()
+        syn_spec.update({ "model": "stdp_pair_synapse", "delay": self.dendritic_delay, "receptor_type": 1 })
+        nest.Connect(self.pre_neuron, self.post_neuron, syn_spec = syn_spec)
+
+        self.generateSpikes(self.pre_neuron, [2.0, 7.0])
+        self.generateSpikes(self.post_neuron, [4.0])
+        nest.Simulate(20.0)
+
+        connection = nest.GetConnections(self.pre_neuron, synapse_model = "stdp_pair_synapse")
+        self.assertAlmostEqualDetailed(self.pairing(self.dendritic_delay), nest.GetStatus(connection, "weight")[0], "weight should follow the pair rule")
+
+    def test_nodeWeightChangeWhenPairing(self):
+        """Check the pair rule of stdp_pair_node."""
+        pair_synapse = nest.Create("stdp_pair_node", params = self.syn_spec)
+        nest.Connect(self.pre_neuron, pair_synapse)
+        nest.Connect(pair_synapse, self.post_neuron, syn_spec = {
+            "receptor_type": 1,
+            "delay": self.dendritic_delay
+        })
+        nest.Connect(self.post_neuron, pair_synapse, syn_spec = { "receptor_type": 1 })
+
+        self.generateSpikes(self.pre_neuron, [2.0, 7.0])
+        self.generateSpikes(self.post_neuron, [4.0])
+        nest.Simulate(20.0)
+
+        self.assertAlmostEqualDetailed(self.pairing(0.0), nest.GetStatus(pair_synapse, "weight")[0], "weight should follow the pair rule")
+
+    def test_generatedModelsFollowSchedules(self):
+        """Check that generated models keep their weights outside of their learning windows and feed statistics."""
+        pair_synapse = nest.Create("stdp_pair_node", params = self.syn_spec)
+        nest.Connect(self.pre_neuron, pair_synapse)
+        nest.Connect(self.post_neuron, pair_synapse, syn_spec = { "receptor_type": 1 })
+        syn_spec = self.syn_spec.copy()
+        syn_spec.update({ "model": "stdp_pair_synapse", "delay": self.dendritic_delay, "receptor_type": 1 })
+        nest.Connect(self.pre_neuron, self.post_neuron, syn_spec = syn_spec)
+        connection = nest.GetConnections(self.pre_neuron, synapse_model = "stdp_pair_synapse")
+
+        self.generateSpikes(self.pre_neuron, [2.0, 7.0])
+        self.generateSpikes(self.post_neuron, [4.0])
+
+        windows = { "stdp_pair_node": [100.0, 200.0], "stdp_pair_synapse": [100.0, 200.0] }
+        nest.sli_func("SetSTDPPlasticity", windows)
+        nest.sli_func("SetSTDPStatistics", { "enabled": True })
+        try:
+            nest.Simulate(20.0)
+            stats = nest.sli_func("GetSTDPStatistics")
+        finally:
+            nest.sli_func("SetSTDPPlasticity", { "stdp_pair_node": [], "stdp_pair_synapse": [] })
+            nest.sli_func("SetSTDPStatistics", { "enabled": False })
+
+        weight = self.syn_spec["weight"]
+        self.assertAlmostEqualDetailed(weight, nest.GetStatus(pair_synapse, "weight")[0], "node weight should be kept")
+        self.assertAlmostEqualDetailed(weight, nest.GetStatus(connection, "weight")[0], "synapse weight should be kept")
+        self.assertEqual(1, stats["stdp_pair_node"]["n"])
+        self.assertEqual(0, stats["stdp_pair_node"]["n_updates"])
+
+    def test_depressedGeneratedModelsArePruned(self):
+        """Check that generated models staying at the pruning threshold get pruned."""
+        prune = { "prune_threshold": self.syn_spec["weight"], "prune_time": 3.0 }
+        params = self.syn_spec.copy()
+        params.update(prune)
+        pair_synapse = nest.Create("stdp_pair_node", params = params)
+        nest.Connect(self.pre_neuron, pair_synapse)
+        syn_spec = params.copy()
+        syn_spec.update({ "model": "stdp_pair_synapse", "delay": self.dendritic_delay, "receptor_type": 1 })
+        nest.Connect(self.pre_neuron, self.post_neuron, syn_spec = syn_spec)
+        connection = nest.GetConnections(self.pre_neuron, synapse_model = "stdp_pair_synapse")
+        nest.sli_func("ResetSTDPStatistics")
+
+        self.generateSpikes(self.pre_neuron, [2.0, 7.0])
+
+        nest.Simulate(2.0)
+        self.assertTrue(nest.GetStatus(pair_synapse, "active")[0])
+
+        nest.Simulate(8.0)
+        self.assertFalse(nest.GetStatus(pair_synapse, "active")[0])
+        self.assertFalse(nest.GetStatus(connection, "active")[0])
+
+        stats = nest.sli_func("GetSTDPStatistics")
+        self.assertEqual(1, stats["stdp_pair_node"]["n_pruned"])
+        self.assertEqual(1, stats["stdp_pair_synapse"]["n_pruned"])
+
+def suite():
+    suite1 = unittest.TestLoader().loadTestsFromTestCase(STDPPairModelsTestCase)
+    return unittest.TestSuite([suite1])
+
+def run():
+    runner = unittest.TextTestRunner(verbosity = 2)
+    return runner.run(suite()).wasSuccessful()
+
+if __name__ == "__main__":
+    sys.exit(0 if run() else 1)
@@ -0,0 +1,220 @@
+import json
+import os
+import random
+import sys
+import time
+import unittest
+from math import exp
+
+import nest
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "benchmarks"))
+import brunnel
+import feedforward
+
+baseline_path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "performance_baseline.json")
+
+approaches = { 1: "static", 2: "standard", 3: "STDPNode" }
+stdp_models = { 2: "stdp_triplet_all_in_one_synapse", 3: "stdp_triplet_node" }
+
+# time constants of the benchmarks, amplitudes and bounds of the unit tests so that weights move
+rule = {
+    "tau_plus": 16.8,
+    "tau_plus_triplet": 101.0,
+    "tau_minus": 33.7,
+    "tau_minus_triplet": 125.0,
+    "Aplus": 0.1,
+    "Aminus": 0.1,
+    "Aplus_triplet": 0.1,
+    "Aminus_triplet": 0.1,
+    "weight": 5.0,
+    "Wmin": 0.0,
+    "Wmax": 100.0,
+}
+
+class PerformanceTestCase(unittest.TestCase):
+    """Check events per second of fixed-seed benchmark networks against a stored baseline, and the
+    weights of the triplet rule against the pairings of test_triplet_node.py and
+    test_triplet_connection.py.
+
+    Set STDP_UPDATE_BASELINE=1 to record the baseline of this machine instead of comparing against
+    it, STDP_PERF_TOLERANCE to override the tolerance of the baseline file. A measure without a
+    baseline fails, which is why the gate runs from make check-performance and not make check.
+    """
+
+    repetitions = 3
+
+    @classmethod
+    def setUpClass(self):
+        nest.set_verbosity('M_WARNING')
+        with open(baseline_path) as f:
+            self.baseline = json.load(f)
+        self.tolerance = float(os.environ.get("STDP_PERF_TOLERANCE", self.baseline["tolerance"]))
+        self.update = os.environ.get("STDP_UPDATE_BASELINE") == "1"
+        self.measured = {}
+
+    @classmethod
+    def tearDownClass(self):
+        if self.update:
+            for network, results in self.measured.items():
+                self.baseline["events_per_second"].setdefault(network, {}).update(results)
+            with open(baseline_path, "w") as f:
+                json.dump(self.baseline, f, indent = 2, sort_keys = True)
+                f.write("\n")
+
+    def measure(self, network, config, build, synapses_per_neuron, simtime):
+        """Build and simulate a network, check that its synapses were updated and return its best events
+        per second."""
+
+        best = 0.0
+        for repetition in range(self.repetitions):
+            random.seed(1234)
+            neurons, _ = build()
+            nest.SetKernelStatus({ "print_time": False })
+            detector = nest.Create("spike_detector", params = { "to_memory": False })
+            nest.Connect(neurons, detector)
+            nest.sli_func("SetSTDPStatistics", { "enabled": True })
+
+            start = time.time()
+            nest.Simulate(simtime)
+            elapsed = time.time() - start
+
+            events = nest.GetStatus(detector, "n_events")[0] * synapses_per_neuron
+            best = max(best, events / elapsed)
+
+            if config in stdp_models:
+                statistics = nest.sli_func("GetSTDPStatistics")[stdp_models[config]]
+                self.assertGreater(statistics["n"], 0, "synapses should have been updated")
+
+        self.measured.setdefault(network, {})[approaches[config]] = best
+        if self.update:
+            return
+
+        reference = self.baseline["events_per_second"].get(network, {}).get(approaches[config])
+        if reference is None:
+            self.fail("%s %s: no baseline in %s, record it with make update-performance-baseline" % (
+                network, approaches[config], baseline_path))
+
+        self.assertGreaterEqual(best, (1.0 - self.tolerance) * reference,
+                                "%s %s: %.0f events/s regressed from baseline %.0f events/s" % (
+                                    network, approaches[config], best, reference))
+
+    def brunnel(self, config):
+        order = 50
+        synapses_per_neuron = int(0.1 * 4 * order) + int(0.1 * order)
+        self.measure("brunnel", config, lambda: brunnel.build(config, order), synapses_per_neuron, 200.0)
+
+    def feedforward(self, config):
+        elements = 200
+        self.measure("feedforward", config, lambda: feedforward.build(config, 0.1, elements, threads = 1), 1, 200.0)
+
+    def decay(self, time, Kplus, Kplus_triplet, Kminus, Kminus_triplet):
+        """Decay variables."""
+        Kplus *= exp(- time / rule["tau_plus"])
+        Kplus_triplet *= exp(- time / rule["tau_plus_triplet"])
+        Kminus *= exp(- time / rule["tau_minus"])
+        Kminus_triplet *= exp(- time / rule["tau_minus_triplet"])
+        return (Kplus, Kplus_triplet, Kminus, Kminus_triplet)
+
+    def facilitate(self, w, Kplus, Kminus_triplet):
+        """Facilitate weight."""
+        return w + Kplus * (rule["Aplus"] + rule["Aplus_triplet"] * Kminus_triplet)
+
+    def depress(self, w, Kminus, Kplus_triplet):
+        """Depress weight."""
+        return w - Kminus * (rule["Aminus"] + rule["Aminus_triplet"] * Kplus_triplet)
+
+    def generateSpikes(self, neuron, times):
+        """Trigger spike to given neuron at specified times."""
+        delay = 1.0
+        gen = nest.Create("spike_generator", 1, { "spike_times": [t - delay for t in times] })
+        nest.Connect(gen, neuron, syn_spec = { "delay": delay })
+
+    def assertAlmostEqualDetailed(self, expected, given, message):
+        """Improve assetAlmostEqual with detailed message."""
+        messageWithValues = "%s (expected: `%s` was: `%s`" % (message, str(expected), str(given))
+        self.assertAlmostEqual(given, expected, msg = messageWithValues)
+
+    def test_nodeWeightFollowsRule(self):
+        """Check the weight of stdp_triplet_node after a pre-post pairing (test_triplet_node.py)."""
+
+        nest.ResetKernel()
+        pre = nest.Create("parrot_neuron")
+        post = nest.Create("parrot_neuron")
+        params = dict(rule, nearest_spike = False)
+        synapse = nest.Create("stdp_triplet_node", params = params)
+        nest.Connect(pre, synapse)
+        nest.Connect(synapse, post, syn_spec = { "receptor_type": 1, "delay": 1.0 })
+        nest.Connect(post, synapse, syn_spec = { "receptor_type": 1 })
+        self.generateSpikes(pre, [2.0])
+        self.generateSpikes(post, [4.0])
+
+        (Kplus, Kplus_triplet, Kminus, Kminus_triplet) = self.decay(2.0, 0.0, 0.0, 0.0, 0.0)
+        weight = self.depress(rule["weight"], Kminus, Kplus_triplet)
+        Kplus += 1.0
+        Kplus_triplet += 1.0
+        (Kplus, Kplus_triplet, Kminus, Kminus_triplet) = self.decay(2.0, Kplus, Kplus_triplet, Kminus, Kminus_triplet)
+        weight = self.facilitate(weight, Kplus, Kminus_triplet)
+
+        nest.Simulate(20.0)
+        self.assertAlmostEqualDetailed(weight, nest.GetStatus(synapse, "weight")[0], "weight should follow the rule")
+
+    def test_connectionWeightFollowsRule(self):
+        """Check the weight of stdp_triplet_all_in_one_synapse after a pre-post-pre triplet
+        (test_triplet_connection.py)."""
+
+        dendritic_delay = 1.0
+        nest.ResetKernel()
+        pre = nest.Create("parrot_neuron")
+        post = nest.Create("parrot_neuron")
+        syn_spec = dict(rule, model = "stdp_triplet_all_in_one_synapse", delay = dendritic_delay, receptor_type = 1)
+        nest.Connect(pre, post, syn_spec = syn_spec)
+        self.generateSpikes(pre, [2.0, 6.0])
+        self.generateSpikes(post, [4.0])
+
+        (Kplus, Kplus_triplet, Kminus, Kminus_triplet) = self.decay(2.0, 0.0, 0.0, 0.0, 0.0)
+        weight = self.depress(rule["weight"], Kminus, Kplus_triplet)
+        Kplus += 1.0
+        Kplus_triplet += 1.0
+        (Kplus, Kplus_triplet, Kminus, Kminus_triplet) = self.decay(2.0 + dendritic_delay, Kplus, Kplus_triplet,
+                                                                    Kminus, Kminus_triplet)
+        weight = self.facilitate(weight, Kplus, Kminus_triplet)
+        Kminus += 1.0
+        Kminus_triplet += 1.0
+        (Kplus, Kplus_triplet, Kminus, Kminus_triplet) = self.decay(2.0 - dendritic_delay, Kplus, Kplus_triplet,
+                                                                    Kminus, Kminus_triplet)
+        weight = self.depress(weight, Kminus, Kplus_triplet)
+
+        nest.Simulate(20.0)
+        connection = nest.GetConnections(pre, synapse_model = "stdp_triplet_all_in_one_synapse")
+        self.assertAlmostEqualDetailed(weight, nest.GetStatus(connection, "weight")[0], "weight should follow the rule")
+
+    def test_brunnelStatic(self):
+        self.brunnel(1)
+
+    def test_brunnelStandard(self):
+        self.brunnel(2)
+
+    def test_brunnelSTDPNode(self):
+        self.brunnel(3)
+
+    def test_feedforwardStatic(self):
+        self.feedforward(1)
+
+    def test_feedforwardStandard(self):
+        self.feedforward(2)
+
+    def test_feedforwardSTDPNode(self):
+        self.feedforward(3)
+
+
+def suite():
+    suite1 = unittest.TestLoader().loadTestsFromTestCase(PerformanceTestCase)
+    return unittest.TestSuite([suite1])
+
+def run():
+    runner = unittest.TextTestRunner(verbosity = 2)
+    return runner.run(suite()).wasSuccessful()
+
+if __name__ == "__main__":
+    sys.exit(0 if run() else 1)
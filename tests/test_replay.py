@@ -0,0 +1,120 @@
+import nest
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import unittest
+
+root = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+@nest.check_stack
+class STDPReplayTestCase(unittest.TestCase):
+    """Check that stdp-replay (replay/stdp_replay.cpp) ends with the weights of the simulation."""
+
+    @classmethod
+    def setUpClass(self):
+        nest.Install("stdpmodule")
+
+    def setUp(self):
+        self.replay = os.environ.get("STDP_REPLAY", os.path.join(root, "stdp-replay"))
+        if not os.path.exists(self.replay):
+            self.skipTest("stdp-replay is not built (make stdp-replay)")
+
+        nest.set_verbosity('M_WARNING')
+        nest.ResetKernel()
+        nest.SetKernelStatus({ "resolution": 0.1, "grng_seed": 1234, "rng_seeds": [1235] })
+
+        # settings
+        self.duration = 2000.0
+        self.delay = 1.5
+
+        # parrots driven by their own Poisson generators, STDP inputs on port 1 are not repeated
+        self.pre = nest.Create("parrot_neuron", 4)
+        self.post = nest.Create("parrot_neuron", 3)
+        for neuron in self.pre + self.post:
+            drive = nest.Create("poisson_generator", params = { "rate": 20.0 })
+            nest.Connect(drive, (neuron,))
+
+        self.detector = nest.Create("spike_detector")
+        nest.Connect(self.pre + self.post, self.detector)
+
+        self.directory = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.directory)
+
+    def replayed(self, pairs, arguments):
+        """Write the recorded spikes and the pairs, return the replayed weight of each pair."""
+        events = nest.GetStatus(self.detector, "events")[0]
+        spikes = os.path.join(self.directory, "spikes.gdf")
+        with open(spikes, "w") as f:
+            for gid, time in zip(events["senders"], events["times"]):
+                f.write("%d %r\n" % (gid, time))
+
+        connections = os.path.join(self.directory, "connections.txt")
+        with open(connections, "w") as f:
+            for source, target in pairs:
+                f.write("%d %d 1.0 %r\n" % (source, target, self.delay))
+
+        weights = os.path.join(self.directory, "weights.txt")
+        subprocess.check_call([self.replay, "--spikes", spikes, "--connections", connections,
+                               "--weights", weights] + arguments)
+        with open(weights) as f:
+            return [float(line.split()[2]) for line in f]
+
+    def test_tripletReplayMatchesConnections(self):
+        """Check the replay of stdp_triplet_all_in_one_synapse."""
+        syn_spec = {
+            "model": "stdp_triplet_all_in_one_synapse",
+            "delay": self.delay,
+            "receptor_type": 1,
+            "weight": 1.0,
+            "Aplus": 5e-3,
+            "Aminus": 7e-3,
+            "Aplus_triplet": 6e-3,
+            "Aminus_triplet": 2e-4,
+        }
+        nest.Connect(self.pre, self.post, syn_spec = syn_spec)
+        nest.Simulate(self.duration)
+
+        connections = nest.GetConnections(self.pre, synapse_model = "stdp_triplet_all_in_one_synapse")
+        pairs = [(c[0], c[1]) for c in connections]
+        options = ["--rule", "triplet"]
+        for name in ["Aplus", "Aminus", "Aplus_triplet", "Aminus_triplet"]:
+            options += ["--set", "%s=%r" % (name, syn_spec[name])]
+
+        expected = nest.GetStatus(connections, "weight")
+        for pair, weight, replayed in zip(pairs, expected, self.replayed(pairs, options)):
+            self.assertAlmostEqual(weight, replayed, places = 9, msg = "weight of %s should be replayed" % (pair,))
+
+    def test_longtermReplayMatchesNodes(self):
+        """Check the replay of stdp_longterm_node, with subsampled slow variables."""
+        pairs = []
+        nodes = ()
+        for source in self.pre:
+            for target in self.post:
+                node = nest.Create("stdp_longterm_node", params = { "plasticity_subsampling": 5 })
+                nest.Connect((source,), node, syn_spec = { "delay": 0.1 })
+                nest.Connect(node, (target,), syn_spec = { "delay": self.delay, "receptor_type": 1 })
+                nest.Connect((target,), node, syn_spec = { "delay": self.delay, "receptor_type": 1 })
+                pairs.append((source, target))
+                nodes += node
+        nest.Simulate(self.duration)
+
+        options = ["--rule", "longterm", "--pre-delay", "0.1", "--until", repr(self.duration),
+                   "--set", "plasticity_subsampling=5"]
+        expected = nest.GetStatus(nodes, "weight")
+        for pair, weight, replayed in zip(pairs, expected, self.replayed(pairs, options)):
+            self.assertAlmostEqual(weight, replayed, places = 9, msg = "weight of %s should be replayed" % (pair,))
+
+def suite():
+    suite1 = unittest.TestLoader().loadTestsFromTestCase(STDPReplayTestCase)
+    return unittest.TestSuite([suite1])
+
+def run():
+    runner = unittest.TextTestRunner(verbosity = 2)
+    return runner.run(suite()).wasSuccessful()
+
+if __name__ == "__main__":
+    sys.exit(0 if run() else 1)
@@ -1,4 +1,7 @@
 import nest
+import os
+import sys
+import tempfile
 import unittest
 from math import exp
 
@@ -91,6 +94,13 @@ class STDPTripletConnectionTestCase(unittest.TestCase):
         badPropertyWith("Kplus_triplet", { "Kplus_triplet": -1.0 })
         badPropertyWith("Kminus", { "Kminus": -1.0 })
         badPropertyWith("Kminus_triplet", { "Kminus_triplet": -1.0 })
+        badPropertyWith("Wmax", { "Wmin": 200.0 })
+
+    def test_boundsReadBack(self):
+        """Check that weight bounds are read back as set."""
+        self.assertAlmostEqualDetailed(self.syn_spec["Wmin"], self.status("Wmin"), "Wmin should be read back")
+        self.assertAlmostEqualDetailed(self.syn_spec["Wmax"], self.status("Wmax"), "Wmax should be read back")
+        self.assertIsInstance(self.status("Wmin"), float)
 
     def test_varsZeroAtStart(self):
         """Check that pre and post-synaptic variables are zero at start."""
@@ -282,13 +292,127 @@ class STDPTripletConnectionTestCase(unittest.TestCase):
         nest.Simulate(20.0)
         self.assertAlmostEqualDetailed(limited_weight, self.status("weight"), "weight should have been limited")
 
+    def test_gatedConnectionCatchesTracesUp(self):
+        """Check that post-synaptic spikes skipped while gated off still count in traces once plastic."""
+
+        self.generateSpikes(self.pre_neuron, [2.0, 6.0, 12.0, 16.0])
+        self.generateSpikes(self.post_neuron, [4.0, 14.0])
+
+        # pre-synaptic spikes at their times, post-synaptic ones after the dendritic delay
+        events = [(2.0, "pre"), (6.0, "pre"), (12.0, "pre"), (16.0, "pre")] + \
+                 [(t + self.dendritic_delay, "post") for t in [4.0, 14.0]]
+        weight = self.status("weight")
+        (Kplus, Kplus_triplet, Kminus, Kminus_triplet) = (0.0, 0.0, 0.0, 0.0)
+        t_last = 0.0
+        for t, spike in sorted(events):
+            (Kplus, Kplus_triplet, Kminus, Kminus_triplet) = self.decay(t - t_last, Kplus, Kplus_triplet,
+                                                                        Kminus, Kminus_triplet)
+            t_last = t
+            if spike == "pre":
+                if t >= 10.0:
+                    weight = self.depress(weight, Kminus, Kplus_triplet)
+                Kplus += 1.0
+                Kplus_triplet += 1.0
+            else:
+                if t >= 10.0:
+                    weight = self.facilitate(weight, Kplus, Kminus_triplet)
+                Kminus += 1.0
+                Kminus_triplet += 1.0
+
+        nest.sli_func("SetSTDPPlasticity", { self.synapse_model: [10.0, 1000.0] })
+        try:
+            nest.Simulate(20.0)
+        finally:
+            nest.sli_func("SetSTDPPlasticity", { self.synapse_model: [] })
+
+        self.assertAlmostEqualDetailed(weight, self.status("weight"), "weight should only change inside the window")
+        self.assertAlmostEqualDetailed(Kminus, self.status("Kminus"), "Kminus should have followed spikes")
+
+    def test_revivedConnectionSkipsPrunedHistory(self):
+        """Check that a revived connection ignores post-synaptic spikes of the time it was pruned."""
+
+        connections = nest.GetConnections(self.pre_neuron, synapse_model = self.synapse_model)
+        nest.SetStatus(connections, { "active": False })
+        self.generateSpikes(self.pre_neuron, [2.0, 6.0])
+        self.generateSpikes(self.post_neuron, [4.0])
+        nest.Simulate(10.0)
+
+        weight = self.status("weight")
+        self.assertAlmostEqualDetailed(self.syn_spec["weight"], weight, "pruned connection should not update")
+
+        nest.SetStatus(connections, { "active": True })
+        self.generateSpikes(self.pre_neuron, [12.0])
+        self.generateSpikes(self.post_neuron, [14.0])
+        self.generateSpikes(self.pre_neuron, [16.0]) # trigger computation
+
+        Kplus = 1.0
+        Kplus_triplet = 1.0
+        Kminus = 0.0
+        Kminus_triplet = 0.0
+
+        (Kplus, Kplus_triplet, Kminus, Kminus_triplet) = self.decay(2.0 + self.dendritic_delay, Kplus, Kplus_triplet,
+                                                                    Kminus, Kminus_triplet)
+        weight = self.facilitate(weight, Kplus, Kminus_triplet)
+        Kminus += 1.0
+        Kminus_triplet += 1.0
+
+        (Kplus, Kplus_triplet, Kminus, Kminus_triplet) = self.decay(2.0 - self.dendritic_delay, Kplus, Kplus_triplet,
+                                                                    Kminus, Kminus_triplet)
+        weight = self.depress(weight, Kminus, Kplus_triplet)
+
+        nest.Simulate(20.0)
+        self.assertAlmostEqualDetailed(weight, self.status("weight"), "revived connection should only see new spikes")
+
+    def test_checkpointRestoresState(self):
+        """Check that a checkpoint restores weight, traces and pruning state of connections."""
+
+        connections = nest.GetConnections(self.pre_neuron, synapse_model = self.synapse_model)
+        nest.SetStatus(connections, { "prune_threshold": 1000.0, "prune_time": 100.0 }) # depressed, not pruned
+        self.generateSpikes(self.pre_neuron, [2.0, 6.0])
+        self.generateSpikes(self.post_neuron, [4.0])
+        nest.Simulate(10.0)
+
+        keys = ["weight", "Kplus", "Kplus_triplet", "Kminus", "Kminus_triplet", "t_depressed", "last_offset"]
+        expected = [self.status(key) for key in keys]
+        self.assertGreaterEqual(self.status("t_depressed"), 0.0, "connection should be depressed")
+
+        prefix = os.path.join(tempfile.mkdtemp(), "checkpoint")
+        saved = nest.sli_func("STDPCheckpoint", prefix)
+        nest.SetStatus(connections, dict([(key, 0.5) for key in keys], active = False))
+        restored = nest.sli_func("STDPRestore", prefix)
+        os.remove(prefix + ".0.stdp")
+
+        self.assertEqual(1, saved["n_connections"])
+        self.assertEqual(1, restored["n_connections"])
+        self.assertTrue(self.status("active"), "active should be restored")
+        for key, value in zip(keys, expected):
+            self.assertAlmostEqualDetailed(value, self.status(key), "%s should be restored" % key)
+
+    def test_deferredPlasticityMatchesInline(self):
+        """Check that updates deferred to the end of slices give the weight of inline ones."""
+
+        weights = []
+        for deferred in [False, True]:
+            self.setUp()
+            if deferred:
+                batch = nest.Create("stdp_deferred_plasticity")
+
+            self.generateSpikes(self.pre_neuron, [2.0, 7.0, 9.0, 15.0, 21.0])
+            self.generateSpikes(self.post_neuron, [4.0, 8.0, 13.0, 22.0])
+
+            nest.Simulate(30.0)
+            weights.append(self.status("weight"))
+
+        self.assertAlmostEqualDetailed(weights[0], weights[1], "deferred weight should match inline weight")
+        self.assertEqual(5, nest.GetStatus(batch, "n_updates")[0])
+
 def suite():
     suite1 = unittest.TestLoader().loadTestsFromTestCase(STDPTripletConnectionTestCase)
     return unittest.TestSuite([suite1])
 
 def run():
     runner = unittest.TextTestRunner(verbosity = 2)
-    runner.run(suite())
+    return runner.run(suite()).wasSuccessful()
 
 if __name__ == "__main__":
-    run()
\ No newline at end of file
+    sys.exit(0 if run() else 1)
\ No newline at end of file
@@ -1,7 +1,14 @@
 import nest
+import numpy as np
+import os
+import sys
+import tempfile
 import unittest
 from math import exp
 
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "pynest"))
+from hl_api_stdp import ReadSTDPSnapshot
+
 @nest.check_stack
 class STDPTripletNeuronTestCase(unittest.TestCase):
     """Check stdp_triplet_node model properties."""
@@ -207,6 +214,89 @@ class STDPTripletNeuronTestCase(unittest.TestCase):
         nest.Simulate(20.0)
         self.assertAlmostEqualDetailed(weight, self.status("weight"), "weight should have decreased")
 
+    def test_subsamplingKeepsSpikeTiming(self):
+        """Check that a coarser plasticity grid gives the same weight change."""
+
+        nest.SetStatus(self.triplet_synapse, params = { "plasticity_subsampling": 7 })
+
+        self.generateSpikes(self.pre_neuron, [2.0])
+        self.generateSpikes(self.post_neuron, [4.0])
+
+        weight = self.status("weight")
+        (Kplus, Kplus_triplet, Kminus, Kminus_triplet) = self.decay(2.0, 0.0, 0.0, 0.0, 0.0)
+        weight = self.depress(weight, Kminus, Kplus_triplet)
+        (Kplus, Kplus_triplet, Kminus, Kminus_triplet) = self.decay(2.0, Kplus + 1.0, Kplus_triplet + 1.0, Kminus, Kminus_triplet)
+        weight = self.facilitate(weight, Kplus, Kminus_triplet)
+
+        nest.Simulate(20.0)
+        self.assertAlmostEqualDetailed(weight, self.status("weight"), "weight should not depend on subsampling")
+        self.assertAlmostEqualDetailed(self.decay(15.0, 0.0, 0.0, 1.0, 1.0)[2], self.status("Kminus"),
+                                       "Kminus should have decayed exactly")
+
+    def test_subsamplingKeepsRecordedTraces(self):
+        """Check that traces are recorded at every step with a coarser plasticity grid."""
+
+        nest.SetStatus(self.triplet_synapse, params = { "plasticity_subsampling": 7 })
+        reference = nest.Create("stdp_triplet_node", params = self.syn_spec)
+        nest.Connect(self.pre_neuron, reference)
+        nest.Connect(self.post_neuron, reference, syn_spec = { "receptor_type": 1 })
+
+        recordables = ["Kplus", "Kplus_triplet", "Kminus", "Kminus_triplet"]
+        resolution = nest.GetKernelStatus("resolution")
+        meters = nest.Create("multimeter", 2, params = { "record_from": recordables, "interval": resolution })
+        nest.Connect(meters[:1], self.triplet_synapse)
+        nest.Connect(meters[1:], reference)
+
+        self.generateSpikes(self.pre_neuron, [2.0])
+        self.generateSpikes(self.post_neuron, [4.0])
+        nest.Simulate(20.0)
+
+        (subsampled, exact) = nest.GetStatus(meters, "events")
+        for name in recordables:
+            self.assertTrue(np.allclose(subsampled[name], exact[name]), "%s should be recorded exactly" % name)
+
+    def test_preciseTimesAtCoarseResolution(self):
+        """Check that precise spikes give the exact weight change off the grid."""
+
+        nest.ResetKernel()
+        nest.SetKernelStatus({ "resolution": 1.0 })
+
+        self.pre_neuron = nest.Create("parrot_neuron_ps")
+        self.post_neuron = nest.Create("parrot_neuron_ps")
+        self.triplet_synapse = nest.Create("stdp_triplet_node", params = self.syn_spec)
+        nest.SetStatus(self.triplet_synapse, { "precise_times": True })
+
+        nest.Connect(self.pre_neuron, self.triplet_synapse)
+        nest.Connect(self.triplet_synapse, self.post_neuron, syn_spec = { "receptor_type": 1 })
+        nest.Connect(self.post_neuron, self.triplet_synapse, syn_spec = { "receptor_type": 1 })
+
+        for neuron, times in [(self.pre_neuron, [2.3]), (self.post_neuron, [4.6])]:
+            gen = nest.Create("spike_generator", 1, { "spike_times": [t - 1.0 for t in times], "precise_times": True })
+            nest.Connect(gen, neuron, syn_spec = { "delay": 1.0 })
+
+        weight = self.status("weight")
+        (Kplus, Kplus_triplet, Kminus, Kminus_triplet) = self.decay(2.3, 0.0, 0.0, 0.0, 0.0)
+        weight = self.depress(weight, Kminus, Kplus_triplet)
+        (Kplus, Kplus_triplet, Kminus, Kminus_triplet) = self.decay(2.3, Kplus + 1.0, Kplus_triplet + 1.0, Kminus, Kminus_triplet)
+        weight = self.facilitate(weight, Kplus, Kminus_triplet)
+
+        nest.Simulate(20.0)
+        self.assertAlmostEqualDetailed(weight, self.status("weight"), "weight should follow the exact spike times")
+
+    def test_rateBasedFollowsRates(self):
+        """Check that the rate-based mode estimates rates and only drifts with both pre and post activity."""
+
+        nest.SetStatus(self.triplet_synapse, params = { "rate_based": True, "rate_interval": 10.0, "rate_tau": 10.0 })
+        self.generateSpikes(self.pre_neuron, np.arange(2.0, 200.0, 10.0))
+
+        weight = self.status("weight")
+        nest.Simulate(200.0)
+
+        self.assertAlmostEqualDetailed(weight, self.status("weight"), "weight should not drift without post spikes")
+        self.assertGreater(self.status("rate_pre"), 0.0, "pre-synaptic rate should have been estimated")
+        self.assertEqual(0.0, self.status("rate_post"))
+        self.assertRaises(nest.NESTError, nest.SetStatus, self.triplet_synapse, { "precise_times": True })
+
     def test_weightChangeWhenPrePostPreSpikes(self):
         """Check that weight changes whenever a pre-post-pre spike triplet happen."""
 
@@ -270,6 +360,300 @@ class STDPTripletNeuronTestCase(unittest.TestCase):
         nest.Simulate(2.0)
         self.assertAlmostEqualDetailed(limited_weight, self.status("weight"), "weight should have been limited")
 
+    def test_gatedPlasticityKeepsWeight(self):
+        """Check that weight is kept and traces follow spikes while plasticity is off."""
+
+        self.generateSpikes(self.pre_neuron, [2.0])
+        self.generateSpikes(self.post_neuron, [4.0])
+
+        weight = self.status("weight")
+        (Kplus, Kplus_triplet, _, _) = self.decay(17.0, 1.0, 1.0, 0.0, 0.0)
+        (_, _, Kminus, Kminus_triplet) = self.decay(15.0, 0.0, 0.0, 1.0, 1.0)
+
+        nest.sli_func("SetSTDPPlasticity", { "plastic": False })
+        try:
+            nest.Simulate(20.0)
+        finally:
+            nest.sli_func("SetSTDPPlasticity", { "plastic": True })
+
+        self.assertAlmostEqualDetailed(weight, self.status("weight"), "weight should be kept")
+        self.assertAlmostEqualDetailed(Kplus, self.status("Kplus"), "Kplus should have followed spikes")
+        self.assertAlmostEqualDetailed(Kplus_triplet, self.status("Kplus_triplet"), "Kplus_triplet should have followed spikes")
+        self.assertAlmostEqualDetailed(Kminus, self.status("Kminus"), "Kminus should have followed spikes")
+        self.assertAlmostEqualDetailed(Kminus_triplet, self.status("Kminus_triplet"), "Kminus_triplet should have followed spikes")
+
+    def test_depressedSynapseIsPruned(self):
+        """Check that a synapse staying at the pruning threshold gets pruned."""
+
+        weight = self.status("weight")
+        nest.SetStatus(self.triplet_synapse, params = { "prune_threshold": weight, "prune_time": 3.0 })
+        nest.sli_func("ResetSTDPStatistics")
+
+        self.generateSpikes(self.pre_neuron, [10.0])
+
+        nest.Simulate(2.0)
+        self.assertTrue(self.status("active"))
+
+        nest.Simulate(2.0)
+        self.assertFalse(self.status("active"))
+
+        nest.Simulate(10.0)
+        self.assertAlmostEqualDetailed(weight, self.status("weight"), "pruned synapse should not update")
+        self.assertAlmostEqualDetailed(0.0, self.status("Kplus"), "pruned synapse should ignore spikes")
+        self.assertEqual(1, nest.sli_func("GetSTDPStatistics")["stdp_triplet_node"]["n_pruned"])
+
+    def test_statisticsFollowWeight(self):
+        """Check that weight statistics follow the weight of the synapse."""
+
+        nest.sli_func("SetSTDPStatistics", { "enabled": True, "histogram_bins": 10, "histogram_max": 10.0 })
+
+        weight = self.status("weight")
+        self.generateSpikes(self.pre_neuron, [2.0])
+        self.generateSpikes(self.post_neuron, [4.0])
+
+        nest.Simulate(20.0)
+        stats = nest.sli_func("GetSTDPStatistics")["stdp_triplet_node"]
+        nest.sli_func("SetSTDPStatistics", { "enabled": False })
+
+        self.assertEqual(1, stats["n"])
+        self.assertEqual(2, stats["n_updates"])
+        self.assertAlmostEqualDetailed(self.status("weight"), stats["mean"], "mean should be the weight")
+        self.assertAlmostEqualDetailed(0.0, stats["variance"], "variance should be zero")
+        self.assertAlmostEqualDetailed(weight, stats["min_observed"], "initial weight should be the smallest observed")
+        self.assertAlmostEqualDetailed(self.status("weight"), stats["max_observed"], "potentiated weight should be the largest observed")
+        self.assertEqual(1, stats["histogram"][int(self.status("weight"))])
+
+    def test_modulatedWeightFollowsSignal(self):
+        """Check that a modulated node keeps the changes of its rule eligible until the signal of its region."""
+
+        nest.SetStatus(self.triplet_synapse, { "region": 0, "tau_c": 100.0 })
+        modulator = nest.Create("stdp_modulator", params = { "region": 0, "tau_d": 50.0 })
+        dopamine = nest.Create("parrot_neuron")
+        nest.Connect(dopamine, modulator)
+
+        self.generateSpikes(self.pre_neuron, [2.0])
+        self.generateSpikes(self.post_neuron, [4.0])
+
+        weight = self.status("weight")
+        nest.Simulate(20.0)
+        self.assertAlmostEqualDetailed(weight, self.status("weight"), "weight should wait for the signal")
+        self.assertGreater(self.status("eligibility"), 0.0, "pairing should have been eligible")
+
+        self.generateSpikes(dopamine, [30.0])
+        nest.Simulate(50.0)
+        self.assertGreater(self.status("weight"), weight, "signal should have potentiated the weight")
+        self.assertEqual(1, nest.GetStatus(modulator, "n_events")[0])
+        self.assertRaises(nest.NESTError, nest.SetStatus, self.triplet_synapse, { "rate_based": True })
+
+    def test_prunedNodeSkipsModulation(self):
+        """Check that a pruned node skips the signal until revived and that modulators keep two min delays."""
+
+        nest.SetStatus(self.triplet_synapse, { "region": 0, "tau_c": 100.0 })
+        modulator = nest.Create("stdp_modulator", params = { "region": 0, "tau_d": 50.0, "history": 100.0 })
+        dopamine = nest.Create("parrot_neuron")
+        nest.Connect(dopamine, modulator)
+
+        self.generateSpikes(self.pre_neuron, [2.0])
+        self.generateSpikes(self.post_neuron, [4.0])
+        nest.Simulate(20.0)
+        weight = self.status("weight")
+        eligibility = self.status("eligibility")
+
+        # the pulse is trimmed from the history before the node is revived
+        nest.SetStatus(self.triplet_synapse, { "active": False })
+        self.generateSpikes(dopamine, [30.0])
+        nest.Simulate(280.0)
+        self.assertAlmostEqualDetailed(weight, self.status("weight"), "pruned node should not follow the signal")
+
+        nest.SetStatus(self.triplet_synapse, { "active": True })
+        self.assertAlmostEqualDetailed(weight, self.status("weight"), "revived node should skip the signal")
+        self.assertAlmostEqualDetailed(eligibility * exp(-280.0 / 100.0), self.status("eligibility"),
+                                       "eligibility should only decay")
+
+        nest.SetStatus(modulator, { "history": 1.0 })
+        self.assertRaisesRegexp(nest.NESTError, "twice the min delay", nest.Simulate, 1.0)
+
+    def test_snapshotHoldsWeightsOfBothApproaches(self):
+        """Check that the shared memory snapshot holds the weights of nodes and connections."""
+
+        prefix = os.path.join(tempfile.mkdtemp(), "weights")
+        snapshot = nest.Create("stdp_weight_snapshot", params = { "prefix": prefix, "interval": 1.0 })
+        nest.Connect(self.pre_neuron, self.post_neuron, syn_spec = {
+            "model": "stdp_triplet_all_in_one_synapse",
+            "receptor_type": 1,
+            "weight": 2.0
+        })
+
+        self.generateSpikes(self.pre_neuron, [2.0, 7.0])
+        self.generateSpikes(self.post_neuron, [4.0])
+        nest.Simulate(20.0)
+
+        weights = ReadSTDPSnapshot(prefix + ".0.weights")
+        connection = nest.GetConnections(self.pre_neuron, synapse_model = "stdp_triplet_all_in_one_synapse")
+        self.assertAlmostEqualDetailed(20.0, weights["time"], "snapshot should be the last one")
+        self.assertEqual([self.triplet_synapse[0], self.pre_neuron[0]], list(weights["source"]))
+        self.assertEqual([0, self.post_neuron[0]], list(weights["target"]))
+        self.assertAlmostEqualDetailed(self.status("weight"), weights["weight"][0], "node weight should be published")
+        self.assertAlmostEqualDetailed(nest.GetStatus(connection, "weight")[0], weights["weight"][1],
+                                       "connection weight should be published")
+        self.assertEqual(20, nest.GetStatus(snapshot, "n_snapshots")[0])
+
+    def test_hubSumsOutputOfNodes(self):
+        """Check that a stdp_post_hub delivers the summed output of its nodes at the same times."""
+
+        neuron_spec = { "V_th": 1e6 }
+        direct_post = nest.Create("iaf_psc_delta", params = neuron_spec)
+        hub_post = nest.Create("iaf_psc_delta", params = neuron_spec)
+        hub = nest.Create("stdp_post_hub", params = { "aggregation_delay": 0.5 })
+        nest.Connect(hub, hub_post, syn_spec = { "delay": self.dendritic_delay - 0.5 })
+
+        weights = [1.0, 2.0, 3.0]
+        for post, params in [(direct_post, {}), (hub_post, { "hub": hub[0] })]:
+            for weight in weights:
+                params.update({ "weight": weight })
+                synapse = nest.Create("stdp_triplet_node", params = dict(self.syn_spec, **params))
+                nest.Connect(self.pre_neuron, synapse)
+                if post == direct_post:
+                    nest.Connect(synapse, post, syn_spec = { "delay": self.dendritic_delay })
+
+        self.generateSpikes(self.pre_neuron, [2.0, 7.0])
+        for _ in range(15):
+            nest.Simulate(1.0)
+            self.assertAlmostEqualDetailed(nest.GetStatus(direct_post, "V_m")[0], nest.GetStatus(hub_post, "V_m")[0],
+                                           "post-synaptic potentials should match")
+
+        self.assertEqual(2, nest.GetStatus(hub, "n_events")[0])
+
+    def test_hubSharesPostSpikes(self):
+        """Check that nodes reading post-synaptic spikes from a stdp_post_hub follow the rule."""
+
+        hub = nest.Create("stdp_post_hub", params = { "aggregation_delay": 0.5 })
+        nest.Connect(self.post_neuron, hub, syn_spec = { "delay": 0.5 })
+        hub_synapse = nest.Create("stdp_triplet_node", params = dict(self.syn_spec, hub = hub[0]))
+        nest.Connect(self.pre_neuron, hub_synapse)
+
+        self.generateSpikes(self.pre_neuron, [2.0, 7.0])
+        self.generateSpikes(self.post_neuron, [4.0, 5.0])
+        nest.Simulate(20.0)
+
+        for key in ["weight", "Kplus", "Kplus_triplet", "Kminus", "Kminus_triplet"]:
+            self.assertAlmostEqualDetailed(self.status(key), nest.GetStatus(hub_synapse, key)[0],
+                                           "%s should match the node with its own feedback" % key)
+        self.assertEqual(2, nest.GetStatus(hub, "n_post_spikes")[0])
+
+    def test_memoryAccountsBuffers(self):
+        """Check that the memory report includes the buffers of the node."""
+
+        nest.Simulate(1.0)
+        memory = nest.sli_func("GetSTDPMemory")
+        node = memory["stdp_triplet_node"]
+
+        self.assertEqual(1, node["n"])
+        self.assertGreater(node["bytes"], memory["sizes"]["stdp_triplet_node"])
+        self.assertGreaterEqual(memory["bytes"], node["bytes"])
+
+        # buffers and decay tables are drawn from the arena of the thread
+        self.assertEqual(node["bytes"] - memory["sizes"]["stdp_triplet_node"], memory["arena"]["bytes_used"])
+        self.assertGreaterEqual(memory["arena"]["bytes"], memory["arena"]["bytes_used"])
+
+    def test_checkpointRestoresState(self):
+        """Check that a checkpoint restores weight and traces."""
+
+        self.generateSpikes(self.pre_neuron, [2.0])
+        self.generateSpikes(self.post_neuron, [4.0])
+        nest.Simulate(10.0)
+
+        keys = ["weight", "Kplus", "Kplus_triplet", "Kminus", "Kminus_triplet"]
+        expected = [self.status(key) for key in keys]
+
+        prefix = os.path.join(tempfile.mkdtemp(), "checkpoint")
+        saved = nest.sli_func("STDPCheckpoint", prefix)
+        nest.SetStatus(self.triplet_synapse, params = dict((key, 0.5) for key in keys))
+        restored = nest.sli_func("STDPRestore", prefix)
+        os.remove(prefix + ".0.stdp")
+
+        self.assertEqual(1, saved["n_nodes"])
+        self.assertEqual(1, restored["n_nodes"])
+        for key, value in zip(keys, expected):
+            self.assertAlmostEqualDetailed(value, self.status(key), "%s should be restored" % key)
+
+    def test_checkpointRestoresIntoFreshKernel(self):
+        """Check that states restored into a fresh kernel decay from the restore time."""
+
+        self.generateSpikes(self.pre_neuron, [2.0])
+        self.generateSpikes(self.post_neuron, [4.0])
+        nest.Simulate(10.0)
+
+        keys = ["weight", "Kplus", "Kplus_triplet", "Kminus", "Kminus_triplet"]
+        expected = [self.status(key) for key in keys]
+
+        prefix = os.path.join(tempfile.mkdtemp(), "checkpoint")
+        nest.sli_func("STDPCheckpoint", prefix)
+        self.setUp() # same network at time 0
+        nest.sli_func("STDPRestore", prefix)
+        os.remove(prefix + ".0.stdp")
+
+        for key, value in zip(keys, expected):
+            self.assertAlmostEqualDetailed(value, self.status(key), "%s should be restored" % key)
+
+        nest.Simulate(5.0)
+        decayed = [expected[0]] + list(self.decay(5.0, *expected[1:]))
+        for key, value in zip(keys, decayed):
+            self.assertAlmostEqualDetailed(value, self.status(key), "%s should decay from the restore time" % key)
+
+    def test_bulkStatesAreSet(self):
+        """Check that states are set in bulk from an array and from a npy file."""
+
+        synapses = nest.Create("stdp_triplet_node", 3, params = self.syn_spec)
+        keys = ["weight", "Kplus", "Kminus_triplet"]
+        values = np.arange(9, dtype = np.float64).reshape(3, 3)
+
+        nest.sli_func("SetSTDPStates", list(synapses), keys, values.ravel())
+        self.assertEqual(values.tolist(), [list(s) for s in nest.GetStatus(synapses, keys)])
+
+        path = os.path.join(tempfile.mkdtemp(), "states.npy")
+        np.save(path, (values + 1).astype(np.float32))
+        nest.sli_func("SetSTDPStates", list(synapses), keys, path)
+        os.remove(path)
+        self.assertEqual((values + 1).tolist(), [list(s) for s in nest.GetStatus(synapses, keys)])
+
+    def test_ensembleMatchesNodes(self):
+        """Check that each member of stdp_triplet_ensemble_node follows the node of its parameters."""
+
+        members = {
+            "Aplus": [0.1, 0.05, 0.2],
+            "tau_minus_triplet": [125.0, 60.0, 125.0],
+            "Wmax": [100.0, 100.0, 5.1],
+        }
+        ensemble = nest.Create("stdp_triplet_ensemble_node", params = dict(self.syn_spec, **members))
+        nest.Connect(self.pre_neuron, ensemble)
+        nest.Connect(self.post_neuron, ensemble, syn_spec = { "receptor_type": 1 })
+
+        nodes = ()
+        for k in range(3):
+            node = nest.Create("stdp_triplet_node", params = dict(self.syn_spec, **dict((key, values[k]) for key, values in members.items())))
+            nest.Connect(self.pre_neuron, node)
+            nest.Connect(self.post_neuron, node, syn_spec = { "receptor_type": 1 })
+            nodes += node
+
+        self.generateSpikes(self.pre_neuron, [2.0, 7.0, 12.0])
+        self.generateSpikes(self.post_neuron, [4.0, 5.0, 13.0])
+        nest.Simulate(20.0)
+
+        self.assertEqual(3, nest.GetStatus(ensemble, "n_members")[0])
+        for key in ["weight", "Kplus", "Kplus_triplet", "Kminus", "Kminus_triplet"]:
+            for expected, given in zip(nest.GetStatus(nodes, key), nest.GetStatus(ensemble, key)[0]):
+                self.assertAlmostEqualDetailed(expected, given, "%s of each member should match its node" % key)
+
+    def test_ensembleBadPropertiesThrowExceptions(self):
+        """Check that arrays of an ensemble must be of its size or of a single value."""
+
+        ensemble = nest.Create("stdp_triplet_ensemble_node", params = { "Aplus": [0.1, 0.2, 0.3] })
+        self.assertEqual([0.1, 0.1, 0.1], list(nest.GetStatus(ensemble, "Aminus")[0]))
+
+        for params in [{ "Aminus": [0.1, 0.2] }, { "member": 3 }, { "Wmin": [0.0, 200.0, 0.0] }, { "weight": [1.0, 2.0] }]:
+            self.assertRaisesRegexp(nest.NESTError, "BadProperty", nest.SetStatus, ensemble, params)
+
 
 def suite():
     suite1 = unittest.TestLoader().loadTestsFromTestCase(STDPTripletNeuronTestCase)
@@ -277,7 +661,7 @@ def suite():
 
 def run():
     runner = unittest.TextTestRunner(verbosity = 2)
-    runner.run(suite())
+    return runner.run(suite()).wasSuccessful()
 
 if __name__ == "__main__":
-    run()
+    sys.exit(0 if run() else 1)